@@ -1,20 +1,21 @@
 #include "config.h"
 #include "encoder.h"
 #include "absolute_encoder.h"
-#include "button.h"
+#include "input_scanner.h"
 #include "display.h"
 #include "memory.h"
 #include "stepper.h"
 #include "menu.h"
 #include "start_stop.h"
+#include "position_controller.h"
+#include "encoder_calibration.h"
+#include "scheduler.h"
+#include "profiler.h"
 
 /* ================== ОБʼЄКТИ ================== */
 Encoder encoder(ENC_A, ENC_B);
 AbsoluteEncoder absoluteEncoder(ABS_ENC_PIN, 5.0, 360.0);
-Button button(ENC_BTN, BUTTON_DEBOUNCE_MS);
-Button digitModeButton(DIGIT_MODE_BUTTON_PIN, BUTTON_DEBOUNCE_MS);
-Button encoderZeroButton(ENCODER_ZERO_BUTTON_PIN, BUTTON_DEBOUNCE_MS);  // Кнопка встановлення нуля енкодера
-Button stepFineAdjustButton(STEP_FINE_ADJUST_BUTTON_PIN, BUTTON_DEBOUNCE_MS);  // Кнопка руху на один крок
+InputScanner inputs;  // Усі кнопки: опитування з тактом 1 мс, debounce та черга подій
 
 #if LCD_MODE == 0
   // 4-bit режим
@@ -27,28 +28,79 @@ Button stepFineAdjustButton(STEP_FINE_ADJUST_BUTTON_PIN, BUTTON_DEBOUNCE_MS);  /
 Memory memory(MIN_POS, MAX_POS);
 Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
 Menu menu;
-StartStop startStop(START_STOP_BUTTON_PIN, START_STOP_LED_PIN, BUTTON_DEBOUNCE_MS);
+StartStop startStop(START_STOP_LED_PIN);
+PositionController positionController;  // Корекція позиції за абсолютним енкодером
+EncoderCalibration encoderCalibration(stepper, absoluteEncoder);  // Калібрування нелінійності енкодера
+Scheduler scheduler;  // Задачі loop() з фіксованим тактом
 
 /* ================== ЗМІННІ ================== */
 unsigned long lastDisplayUpdate = 0;
+unsigned long saveMessageTime = 0;  // Коли показано повідомлення про збереження (0 - не показується)
+int16_t pendingFineSteps = 0;  // Кроки від кнопки кроку, ще не передані двигуну
+uint16_t zeroSavedTargetAngle = 0;  // Цільовий кут на час обнулення енкодера
+Settings settings;  // Налаштування з EEPROM (стан і параметри), завантажуються в setup()
+
+// Стан задач між запусками
+int32_t lastTargetPosition = 0;  // Цільова позиція з попереднього запуску taskMotion()
+bool targetChanged = false;  // Ціль змінилася - позиціювання починається заново
+#if CLOSED_LOOP_ENABLED
+bool closedLoopActive = false;  // Регулятор позиції ініціалізовано для поточного старту
+#else
+bool wasMoving = false;  // Гістерезис зупинки за енкодером: двигун рухався до цілі
+int16_t lastAngleDiff = 999;
+#endif
+MenuType lastMenuType = MENU_SPLASH;  // Меню, показане попереднім оновленням екрана
+
+#if SETTINGS_SERIAL_ENABLED
+  #if PROFILER_ENABLED
+    #error "SETTINGS_SERIAL_ENABLED and PROFILER_ENABLED both read commands from Serial"
+  #endif
+char serialLine[16];  // Рядок команди налаштувань, що надходить
+uint8_t serialLength = 0;
+#endif
+
+/* ================== ЗАДАЧІ ================== */
+void applySettings();
+void pollSettingsSerial();
+void taskInput();
+void taskSensing();
+void taskMotion();
+void taskPersistence();
+void taskUi();
 
 /* ================== SETUP ================== */
 void setup() {
+  PROFILE_BEGIN();
   encoder.begin();
   absoluteEncoder.begin();
-  button.begin();
-  digitModeButton.begin();
-  encoderZeroButton.begin();  // Кнопка встановлення нуля енкодера
-  stepFineAdjustButton.begin();  // Кнопка руху на один крок
+  inputs.begin();
   display.begin();
   stepper.begin();
   startStop.begin();
   
-  // Завантажуємо налаштування з пам'яті (позиція, напрямок, нуль енкодера)
-  int32_t savedPosition = 0;
-  uint8_t savedDirection = 0;  // DIR_CW = 0
-  int32_t savedStepperZero = 0;
-  memory.loadSettings(savedPosition, savedDirection, savedStepperZero);
+  // Кнопка кроку утримується при ввімкненні - вимірюємо швидкість дисплея,
+  // результат видно, поки кнопка натиснута
+  if (inputs.isHeld(INPUT_STEP_FINE)) {
+    display.runBenchmark();
+    while (inputs.isHeld(INPUT_STEP_FINE)) {
+      inputs.update();
+    }
+    inputs.clearEvents();
+    display.clear();
+  }
+  
+  // Завантажуємо налаштування з пам'яті (позиція, напрямок, нуль енкодера та параметри)
+  memory.loadSettings(settings);
+  int32_t savedPosition = settings.position;
+  uint8_t savedDirection = settings.direction;
+  int32_t savedStepperZero = settings.stepperZero;
+  
+  // Параметри руху, регулятора, інтерфейсу та фільтра енкодера; меню змінює їх через settings
+  applySettings();
+  menu.setSettings(&settings);
+#if SETTINGS_SERIAL_ENABLED
+  Serial.begin(SETTINGS_SERIAL_BAUD);
+#endif
   
   // Нормалізуємо позицію до діапазону 0-360 градусів перед встановленням
   while (savedPosition < 0) {
@@ -68,209 +120,212 @@ void setup() {
   // Встановлюємо нульову позицію двигуна
   menu.setStepperZeroPosition(savedStepperZero);
   
+  // Завантажуємо таблицю калібрування абсолютного енкодера
+  int16_t calibrationTable[ABS_ENC_CAL_POINTS];
+  if (memory.loadCalibration(calibrationTable, ABS_ENC_CAL_POINTS)) {
+    absoluteEncoder.setCalibration(calibrationTable);
+  }
+  
+  // Кнопка обнулення утримується при ввімкненні - запускаємо калібрування енкодера
+  if (inputs.isHeld(INPUT_ENCODER_ZERO)) {
+    encoderCalibration.start();
+    display.clear();
+  }
+  
   // Встановлюємо початковий цільовий кут з абсолютного енкодера
   uint16_t initialAngle = absoluteEncoder.readAngleInt();
   menu.updateTargetAngle(initialAngle);
   
   // Показуємо початковий екран (сплеш-екран)
-  float initialEncoderAngle = absoluteEncoder.readAngle();
-  display.showSplashScreen(initialEncoderAngle, menu.getTargetAngle(), false, stepper.isEnabled());
+  uint16_t initialEncoderCdeg = absoluteEncoder.readDisplayAngleCdeg();
+  display.showSplashScreen(initialEncoderCdeg, menu.getTargetAngle(), false, stepper.isEnabled());
+  
+  // Задачі loop(): рух має найвищий пріоритет, екран - найнижчий
+  scheduler.addTask(taskMotion, TASK_MOTION_PERIOD_MS, TASK_MOTION_PRIORITY, TASK_MOTION_BUDGET_US);
+  scheduler.addTask(taskInput, TASK_INPUT_PERIOD_MS, TASK_INPUT_PRIORITY, TASK_INPUT_BUDGET_US);
+  scheduler.addTask(taskSensing, TASK_SENSING_PERIOD_MS, TASK_SENSING_PRIORITY, TASK_SENSING_BUDGET_US);
+  scheduler.addTask(taskPersistence, TASK_PERSIST_PERIOD_MS, TASK_PERSIST_PRIORITY, TASK_PERSIST_BUDGET_US);
+  scheduler.addTask(taskUi, TASK_UI_PERIOD_MS, TASK_UI_PRIORITY, TASK_UI_BUDGET_US);
+  scheduler.start();
 }
 
 /* ================== LOOP ================== */
 void loop() {
-  // Читаємо інкрементальний енкодер (для навігації по меню)
-  // Обмежуємо значення для плавної навігації (тільки ±1 за раз)
-  // Примітка: encoderDelta буде обчислено безпосередньо перед використанням
-  int16_t rawDelta = encoder.read();
+  PROFILE_POLL();
+  PROFILE_SCOPE(PROFILE_LOOP);
   
-  // Читаємо абсолютний енкодер P3022-CW360 (встановлює цільовий кут)
-  // Оновлюємо на сплеш-екрані та в інших меню (крім режиму редагування)
-  // НЕ оновлюємо цільовий кут коли двигун рухається (startStop.getState() == true)
-  // updateTargetAngle сам перевіряє прапорець _manualAngleSet
-  if ((menu.getCurrentMenu() == MENU_SPLASH || !menu.isEditingAngle()) && !startStop.getState()) {
-    uint16_t absoluteAngle = absoluteEncoder.readAngleInt();
-    menu.updateTargetAngle(absoluteAngle);
-  }
-  
-  // Перевіряємо кнопки
-  // Для інших меню використовуємо isPressed() з debounce
-  // Але перевіряємо кнопку безпосередньо перед використанням
-  bool digitButtonPressed = digitModeButton.isPressed();
-  
-  // Відстежуємо натискання кнопки енкодера для обнулення позиції (тільки на сплеш-екрані)
-  static unsigned long buttonPressStartTime = 0;
-  static bool buttonWasPressed = false;
-  static bool longPressDetected = false;
-  static bool wasOnSplash = false;
+  // Поза AVR кроки формуються опитуванням - на кожному проході, незалежно від тактів задач
+  // і від калібрування (воно теж рухає двигун)
+  PROFILE_INTERVAL(PROFILE_STEPPER_GAP);
+  stepper.update();
   
-  bool isOnSplash = (menu.getCurrentMenu() == MENU_SPLASH);
+  // Калібрування абсолютного енкодера: поки воно триває, решта логіки не виконується
+  if (encoderCalibration.isActive()) {
+    inputs.update();
+    memory.update();
+    inputs.clearEvents();  // Кнопки під час калібрування ігноруються
+    encoderCalibration.update(millis());
+    
+    if (encoderCalibration.isDone()) {
+      absoluteEncoder.setCalibration(encoderCalibration.getTable());
+      memory.saveCalibration(encoderCalibration.getTable(), ABS_ENC_CAL_POINTS);
+      display.resetSplashScreen();
+      lastDisplayUpdate = 0;
+      scheduler.start();  // Такти задач - від завершення калібрування
+    } else if (millis() - lastDisplayUpdate > settings.lcdUpdateMs) {
+      // Прогрес: "Point NN/NN"
+      uint8_t point = encoderCalibration.getProgress();
+      char progress[12];
+      strcpy_P(progress, PSTR("Point 00/00"));
+      progress[6] += point / 10;
+      progress[7] += point % 10;
+      progress[9] += ABS_ENC_CAL_POINTS / 10;
+      progress[10] += ABS_ENC_CAL_POINTS % 10;
+      display.showMessage(F("Calibrating..."), progress);
+      lastDisplayUpdate = millis();
+    }
+    display.flush();
+    return;
+  }
   
-  // Обробка сплеш-екрану - ВИКОРИСТОВУЄМО ТОЧНО ТУ САМУ ЛОГІКУ, ЩО І В МЕНЮ
-  if (isOnSplash) {
-    // Скидаємо стан при виході з сплеш-екрану і поверненні
-    if (!wasOnSplash) {
-      buttonWasPressed = false;
-      longPressDetected = false;
-      wasOnSplash = true;
-      buttonPressStartTime = 0;
+  // Одна задача за прохід: задача з вищим пріоритетом чекає не довше за один запуск іншої
+  scheduler.run();
+}
+
+/* ================== НАЛАШТУВАННЯ ================== */
+// Параметри з settings - модулям (при старті та після зміни з меню або Serial)
+void applySettings() {
+  stepper.setMotionLimits(settings.maxSpeedSps, settings.accelSps2);
+  positionController.configure(settings.toleranceCdeg, settings.kpPercent, settings.kiPercent,
+                               settings.maxCorrectionSteps);
+  menu.setEncoderAccelerationMax(settings.encoderAccelMax);
+  inputs.setLongPressMs(INPUT_ENCODER_BUTTON, settings.longPressMs);
+  inputs.setDebounceSampleMs(settings.debounceSampleMs);
+  absoluteEncoder.setFilter(settings.filterWindow, settings.filterAlpha);
+}
+
+// Команди налаштувань з Serial (SETTINGS_SERIAL_ENABLED): не блокує, символи накопичуються до кінця рядка
+void pollSettingsSerial() {
+#if SETTINGS_SERIAL_ENABLED
+  while (Serial.available()) {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r') {
+      if (serialLength < sizeof(serialLine) - 1) {
+        serialLine[serialLength++] = c;
+      }
+      continue;
     }
-    
-    // ========== ОБРОБКА КНОПКИ ЕНКОДЕРА ДЛЯ СПЛЕШ-ЕКРАНУ (ТОЧНА КОПІЯ ЛОГІКИ З МЕНЮ) ==========
-    static unsigned long lastDebounceTimeSplash = 0;
-    static bool lastRawStateSplash = HIGH;
-    static bool debouncedStateSplash = HIGH;
-    
-    unsigned long currentTime = millis();
-    bool rawState = digitalRead(ENC_BTN);  // Пряме читання піну (INPUT_PULLUP - LOW = натиснуто)
-    
-    // Простий debounce для визначення стабільного стану
-    if (rawState != lastRawStateSplash) {
-      lastDebounceTimeSplash = currentTime;
+    if (serialLength == 0) {
+      continue;
     }
-    lastRawStateSplash = rawState;
-    
-    // Оновлюємо debounced стан якщо пройшло достатньо часу
-    if (currentTime - lastDebounceTimeSplash > BUTTON_DEBOUNCE_MS) {
-      debouncedStateSplash = rawState;
+    serialLine[serialLength] = '\0';
+    serialLength = 0;
+    
+    char* end;
+    uint8_t tag = (uint8_t)strtoul(serialLine, &end, 16);
+    if (end == serialLine) {
+      Serial.println(F("err"));
+    } else if (*end == '\0') {
+      Serial.println(settings.get(tag));
+    } else if (settings.set(tag, (uint16_t)strtoul(end, nullptr, 10))) {
+      // Settings::set() встановлює біт overridden - значення записується в EEPROM
+      applySettings();
+      memory.saveSettings(settings);
+      Serial.println(F("ok"));
+    } else {
+      Serial.println(F("err"));
     }
-    
-    // Для INPUT_PULLUP: LOW = натиснуто, HIGH = відпущено
-    bool buttonCurrentlyPressed = (debouncedStateSplash == LOW);
-    
-    // Відстежуємо початок натискання кнопки (перехід з false в true)
-    if (buttonCurrentlyPressed && !buttonWasPressed) {
-      // Початок натискання - фіксуємо час
-      buttonPressStartTime = currentTime;
-      buttonWasPressed = true;
-      longPressDetected = false;
+  }
+#endif
+}
+
+/* ================== ЗАДАЧІ ================== */
+// Введення: енкодер меню і кнопки - навігація, старт-стоп, початок обнулення, кнопка кроку
+void taskInput() {
+  PROFILE_SCOPE(PROFILE_INPUT);
+  inputs.update();
+  
+  // Читаємо інкрементальний енкодер (для навігації по меню)
+  // Меню саме обмежує крок для навігації, а при введенні кута враховує всі клацання та швидкість
+  int16_t encoderDelta = encoder.read();
+  uint16_t encoderSpeed = encoder.getSpeed();
+  
+  // Події кнопок (debounce, довге натискання та автоповтор - в InputScanner)
+  bool encoderClick = false;  // Кнопку енкодера відпущено до порогу довгого натискання
+  bool encoderLongPress = false;
+  bool digitButtonPressed = false;
+  bool zeroButtonPressed = false;
+  bool startStopPressed = false;
+  int16_t fineAdjustSteps = 0;  // Натискання та автоповтори кнопки кроку
+  InputEvent event;
+  while (inputs.read(event)) {
+    switch (event.button) {
+      case INPUT_ENCODER_BUTTON:
+        if (event.type == INPUT_EVENT_LONG) {
+          encoderLongPress = true;
+        } else if (event.type == INPUT_EVENT_RELEASE && event.duration < settings.longPressMs) {
+          encoderClick = true;
+        }
+        break;
+      case INPUT_DIGIT_MODE:
+        digitButtonPressed |= (event.type == INPUT_EVENT_PRESS);
+        break;
+      case INPUT_ENCODER_ZERO:
+        zeroButtonPressed |= (event.type == INPUT_EVENT_PRESS);
+        break;
+      case INPUT_STEP_FINE:
+        if (event.type == INPUT_EVENT_PRESS || event.type == INPUT_EVENT_REPEAT) {
+          fineAdjustSteps++;
+        }
+        break;
+      case INPUT_START_STOP:
+        startStopPressed |= (event.type == INPUT_EVENT_PRESS);
+        break;
     }
-    
-    // Перевіряємо довге натискання КОЖНУ ітерацію loop, поки кнопка натиснута
-    if (buttonCurrentlyPressed && buttonWasPressed) {
-      unsigned long pressDuration = currentTime - buttonPressStartTime;
-      
-      // Перевірка довгого натискання (>= 2 секунди)
-      if (pressDuration >= LONG_PRESS_THRESHOLD_MS && !longPressDetected) {
-        // ДОВГЕ НАТИСКАННЯ - перемикаємо утримання двигуна
-        longPressDetected = true;
-        bool currentState = stepper.isEnabled();
-        stepper.setEnabled(!currentState);
-        display.resetSplashScreen();  // Оновлюємо екран
-      }
+  }
+  
+  if (menu.getCurrentMenu() == MENU_SPLASH) {
+    // Довге натискання кнопки енкодера на сплеш-екрані - перемикаємо утримання двигуна
+    if (encoderLongPress) {
+      stepper.setEnabled(!stepper.isEnabled());
+      display.resetSplashScreen();  // Оновлюємо екран
     }
     
-    // Обробка відпускання кнопки (перехід з true в false)
-    if (!buttonCurrentlyPressed && buttonWasPressed) {
-      unsigned long pressDuration = currentTime - buttonPressStartTime;
-      buttonWasPressed = false;
-      
-      // Якщо було довге натискання - не переходимо в меню
-      if (longPressDetected) {
-        longPressDetected = false;
-      } else if (pressDuration < LONG_PRESS_THRESHOLD_MS && pressDuration >= BUTTON_DEBOUNCE_MS) {
-        // Коротке натискання - переходимо в меню
-        menu.handleSplashMenu(true, false); // Перехід в меню
-      }
+    // Коротке натискання - переходимо в меню
+    if (encoderClick) {
+      menu.handleSplashMenu(true, false);
     }
     
     // Обробка кнопки старт-стоп на сплеш-екрані
-    bool startStopPressed = startStop.isPressed();
     if (startStopPressed) {
       startStop.setState(true);
     }
-    
-    // Обробка сплеш-екрану (тільки для старт-стоп, кнопка енкодера обробляється вище)
     menu.handleSplashMenu(false, startStopPressed);
   } else {
-    // Не на сплеш-екрані - скидаємо прапорець
-    wasOnSplash = false;
     // Оновлюємо режим редагування розрядів (тільки в меню Set Angle)
     if (menu.isEditingAngle()) {
       menu.updateDigitMode(digitButtonPressed);
     }
     
-    // Зберігаємо попереднє меню для перевірки зміни
-    static MenuType lastMenu = MENU_SPLASH;
     MenuType currentMenuBefore = menu.getCurrentMenu();
     
-    // ========== ОБРОБКА КНОПКИ ЕНКОДЕРА ДЛЯ МЕНЮ ==========
-    // Використовуємо окрему логіку з прямим читанням піну для стабільності
-    static unsigned long buttonPressStartTimeMenu = 0;
-    static bool buttonWasPressedMenu = false;
-    static bool longPressDetectedMenu = false;
-    static unsigned long lastDebounceTime = 0;
-    static bool lastRawState = HIGH;
-    static bool debouncedState = HIGH;
-    
-    unsigned long currentTime = millis();
-    bool buttonPressedForMenu = false;  // Прапорець короткого натискання для меню
-    
-    // Пряме читання піну (INPUT_PULLUP - LOW = натиснуто)
-    bool rawState = digitalRead(ENC_BTN);
-    
-    // Простий debounce для визначення стабільного стану
-    if (rawState != lastRawState) {
-      lastDebounceTime = currentTime;
-    }
-    lastRawState = rawState;
-    
-    // Оновлюємо debounced стан якщо пройшло достатньо часу
-    if (currentTime - lastDebounceTime > BUTTON_DEBOUNCE_MS) {
-      debouncedState = rawState;
-    }
-    
-    // Для INPUT_PULLUP: LOW = натиснуто, HIGH = відпущено
-    bool buttonCurrentlyPressed = (debouncedState == LOW);
-    
-    // Відстежуємо початок натискання кнопки (перехід з false в true)
-    if (buttonCurrentlyPressed && !buttonWasPressedMenu) {
-      // Початок натискання - фіксуємо час
-      buttonPressStartTimeMenu = currentTime;
-      buttonWasPressedMenu = true;
-      longPressDetectedMenu = false;
-    }
-    
-    // Перевіряємо довге натискання КОЖНУ ітерацію loop, поки кнопка натиснута
-    if (buttonCurrentlyPressed && buttonWasPressedMenu) {
-      unsigned long pressDuration = currentTime - buttonPressStartTimeMenu;
-      
-      // Перевірка довгого натискання (>= 2 секунди)
-      if (pressDuration >= LONG_PRESS_THRESHOLD_MS && !longPressDetectedMenu) {
-        // ДОВГЕ НАТИСКАННЯ - повернення на сплеш-екран
-        longPressDetectedMenu = true;
-        menu.handleLongPress();
-        display.resetSplashScreen();
-        menu.clearResetSplashFlag();
-        lastDisplayUpdate = 0;
-      }
+    // Довге натискання кнопки енкодера в меню - повернення на сплеш-екран
+    if (encoderLongPress) {
+      menu.handleLongPress();
+      display.resetSplashScreen();
+      menu.clearResetSplashFlag();
+      lastDisplayUpdate = 0;
     }
     
-    // Обробка відпускання кнопки (перехід з true в false)
-    if (!buttonCurrentlyPressed && buttonWasPressedMenu) {
-      unsigned long pressDuration = currentTime - buttonPressStartTimeMenu;
-      
-      // Коротке натискання: більше debounce, але менше довгого, і НЕ було виявлено довгого
-      if (!longPressDetectedMenu && pressDuration < LONG_PRESS_THRESHOLD_MS && pressDuration >= BUTTON_DEBOUNCE_MS) {
-        buttonPressedForMenu = true;
-      }
-      
-      // Скидаємо всі прапорці після відпускання
-      buttonWasPressedMenu = false;
-      longPressDetectedMenu = false;
-    }
+    // Оновлюємо навігацію по меню
+    menu.updateNavigation(encoderDelta, encoderClick, encoderSpeed);
     
-    // Обчислюємо encoderDelta безпосередньо перед використанням
-    int16_t encoderDelta = 0;
-    if (rawDelta > 0) {
-      encoderDelta = 1;  // Тільки один крок вгору
-    } else if (rawDelta < 0) {
-      encoderDelta = -1; // Тільки один крок вниз
+    // Параметр змінено в меню - діє одразу
+    if (menu.shouldApplySettings()) {
+      applySettings();
+      menu.clearApplySettingsFlag();
     }
     
-    // Оновлюємо навігацію по меню
-    menu.updateNavigation(encoderDelta, buttonPressedForMenu);
-    
     // Перевіряємо, чи змінилося меню на сплеш-екран
     MenuType currentMenuAfter = menu.getCurrentMenu();
     
@@ -290,64 +345,68 @@ void loop() {
       lastDisplayUpdate = 0; // Примусово оновлюємо дисплей
     }
     
-    lastMenu = currentMenuAfter;
-    
     // Обробка кнопки старт-стоп (тільки якщо не на сплеш-екрані)
-    startStop.toggle();
+    if (startStopPressed) {
+      startStop.toggle();
+    }
   }
   
   startStop.updateLED();
   
+  // Кроки від кнопки кроку передаються двигуну в taskMotion()
+  pendingFineSteps += fineAdjustSteps;
+  
   // Обробка кнопки встановлення нуля абсолютного енкодера (працює на всіх екранах)
-  if (encoderZeroButton.isPressed()) {
+  // Обнулення не блокує loop(): зразки накопичуються в перериванні АЦП, тут лише перевіряємо завершення
+  if (zeroButtonPressed && !absoluteEncoder.isZeroing()) {
     // Зберігаємо поточний цільовий кут (наприклад 100°) перед обнуленням
-    uint16_t savedTargetAngle = menu.getTargetAngle();
+    zeroSavedTargetAngle = menu.getTargetAngle();
     
     // Зберігаємо поточну позицію двигуна як нульову
-    int32_t currentPosition = stepper.getPosition();
-    menu.setStepperZeroPosition(currentPosition);
-    
-    // Встановлюємо нуль енкодера (тепер кут 0°)
-    absoluteEncoder.setZero();
+    menu.setStepperZeroPosition(stepper.getPosition());
     
+    // Починаємо встановлення нуля енкодера
+    absoluteEncoder.startZero();
+    display.showMessage(F("Encoder"), F("Zeroing..."));
+  }
+}
+
+// Абсолютний енкодер: цільовий кут і завершення обнулення
+void taskSensing() {
+  PROFILE_SCOPE(PROFILE_SENSING);
+  // Читаємо абсолютний енкодер P3022-CW360 (встановлює цільовий кут)
+  // Оновлюємо на сплеш-екрані та в інших меню (крім режиму редагування)
+  // НЕ оновлюємо цільовий кут коли двигун рухається (startStop.getState() == true)
+  // updateTargetAngle сам перевіряє прапорець _manualAngleSet
+  if ((menu.getCurrentMenu() == MENU_SPLASH || !menu.isEditingAngle()) && !startStop.getState()) {
+    uint16_t absoluteAngle = absoluteEncoder.readAngleInt();
+    menu.updateTargetAngle(absoluteAngle);
+  }
+  
+  if (absoluteEncoder.isZeroing() && !absoluteEncoder.updateZero(millis())) {
+    // Нуль енкодера встановлено (тепер кут 0°)
     // Зберігаємо поточну позицію, напрямок та нуль в пам'ять
-    uint8_t currentDirection = (uint8_t)menu.getDirection();
-    int32_t currentStepperZero = menu.getStepperZeroPosition();
-    memory.saveSettings(currentPosition, currentDirection, currentStepperZero);
+    settings.position = menu.getStepperZeroPosition();
+    settings.direction = (uint8_t)menu.getDirection();
+    settings.stepperZero = menu.getStepperZeroPosition();
+    memory.saveSettings(settings);
     
     // Відновлюємо збережений цільовий кут (100°) - він залишається незмінним
-    menu.setTargetAngle(savedTargetAngle);
+    menu.setTargetAngle(zeroSavedTargetAngle);
     
-    display.showMessage("Encoder", "");
+    display.showMessage(F("Encoder"), F(""));
   }
+}
+
+// Рух: кнопка кроку, напрямок і позиціювання до цільового кута
+void taskMotion() {
+  PROFILE_INTERVAL(PROFILE_MOTION_PERIOD);
+  PROFILE_SCOPE(PROFILE_MOTION);
   
-  // Обробка кнопки руху на один крок (для точного регулювання кута)
-  static unsigned long stepButtonPressStartTime = 0;
-  static bool stepButtonWasPressed = false;
-  static unsigned long lastStepTime = 0;
-  unsigned long currentTime = millis();
-  bool stepButtonCurrentlyPressed = stepFineAdjustButton.isCurrentlyPressed();
-  
-  if (stepButtonCurrentlyPressed && !stepButtonWasPressed) {
-    // Початок натискання - виконуємо один крок та фіксуємо час
-    stepper.move(1);
-    stepButtonPressStartTime = currentTime;
-    stepButtonWasPressed = true;
-    lastStepTime = currentTime;
-  } else if (stepButtonCurrentlyPressed && stepButtonWasPressed) {
-    // Кнопка утримується - перевіряємо чи настав час швидкого повторення
-    unsigned long pressDuration = currentTime - stepButtonPressStartTime;
-    if (pressDuration >= STEP_BUTTON_LONG_PRESS_MS) {
-      // Довге натискання - швидке повторення кроків
-      if (currentTime - lastStepTime >= STEP_BUTTON_REPEAT_DELAY_MS) {
-        stepper.move(1);
-        lastStepTime = currentTime;
-      }
-    }
-  } else if (!stepButtonCurrentlyPressed && stepButtonWasPressed) {
-    // Кнопка відпущена
-    stepButtonWasPressed = false;
-  }
+  // Кнопка руху на один крок: крок при натисканні, після STEP_BUTTON_LONG_PRESS_MS утримання -
+  // автоповтор кожні STEP_BUTTON_REPEAT_DELAY_MS (події REPEAT від сканера)
+  stepper.move(pendingFineSteps);
+  pendingFineSteps = 0;
   
   // Використовуємо напрямок з меню Settings (замість фізичного перемикача)
   RotationDirection currentDirection = menu.getDirection();
@@ -356,9 +415,6 @@ void loop() {
   // Отримуємо цільову позицію з меню
   int32_t targetPosition = menu.getTargetPosition();
   
-  // Оновлюємо кроковий двигун (неблокуюче) - завжди викликаємо для виконання кроків
-  stepper.update();
-  
   // Виконуємо рух до цільової позиції (тільки якщо старт активний)
   if (startStop.getState()) {
     // Обчислюємо ефективну поточну позицію (включаючи кроки в процесі виконання)
@@ -391,16 +447,51 @@ void loop() {
       stepsNeeded += STEPS_360;
     }
     
-    // Статична змінна для відстеження попередньої цільової позиції
-    static int32_t lastTargetPosition = 0;
-    static bool targetChanged = false;
-    
     // Відстежуємо зміну цільової позиції
     if (targetPosition != lastTargetPosition) {
       targetChanged = true;
       lastTargetPosition = targetPosition;
     }
     
+#if CLOSED_LOOP_ENABLED
+    // Новий старт або нова ціль - починаємо позиціювання заново
+    if (!closedLoopActive || targetChanged) {
+      positionController.begin(menu.getTargetAngle() * 100U);
+      closedLoopActive = true;
+      targetChanged = false;
+    }
+    
+    int32_t remaining = stepper.getRemaining();
+    if (remaining == 0 && abs(stepsNeeded) > 10) {
+      // Грубий рух за позицією двигуна (open-loop), поріг 10 кроків (≈1.1°)
+      // Обмежуємо максимальну швидкість руху (не більше 180° за раз)
+      int32_t stepsToMove = stepsNeeded;
+      if (stepsToMove > STEPS_360 / 2) {
+        stepsToMove = STEPS_360 / 2;
+      } else if (stepsToMove < -STEPS_360 / 2) {
+        stepsToMove = -STEPS_360 / 2;
+      }
+      stepper.move(stepsToMove);
+    } else {
+      // Двигун вважає, що він на місці - уточнюємо за енкодером
+      int32_t correction = positionController.update(
+        absoluteEncoder.readAngleCdeg(),
+        remaining == 0,
+        millis()
+      );
+      
+      if (positionController.isSettled() || positionController.hasFailed()) {
+        startStop.setState(false);
+        closedLoopActive = false;
+      } else if (correction != 0) {
+        // Енкодер показує, що стіл не там, де рахує двигун (втрачені кроки / проковзування):
+        // зсуваємо логічну позицію на величину корекції і доїжджаємо фізично,
+        // тому після корекції позиція двигуна знову дорівнює цільовій
+        stepper.setPosition(stepper.getPosition() - correction);
+        stepper.move(correction);
+      }
+    }
+#else
     // Перевіряємо, чи досягнуто цільовий кут за допомогою енкодера (для зупинки)
     uint16_t currentEncoderAngle = absoluteEncoder.readAngleInt();
     uint16_t targetAngle = menu.getTargetAngle();
@@ -413,10 +504,7 @@ void loop() {
       angleDiff += 360;
     }
     
-    // Гістерезис для стабільності: якщо вже рухаємося і наближаємося до цілі - не зупиняємося рано
-    static bool wasMoving = false;
-    static int16_t lastAngleDiff = 999;
-    
+    // Гістерезис для стабільності: якщо вже рухаємося і наближаємося до цілі - не зупиняємося рано (wasMoving)
     // Якщо досягнуто цільовий кут (допуск ±2 градуси) І (не рухалися або дуже близько) - вимикаємо двигун
     bool shouldStop = (abs(angleDiff) <= 2) && (!wasMoving || abs(angleDiff) <= 1);
     
@@ -428,8 +516,7 @@ void loop() {
     } else {
       // Використовуємо позицію двигуна для обчислення кроків (стабільніше)
       // Енкодер використовується тільки для зупинки
-      stepper.setDistanceToTarget(abs(stepsNeeded));
-      
+      // (гальмування перед ціллю планує сам Stepper за залишком кроків)
       if (stepper.getRemaining() == 0) {
         // Використовуємо обчислені stepsNeeded (на основі позиції двигуна)
         if (abs(stepsNeeded) > 10) {  // Мінімальний поріг 10 кроків (≈1.1°) для стабільності
@@ -451,28 +538,47 @@ void loop() {
         wasMoving = true;
       }
     }
+#endif
   } else {
-    // Якщо стоп - зупиняємо рух
-    // (stepper.update() не викликається, тому рух зупиняється)
+    // Якщо стоп - нові рухи до цілі не задаються
+#if CLOSED_LOOP_ENABLED
+    closedLoopActive = false;
+#endif
+  }
+}
+
+// Збереження: фоновий запис у EEPROM, збереження позиції та параметрів з меню і з Serial
+void taskPersistence() {
+  PROFILE_SCOPE(PROFILE_PERSIST);
+  memory.update();  // Фоновий запис налаштувань у EEPROM
+  pollSettingsSerial();
+  
+  // Вихід з меню після зміни параметрів - зберігаємо (стан у settings - останній збережений)
+  if (menu.shouldSaveSettings()) {
+    memory.saveSettings(settings);
+    menu.clearSaveSettingsFlag();
   }
   
   // Обробка збереження
-  static unsigned long saveMessageTime = 0;
   if (menu.shouldSave()) {
-    int32_t currentPosition = stepper.getPosition();
-    uint8_t currentDirection = (uint8_t)menu.getDirection();
-    int32_t currentStepperZero = menu.getStepperZeroPosition();
-    memory.saveSettings(currentPosition, currentDirection, currentStepperZero);
+    settings.position = stepper.getPosition();
+    settings.direction = (uint8_t)menu.getDirection();
+    settings.stepperZero = menu.getStepperZeroPosition();
+    memory.saveSettings(settings);
     menu.clearSaveFlag();
-    display.showMessage("Position saved", "to EEPROM");
+    display.showMessage(F("Position saved"), F("to EEPROM"));
     saveMessageTime = millis();
   }
-  
+}
+
+// Інтерфейс: екрани в буфер і відправлення змін на дисплей
+void taskUi() {
+  PROFILE_SCOPE(PROFILE_UI);
   // Оновлюємо дисплей залежно від поточного меню
   unsigned long now = millis();
   
   // Перевіряємо, чи показується повідомлення про збереження
-  if (saveMessageTime > 0 && (now - saveMessageTime < 1000)) {
+  if (saveMessageTime > 0 && (now - saveMessageTime < SAVE_MESSAGE_HOLD_MS)) {
     // Повідомлення вже відображається
   } else {
     if (saveMessageTime > 0) {
@@ -480,11 +586,10 @@ void loop() {
     }
     
     // Оновлюємо меню
-    if (now - lastDisplayUpdate > LCD_UPDATE_MS) {
+    if (now - lastDisplayUpdate > settings.lcdUpdateMs) {
       // Відстежуємо зміну меню для скидання стану відображення
-      static MenuType lastMenuType = MENU_SPLASH;
+      // (Display сам перемальовує екран при переході - тільки символи, що відрізняються)
       MenuType currentMenuType = menu.getCurrentMenu();
-      bool menuChanged = (lastMenuType != currentMenuType);
       
       // Додаткова перевірка: якщо меню змінилося на сплеш-екран
       if (lastMenuType != MENU_SPLASH && currentMenuType == MENU_SPLASH) {
@@ -508,9 +613,9 @@ void loop() {
             }
             
             // Показуємо кут з абсолютного енкодера та цільовий кут
-            float encoderAngle = absoluteEncoder.readAngle();
+            uint16_t encoderCdeg = absoluteEncoder.readDisplayAngleCdeg();
             display.showSplashScreen(
-              encoderAngle,
+              encoderCdeg,
               menu.getTargetAngle(),
               startStop.getState(),
               stepper.isEnabled()
@@ -518,35 +623,15 @@ void loop() {
           }
           break;
           
-        case MENU_MAIN:
-          display.showMainMenu(menu.getCurrentItem());
-          break;
-          
-        case MENU_SET_ANGLE:
-          // Очищаємо екран при переході в Set Angle меню
-          if (menuChanged) {
-            display.clear();
-          }
-          display.showSetAngleMenu(menu.getTargetAngle(), menu.getDigitMode());
-          break;
-          
-        case MENU_SETTINGS:
-          // Очищаємо екран при переході в Settings меню
-          if (menuChanged) {
-            display.clear();
-          }
-          display.showSettingsMenu(menu.getDirection() == DIR_CCW ? 1 : 0);
-          break;
-          
-        case MENU_SAVE:
-          // Очищаємо екран при переході в Save меню
-          if (menuChanged) {
-            display.clear();
-          }
-          display.showSaveMenu();
+        case MENU_TREE:
+          display.showMenu(menu.getCurrentNode(), menu.getCurrentItem(), menu.getCurrentValue(), menu.getDigitMode());
           break;
       }
       lastDisplayUpdate = now;
     }
   }
+  
+  // Відправляємо на дисплей зміни буфера - не більше DISPLAY_FLUSH_BUDGET_BYTES за прохід,
+  // решта дійде в наступних проходах, тому loop() не блокується на I2C
+  display.flush();
 }
@@ -1,71 +1,200 @@
 #include "absolute_encoder.h"
 
+AbsoluteEncoder* AbsoluteEncoder::_instance = nullptr;
+
+#if defined(__AVR__)
+ISR(ADC_vect) {
+  AbsoluteEncoder::adcIsr();
+}
+#endif
+
 AbsoluteEncoder::AbsoluteEncoder(uint8_t analogPin, float refVoltage, float maxAngle)
-  : _analogPin(analogPin), _refVoltage(refVoltage), _maxAngle(maxAngle),
-    _lastAngle(999), _lastReadTime(0), _zeroOffset(0.0), _filterIndex(0) {
-  // Ініціалізуємо буфер фільтрації
-  for (uint8_t i = 0; i < FILTER_SAMPLES; i++) {
-    _filterBuffer[i] = 0.0;
-  }
+  : _analogPin(analogPin), _maxAngleCdeg((uint16_t)(maxAngle * 100.0 + 0.5)),
+    _lastAngle(999), _lastReadTime(0), _zeroOffsetCdeg(0), _calibrationValid(false),
+    _filter(_maxAngleCdeg), _filteredCdeg(0),
+    _oversampleSum(0), _oversampleCount(0), _zeroState(ZERO_IDLE), _zeroStartTime(0),
+    _zeroReference(0), _zeroSum(0), _zeroRemaining(0) {
+  // Опорна напруга скорочується (кут = АЦП / 1023 * maxAngle), float потрібен тільки тут
+  (void)refVoltage;
+  _calSegmentCdeg = _maxAngleCdeg / ABS_ENC_CAL_POINTS;
+  // 36000 * 4096 / 4092 = 36035 при N = 2, але 144140 при N = 0 - тому множник 32-бітний;
+  // добуток на зразок все одно не перевищує повної шкали << 12 (див. static_assert у заголовку)
+  _sampleScale = (((uint32_t)_maxAngleCdeg << 12) + SAMPLE_MAX / 2) / SAMPLE_MAX;
+  clearCalibration();
+  _instance = this;
 }
 
 void AbsoluteEncoder::begin() {
   pinMode(_analogPin, INPUT);
+  
+  // Перше значення читаємо блокуюче і заповнюємо ним фільтр, щоб він одразу мав дані
+  uint16_t initial = analogRead(_analogPin) << ABS_ENC_OVERSAMPLE_BITS;
+  _filteredCdeg = sampleToCdeg(initial);
+  _filter.reset(_filteredCdeg);
+  
+#if defined(__AVR__)
+  // АЦП у вільному режимі з перериванням по завершенню перетворення
+  // Дільник 128: 125 кГц тактування АЦП, ~9.6 тис. перетворень на секунду
+  uint8_t channel = (_analogPin >= A0) ? (_analogPin - A0) : _analogPin;
+  noInterrupts();
+  ADMUX = _BV(REFS0) | (channel & 0x07);  // Опорна напруга AVcc
+#if defined(MUX5)
+  ADCSRB = (channel & 0x08) ? _BV(MUX5) : 0;  // Вільний режим (ADTS = 0), канали A8-A15 на Mega
+#else
+  ADCSRB = 0;  // Вільний режим (ADTS = 0)
+#endif
+  ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  ADCSRA |= _BV(ADSC);  // Запускаємо перше перетворення
+  interrupts();
+#endif
+  
   // Зчитуємо початкове значення
   _lastAngle = readAngleInt();
 }
 
-float AbsoluteEncoder::readRawAngle() {
-  int sensorValue = analogRead(_analogPin);
-  float voltage = sensorValue * (_refVoltage / 1023.0);
-  float angle = (voltage / _refVoltage) * _maxAngle;
-  
-  // Обмежуємо кут в межах 0-360
-  if (angle < 0) angle = 0;
-  if (angle > _maxAngle) angle = _maxAngle;
-  
-  return angle;
+void AbsoluteEncoder::adcIsr() {
+  if (!_instance) {
+    return;
+  }
+#if defined(__AVR__)
+  _instance->pushConversion(ADC);
+#else
+  // Без АЦП у вільному режимі перетворення робить сам виклик (тести на ПК викликають ISR напряму)
+  _instance->pushConversion(analogRead(_instance->_analogPin));
+#endif
+}
+
+void AbsoluteEncoder::pushConversion(uint16_t raw) {
+  // Передискретизація з децимацією: сума 4^N перетворень, зсунута на N біт,
+  // дає N додаткових біт роздільності (сума 64 * 1023 вміщується в uint16_t)
+  _oversampleSum += raw;
+  if (++_oversampleCount >= OVERSAMPLE_COUNT) {
+    pushSample(_oversampleSum >> ABS_ENC_OVERSAMPLE_BITS);
+    _oversampleSum = 0;
+    _oversampleCount = 0;
+  }
+}
+
+uint16_t AbsoluteEncoder::sampleToCdeg(uint16_t raw) {
+  uint16_t cdeg = (raw * _sampleScale + 2048) >> 12;  // До найближчої сотої: зрізання зсувало кут на -0.5 у середньому
+  return (cdeg >= _maxAngleCdeg) ? 0 : cdeg;  // Повна шкала - це знову 0°
 }
 
-float AbsoluteEncoder::readRawAngleFiltered() {
-  // Читаємо кілька зразків і усереднюємо (просте ковзне середнє)
-  float newValue = readRawAngle();
-  _filterBuffer[_filterIndex] = newValue;
-  _filterIndex = (_filterIndex + 1) % FILTER_SAMPLES;
+void AbsoluteEncoder::pushSample(uint16_t raw) {
+  uint16_t cdeg = sampleToCdeg(raw);
+  _filteredCdeg = _filter.push(cdeg);
   
-  // Обчислюємо середнє значення з буфера
-  float sum = 0.0;
-  for (uint8_t i = 0; i < FILTER_SAMPLES; i++) {
-    sum += _filterBuffer[i];
+  // Обнулення: накопичуємо нефільтровані зразки як відхилення від опорного кута,
+  // тому середнє біля 0° не переходить через 360°
+  if (_zeroRemaining) {
+    int32_t diff = (int32_t)cdeg - _zeroReference;
+    if (diff > (int32_t)(_maxAngleCdeg / 2)) diff -= _maxAngleCdeg;
+    if (diff < -(int32_t)(_maxAngleCdeg / 2)) diff += _maxAngleCdeg;
+    _zeroSum += diff;
+    _zeroRemaining--;
   }
-  float average = sum / FILTER_SAMPLES;
+}
+
+uint16_t AbsoluteEncoder::readRawCdegFiltered() {
+#if !defined(__AVR__)
+  // Без переривання АЦП - додаємо новий зразок опитуванням
+  pushSample(analogRead(_analogPin) << ABS_ENC_OVERSAMPLE_BITS);
+#endif
   
-  return average;
+  // Фільтр вже відпрацював у перериванні, читаємо його вихід атомарно
+  noInterrupts();
+  uint16_t cdeg = _filteredCdeg;
+  interrupts();
+  return cdeg;
 }
 
-float AbsoluteEncoder::readAngle() {
-  // Використовуємо фільтроване значення для стабільності
-  float rawAngle = readRawAngleFiltered();
-  float adjustedAngle = rawAngle - _zeroOffset;
+uint16_t AbsoluteEncoder::readRawAngleCdeg() {
+  return readRawCdegFiltered();
+}
+
+void AbsoluteEncoder::setCalibration(const int16_t* table) {
+  for (uint8_t i = 0; i < ABS_ENC_CAL_POINTS; i++) {
+    _calibration[i] = table[i];
+  }
+  _calibrationValid = true;
+}
+
+void AbsoluteEncoder::clearCalibration() {
+  for (uint8_t i = 0; i < ABS_ENC_CAL_POINTS; i++) {
+    _calibration[i] = 0;
+  }
+  _calibrationValid = false;
+}
+
+void AbsoluteEncoder::setFilter(uint8_t window, uint16_t alpha) {
+  // Фільтр працює в перериванні АЦП - змінюємо його з вимкненими перериваннями
+  noInterrupts();
+#if ABS_ENC_FILTER == ABS_ENC_FILTER_MEAN
+  _filter.setWindow(window);
+  (void)alpha;
+#elif ABS_ENC_FILTER == ABS_ENC_FILTER_EMA
+  _filter.setAlpha(alpha);
+  (void)window;
+#else
+  (void)window;
+  (void)alpha;
+#endif
+  interrupts();
+}
+
+uint16_t AbsoluteEncoder::applyCalibration(uint16_t rawCdeg) {
+  if (!_calibrationValid) {
+    return rawCdeg;
+  }
   
-  // Якщо кут дуже близький до нуля (шум), встановлюємо точно 0
-  if (adjustedAngle < 1.0 && adjustedAngle > -1.0) {
-    adjustedAngle = 0.0;
+  // Вузли рівномірні, тому сегмент знаходиться одним діленням - час не залежить від кута
+  uint8_t index = rawCdeg / _calSegmentCdeg;
+  if (index >= ABS_ENC_CAL_POINTS) {
+    index = ABS_ENC_CAL_POINTS - 1;
   }
+  int32_t fraction = rawCdeg - (uint16_t)index * _calSegmentCdeg;
+  int16_t c0 = _calibration[index];
+  int16_t c1 = _calibration[(index + 1) % ABS_ENC_CAL_POINTS];  // Таблиця замкнена по колу
+  int32_t correction = c0 + ((int32_t)(c1 - c0) * fraction) / _calSegmentCdeg;
+  
+  int32_t corrected = (int32_t)rawCdeg + correction;
+  if (corrected < 0) corrected += _maxAngleCdeg;
+  if (corrected >= _maxAngleCdeg) corrected -= _maxAngleCdeg;
+  return (uint16_t)corrected;
+}
+
+uint16_t AbsoluteEncoder::readAngleCdeg() {
+  // Використовуємо фільтроване значення для стабільності (без округлення біля нуля -
+  // регулятор позиції має бачити відхилення менше 1°)
+  int32_t adjusted = (int32_t)applyCalibration(readRawCdegFiltered()) - _zeroOffsetCdeg;
   
   // Нормалізуємо кут до діапазону 0-360
-  while (adjustedAngle < 0) {
-    adjustedAngle += _maxAngle;
+  if (adjusted < 0) {
+    adjusted += _maxAngleCdeg;
   }
-  while (adjustedAngle >= _maxAngle) {
-    adjustedAngle -= _maxAngle;
+  if (adjusted >= _maxAngleCdeg) {
+    adjusted -= _maxAngleCdeg;
   }
   
-  return adjustedAngle;
+  return (uint16_t)adjusted;
+}
+
+uint16_t AbsoluteEncoder::readDisplayAngleCdeg() {
+  uint16_t cdeg = readAngleCdeg();
+  
+  // Якщо кут дуже близький до нуля (шум, менше 1°), показуємо точно 0
+  if (cdeg < 100 || cdeg > _maxAngleCdeg - 100) {
+    cdeg = 0;
+  }
+  return cdeg;
+}
+
+float AbsoluteEncoder::readAngle() {
+  return readDisplayAngleCdeg() / 100.0f;
 }
 
 uint16_t AbsoluteEncoder::readAngleInt() {
-  return (uint16_t)readAngle();
+  return readDisplayAngleCdeg() / 100;
 }
 
 bool AbsoluteEncoder::hasChanged() {
@@ -85,39 +214,70 @@ bool AbsoluteEncoder::hasChanged() {
   return changed;
 }
 
-void AbsoluteEncoder::setZero() {
-  // Очищаємо буфер перед зчитуваннями
-  for (uint8_t i = 0; i < FILTER_SAMPLES; i++) {
-    _filterBuffer[i] = 0.0;
+void AbsoluteEncoder::startZero() {
+  // Перед вимірюванням даємо АЦП і фільтру стабілізуватись (замість блокуючої затримки)
+  noInterrupts();
+  _zeroRemaining = 0;
+  interrupts();
+  _zeroStartTime = millis();
+  _zeroState = ZERO_SETTLE;
+}
+
+bool AbsoluteEncoder::updateZero(unsigned long now) {
+  if (_zeroState == ZERO_IDLE) {
+    return false;
   }
-  _filterIndex = 0;
   
-  // Затримка для стабілізації АЦП
-  delay(50);
-  
-  // Робимо багато зчитувань для точного усереднення
-  float sum = 0.0;
-  const uint8_t samples = 128;  // Ще більше зразків
-  for (uint8_t i = 0; i < samples; i++) {
-    int sensorValue = analogRead(_analogPin);
-    float voltage = sensorValue * (_refVoltage / 1023.0);
-    float angle = (voltage / _refVoltage) * _maxAngle;
-    if (angle < 0) angle = 0;
-    if (angle > _maxAngle) angle = _maxAngle;
-    sum += angle;
-    delayMicroseconds(1000);  // Більша затримка для стабілізації
+  if (_zeroState == ZERO_SETTLE) {
+    if (now - _zeroStartTime < ZERO_SETTLE_MS) {
+      return true;
+    }
+    // Запускаємо накопичення в перериванні АЦП, опорний кут - поточний вихід фільтра
+    noInterrupts();
+    _zeroReference = _filteredCdeg;
+    _zeroSum = 0;
+    _zeroRemaining = ZERO_SAMPLES;
+    interrupts();
+    _zeroState = ZERO_COLLECT;
+    return true;
   }
   
-  // Обчислюємо середнє та встановлюємо offset
-  float averageRawAngle = sum / samples;
-  _zeroOffset = averageRawAngle;
+#if !defined(__AVR__)
+  // Без переривання АЦП - один зразок за виклик
+  pushSample(analogRead(_analogPin) << ABS_ENC_OVERSAMPLE_BITS);
+#endif
   
-  // Заповнюємо буфер offset для миттєвої стабільності після обнулення
-  for (uint8_t i = 0; i < FILTER_SAMPLES; i++) {
-    _filterBuffer[i] = _zeroOffset;
+  noInterrupts();
+  uint8_t remaining = _zeroRemaining;
+  int32_t sum = _zeroSum;
+  interrupts();
+  if (remaining) {
+    return true;
   }
-  _filterIndex = 0;
+  
+  // Середнє відхилення з округленням до найближчого
+  int32_t average = (sum >= 0) ? (sum + ZERO_SAMPLES / 2) / ZERO_SAMPLES
+                               : (sum - ZERO_SAMPLES / 2) / ZERO_SAMPLES;
+  int32_t angle = (int32_t)_zeroReference + average;
+  if (angle < 0) angle += _maxAngleCdeg;
+  if (angle >= _maxAngleCdeg) angle -= _maxAngleCdeg;
+  
+  // Новий нуль записується одним присвоєнням, коли все пораховано -
+  // readAngleCdeg() ніколи не бачить проміжного значення
+  _zeroOffsetCdeg = applyCalibration((uint16_t)angle);
   
   // Оновлюємо останній кут
   _lastAngle = 0;
+  _zeroState = ZERO_IDLE;
+  return false;
+}
+
+uint8_t AbsoluteEncoder::getZeroProgress() {
+  if (_zeroState != ZERO_COLLECT) {
+    return 0;
+  }
+  noInterrupts();
+  uint8_t remaining = _zeroRemaining;
+  interrupts();
+  return (uint16_t)(ZERO_SAMPLES - remaining) * 100 / ZERO_SAMPLES;
 }
@@ -2,30 +2,84 @@
 #define ABSOLUTE_ENCODER_H
 
 #include <Arduino.h>
+#include "config.h"
+#include "angle_filter.h"
 
+// На AVR АЦП працює у вільному режимі (free-running): кожне перетворення
+// обробляється перериванням ADC_vect (передискретизація + фільтр кута), тому читання кута
+// не чекає на analogRead(). Інші аналогові піни через analogRead() в цьому режимі не використовуються.
+// Перетворення передискретизуються (ABS_ENC_OVERSAMPLE_BITS): у фільтр потрапляють значення
+// з роздільністю 10 + N біт, тобто до 13 біт (~0.044° на код замість ~0.35°).
+// Фільтр (ABS_ENC_FILTER) працює з кутом у сотих градуса і враховує перехід 359° -> 0°.
 class AbsoluteEncoder {
 public:
   AbsoluteEncoder(uint8_t analogPin, float refVoltage = 5.0, float maxAngle = 360.0);
   void begin();
-  float readAngle();  // Читає кут в градусах (0-360)
-  uint16_t readAngleInt();  // Читає кут як ціле число (0-360)
+  float readAngle();  // Читає кут в градусах (0-360), тільки для відображення
+  uint16_t readAngleInt();  // Читає кут як ціле число (0-360), менше 1° від нуля - 0
+  uint16_t readAngleCdeg();  // Читає кут у сотих долях градуса (0-35999), без float і без округлення біля нуля
+  uint16_t readDisplayAngleCdeg();  // Те саме для відображення: менше 1° від нуля - точно 0
   bool hasChanged();  // Перевіряє, чи змінився кут
-  void setZero();  // Встановлює поточне положення як нуль (0°)
+  void startZero();  // Починає встановлення поточного положення як нуля (0°), не блокує
+  bool updateZero(unsigned long now);  // Крок процедури обнулення з loop(); true - ще триває
+  bool isZeroing() const { return _zeroState != ZERO_IDLE; }
+  uint8_t getZeroProgress();  // Прогрес обнулення, 0-100%
+  uint16_t readRawAngleCdeg();  // Фільтрований кут без калібрування та нуля (для процедури калібрування)
+  void setCalibration(const int16_t* table);  // Таблиця поправок (ABS_ENC_CAL_POINTS значень, соті градуса)
+  void clearCalibration();  // Вимикає поправки (лінійна характеристика)
+  void setFilter(uint8_t window, uint16_t alpha);  // Вікно ABS_ENC_FILTER_MEAN або alpha ABS_ENC_FILTER_EMA (медіана - без параметрів)
+  bool isCalibrated() const { return _calibrationValid; }
+  uint16_t getMaxAngleCdeg() const { return _maxAngleCdeg; }  // Повна шкала (соті градуса)
+  
+  static void adcIsr();  // Викликається з ISR(ADC_vect); не на AVR - одне перетворення analogRead()
   
 private:
   uint8_t _analogPin;
-  float _refVoltage;
-  float _maxAngle;
+  uint16_t _maxAngleCdeg;  // Повна шкала датчика (соті градуса), 36000 для 360°
   uint16_t _lastAngle;
   unsigned long _lastReadTime;
-  float _zeroOffset;  // Зсув для встановлення нуля
+  uint16_t _zeroOffsetCdeg;  // Зсув для встановлення нуля (соті градуса)
+  int16_t _calibration[ABS_ENC_CAL_POINTS];  // Поправки в рівномірних вузлах сирого кута (соті градуса)
+  uint16_t _calSegmentCdeg;  // Відстань між вузлами таблиці (соті градуса)
+  bool _calibrationValid;
   static const unsigned long READ_INTERVAL_MS = 10;  // Інтервал читання
-  static const uint8_t FILTER_SAMPLES = 8;  // Кількість зразків для фільтрації
-  float _filterBuffer[FILTER_SAMPLES];  // Буфер для фільтрації
-  uint8_t _filterIndex;  // Індекс для буфера фільтрації
+  AngleFilter _filter;  // Фільтр кута (тільки в перериванні)
+  uint32_t _sampleScale;  // Перерахунок зразка в соті градуса, множник << 12 (без ділення в перериванні)
+  volatile uint16_t _filteredCdeg;  // Вихід фільтра (соті градуса, без калібрування та нуля)
+  uint16_t _oversampleSum;  // Сума перетворень поточного блоку передискретизації (тільки в перериванні)
+  uint8_t _oversampleCount;  // Кількість перетворень у поточному блоці
+  static const uint16_t ADC_MAX = 1023;
+  
+  // Обнулення: пауза на стабілізацію, потім переривання АЦП накопичує ZERO_SAMPLES зразків
+  enum ZeroState {
+    ZERO_IDLE,
+    ZERO_SETTLE,
+    ZERO_COLLECT
+  };
+  static const uint8_t ZERO_SAMPLES = 128;
+  static const unsigned long ZERO_SETTLE_MS = 50;
+  ZeroState _zeroState;
+  unsigned long _zeroStartTime;
+  uint16_t _zeroReference;  // Кут, відносно якого розгортаються зразки обнулення (соті градуса)
+  volatile int32_t _zeroSum;  // Сума відхилень від _zeroReference (накопичується в перериванні)
+  volatile uint8_t _zeroRemaining;  // Скільки зразків ще потрібно для обнулення
+  static const uint8_t OVERSAMPLE_COUNT = 1 << (2 * ABS_ENC_OVERSAMPLE_BITS);  // 4^N перетворень на зразок
+  static const uint16_t SAMPLE_MAX = ADC_MAX << ABS_ENC_OVERSAMPLE_BITS;  // Повна шкала зразка після децимації
+  
+  // Сума 4^N перетворень (до 64 * 1023) має вміщуватись в uint16_t _oversampleSum, а добуток
+  // зразка (до 13 біт) на _sampleScale (до 65535 * 4096 / SAMPLE_MAX, тобто до 18 біт при N = 0) - в uint32_t
+  static_assert(ABS_ENC_OVERSAMPLE_BITS >= 0 && ABS_ENC_OVERSAMPLE_BITS <= 3,
+                "ABS_ENC_OVERSAMPLE_BITS must be 0-3");
+  static_assert((uint32_t)SAMPLE_MAX * ((65535UL << 12) / SAMPLE_MAX) <= 0xFFFFFFFFUL - 0xFFFF,
+                "sample * _sampleScale must fit uint32_t");
+  
+  static AbsoluteEncoder* _instance;
   
-  float readRawAngle();  // Читає сире значення кута без урахування offset
-  float readRawAngleFiltered();  // Читає сире значення з фільтрацією
+  void pushSample(uint16_t raw);  // Пропускає зразок через фільтр (з переривання або з опитування)
+  void pushConversion(uint16_t raw);  // Накопичує перетворення АЦП і видає децимований зразок
+  uint16_t sampleToCdeg(uint16_t raw);  // Зразок (10 + N біт) -> соті градуса, без ділення
+  uint16_t readRawCdegFiltered();  // Фільтрований кут без урахування offset (соті градуса)
+  uint16_t applyCalibration(uint16_t rawCdeg);  // Кусково-лінійна поправка за таблицею
 };
 
 #endif
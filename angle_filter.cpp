@@ -0,0 +1,141 @@
+#include "angle_filter.h"
+
+#if ABS_ENC_FILTER == ABS_ENC_FILTER_MEAN
+
+CircularMeanFilter::CircularMeanFilter(uint16_t range) : _range(range), _window(WINDOW) {
+  reset(0);
+}
+
+void CircularMeanFilter::reset(uint16_t value) {
+  for (uint8_t i = 0; i < _window; i++) {
+    _buffer[i] = value;
+  }
+  _sum = (int32_t)value * _window;
+  _index = 0;
+  _output = value;
+}
+
+uint16_t CircularMeanFilter::push(uint16_t value) {
+  // Розгортаємо зразок відносно попереднього результату: різниця в межах ±півкола
+  int32_t diff = (int32_t)value - _output;
+  if (diff > (int32_t)(_range / 2)) diff -= _range;
+  if (diff < -(int32_t)(_range / 2)) diff += _range;
+  int32_t unwrapped = (int32_t)_output + diff;
+
+  _sum = _sum - _buffer[_index] + unwrapped;
+  _buffer[_index] = unwrapped;
+  if (++_index >= _window) {
+    _index = 0;
+  }
+
+  // Ділення до найближчого: + пів вікна зі знаком суми (зрізання до нуля тягнуло б кут до 0°
+  // з обох боків і тримало мертву зону в 2 соті навколо нуля)
+  int32_t mean = (_sum >= 0 ? _sum + _window / 2 : _sum - _window / 2) / _window;
+
+  // Середнє вийшло за межі кола - зсуваємо все вікно на повний оберт,
+  // щоб розгорнуті значення не росли необмежено при постійному обертанні
+  if (mean < 0 || mean >= _range) {
+    int32_t shift = (mean < 0) ? (int32_t)_range : -(int32_t)_range;
+    for (uint8_t i = 0; i < _window; i++) {
+      _buffer[i] += shift;
+    }
+    _sum += shift * _window;
+    mean += shift;
+  }
+
+  _output = (uint16_t)mean;
+  return _output;
+}
+
+void CircularMeanFilter::setWindow(uint8_t window) {
+  if (window < 1) window = 1;
+  if (window > WINDOW) window = WINDOW;
+  _window = window;
+  reset(_output);
+}
+
+#elif ABS_ENC_FILTER == ABS_ENC_FILTER_MEDIAN
+
+MedianFilter::MedianFilter(uint16_t range) : _range(range) {
+  reset(0);
+}
+
+void MedianFilter::reset(uint16_t value) {
+  for (uint8_t i = 0; i < WINDOW; i++) {
+    _buffer[i] = value;
+  }
+  _index = 0;
+  _output = value;
+}
+
+uint16_t MedianFilter::push(uint16_t value) {
+  _buffer[_index] = value;
+  if (++_index >= WINDOW) {
+    _index = 0;
+  }
+
+  // Розгортаємо вікно відносно попереднього результату, щоб значення по обидва боки 0° порівнювались
+  // правильно (відносно найновішого зразка викид навпроти групи біля 0° розділив би її навпіл)
+  int32_t v[WINDOW];
+  int32_t half = _range / 2;
+  for (uint8_t i = 0; i < WINDOW; i++) {
+    int32_t diff = (int32_t)_buffer[i] - _output;
+    if (diff > half) diff -= _range;
+    if (diff < -half) diff += _range;
+    v[i] = diff;
+  }
+
+  // Мережа сортування для медіани з 5 (7 порівнянь, без циклів і розгалужень за даними)
+  int32_t t;
+#define ANGLE_FILTER_SORT(a, b) if (v[a] > v[b]) { t = v[a]; v[a] = v[b]; v[b] = t; }
+  ANGLE_FILTER_SORT(0, 1);
+  ANGLE_FILTER_SORT(3, 4);
+  ANGLE_FILTER_SORT(0, 3);
+  ANGLE_FILTER_SORT(1, 4);
+  ANGLE_FILTER_SORT(1, 2);
+  ANGLE_FILTER_SORT(2, 3);
+  ANGLE_FILTER_SORT(1, 2);
+#undef ANGLE_FILTER_SORT
+
+  int32_t median = (int32_t)_output + v[2];
+  if (median < 0) median += _range;
+  if (median >= _range) median -= _range;
+  _output = (uint16_t)median;
+  return _output;
+}
+
+#elif ABS_ENC_FILTER == ABS_ENC_FILTER_EMA
+
+ExponentialFilter::ExponentialFilter(uint16_t range) : _range(range), _alpha(ABS_ENC_FILTER_ALPHA) {
+  reset(0);
+}
+
+void ExponentialFilter::setAlpha(uint16_t alpha) {
+  if (alpha < 1) alpha = 1;
+  if (alpha > 256) alpha = 256;
+  _alpha = alpha;
+}
+
+void ExponentialFilter::reset(uint16_t value) {
+  _state = (int32_t)value << 8;
+}
+
+uint16_t ExponentialFilter::push(uint16_t value) {
+  // Різниця між зразком і поточним станом найкоротшим шляхом по колу
+  int32_t diff = ((int32_t)value << 8) - _state;
+  int32_t full = (int32_t)_range << 8;
+  if (diff > full / 2) diff -= full;
+  if (diff < -full / 2) diff += full;
+
+  // alpha у 1/256: крок = diff * alpha / 256, округлений до найближчого симетрично відносно нуля -
+  // зсув вправо округлює вниз, і стан підходив до цілі знизу з недолетом, а зверху - точно
+  int32_t product = diff * _alpha;
+  _state += (product >= 0) ? ((product + 128) >> 8) : -((-product + 128) >> 8);
+  if (_state < 0) _state += full;
+  if (_state >= full) _state -= full;
+
+  uint16_t output = (uint16_t)((_state + 128) >> 8);
+  return (output >= _range) ? 0 : output;
+}
+
+#endif
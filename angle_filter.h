@@ -0,0 +1,69 @@
+#ifndef ANGLE_FILTER_H
+#define ANGLE_FILTER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Фільтри кута в сотих долях градуса з урахуванням переходу через нуль (0 .. range-1).
+// Викликаються з переривання АЦП, тому тільки цілочисельна арифметика.
+// Компілюється лише варіант, вибраний ABS_ENC_FILTER, і AngleFilter вказує на нього.
+
+#if ABS_ENC_FILTER == ABS_ENC_FILTER_MEAN
+// Ковзне середнє по колу: зразки розгортаються відносно попереднього результату
+// (різниця в межах ±півкола), тому середнє біля 0° не дає хибних ~180°
+class CircularMeanFilter {
+public:
+  explicit CircularMeanFilter(uint16_t range);
+  void reset(uint16_t value);
+  uint16_t push(uint16_t value);
+  void setWindow(uint8_t window);  // 1..ABS_ENC_FILTER_WINDOW (з налаштувань), заповнює вікно поточним виходом
+
+private:
+  static const uint8_t WINDOW = ABS_ENC_FILTER_WINDOW;  // Розмір буфера - найбільше вікно
+  uint16_t _range;
+  uint8_t _window;
+  int32_t _buffer[WINDOW];  // Розгорнуті значення (можуть виходити за 0 .. range-1)
+  int32_t _sum;
+  uint8_t _index;
+  uint16_t _output;
+};
+typedef CircularMeanFilter AngleFilter;
+
+#elif ABS_ENC_FILTER == ABS_ENC_FILTER_MEDIAN
+// Медіана з 5 останніх зразків: поодинокий викид не впливає на результат зовсім
+class MedianFilter {
+public:
+  explicit MedianFilter(uint16_t range);
+  void reset(uint16_t value);
+  uint16_t push(uint16_t value);
+
+private:
+  static const uint8_t WINDOW = 5;
+  uint16_t _range;
+  uint16_t _buffer[WINDOW];
+  uint8_t _index;
+  uint16_t _output;
+};
+typedef MedianFilter AngleFilter;
+
+#elif ABS_ENC_FILTER == ABS_ENC_FILTER_EMA
+// Експоненційний фільтр: y += alpha * (x - y), стан з 8 дробовими бітами
+class ExponentialFilter {
+public:
+  explicit ExponentialFilter(uint16_t range);
+  void reset(uint16_t value);
+  uint16_t push(uint16_t value);
+  void setAlpha(uint16_t alpha);  // 1..256 (з налаштувань)
+
+private:
+  uint16_t _range;
+  uint16_t _alpha;  // У 1/256, за замовчуванням ABS_ENC_FILTER_ALPHA
+  int32_t _state;  // Кут << 8
+};
+typedef ExponentialFilter AngleFilter;
+
+#else
+#error "Unknown ABS_ENC_FILTER"
+#endif
+
+#endif
@@ -29,13 +29,47 @@
 // Виберіть режим: 0 = 4-bit, 1 = I2C
 #define LCD_MODE 1  // I2C (працює на Mega та Nano)
 
+// Драйвер I2C: 1 = власний на перериваннях TWI (тільки AVR, запис у дисплей не блокує loop()),
+// 0 = бібліотека LiquidCrystal_I2C через Wire (блокуюча)
+#define LCD_I2C_ASYNC 1
+#define LCD_I2C_CLOCK_HZ 100000       // стандартна частота шини I2C
+#define LCD_I2C_FAST_CLOCK_HZ 400000  // швидкий режим, вмикається якщо модуль проходить перевірку при старті
+
 // Encoder (інкрементальний)
 #define ENC_A   2      // INT0
 #define ENC_B   3      // INT1
 #define ENC_BTN 4
+#define ENCODER_STEPS_PER_DETENT 4  // переходів квадратури на одне клацання (4 для KY-040, 2 або 1 для інших)
+// Прискорення при введенні кута: до SLOW клацань/с одне клацання = один крок розряду,
+// від SLOW до FAST множник зростає лінійно до ENCODER_ACCEL_MAX
+#define ENCODER_SPEED_TIMEOUT_MS 250  // пауза між клацаннями, після якої енкодер вважається зупиненим
+#define ENCODER_ACCEL_SLOW_DPS 6      // клацань/с
+#define ENCODER_ACCEL_FAST_DPS 30     // клацань/с
+#define ENCODER_ACCEL_MAX 10          // множник кроку на швидкості FAST і вище
 
 // Абсолютний енкодер P3022-CW360 (аналоговий)
 #define ABS_ENC_PIN A0  // Аналоговий пін для абсолютного енкодера
+// Передискретизація АЦП: 4^N перетворень сумуються і зсуваються на N біт (децимація)
+// 0 = вимкнено (10 біт), 1 = 4x (11 біт), 2 = 16x (12 біт), 3 = 64x (13 біт)
+// Додаткові біти реальні лише за наявності шуму ~1 МЗР на вході (природний шум АЦП/датчика)
+#define ABS_ENC_OVERSAMPLE_BITS 2
+
+// Фільтр кута абсолютного енкодера (вибирається при компіляції, інші варіанти не компілюються)
+// Усі варіанти враховують перехід 359° -> 0°; можна задати при компіляції (-DABS_ENC_FILTER=ABS_ENC_FILTER_EMA)
+#define ABS_ENC_FILTER_MEAN   0  // ковзне середнє по колу (ABS_ENC_FILTER_WINDOW зразків)
+#define ABS_ENC_FILTER_MEDIAN 1  // медіана з 5 зразків (відкидає поодинокі викиди)
+#define ABS_ENC_FILTER_EMA    2  // експоненційний фільтр (ABS_ENC_FILTER_ALPHA)
+#ifndef ABS_ENC_FILTER
+  #define ABS_ENC_FILTER ABS_ENC_FILTER_MEDIAN
+#endif
+#define ABS_ENC_FILTER_WINDOW 8   // вікно середнього (1-16)
+#ifndef ABS_ENC_FILTER_ALPHA
+  #define ABS_ENC_FILTER_ALPHA 64   // коефіцієнт EMA у 1/256 (1-256, більше = швидше реагує)
+#endif
+
+// Калібрування нелінійності абсолютного енкодера (запускається утриманням кнопки обнулення при ввімкненні)
+#define ABS_ENC_CAL_POINTS 16      // кількість точок по колу (STEPS_360 має ділитися без залишку)
+#define ABS_ENC_CAL_SETTLE_MS 300  // пауза після кожного руху перед вимірюванням (мс)
 
 // DM556 Stepper Driver
 #define STEP_PIN 6
@@ -77,11 +111,63 @@
 /* ================== ПАРАМЕТРИ ================== */
 #define STEP_DELAY_US 600  // затримка між кроками в мікросекундах
 #define STEP_PULSE_US 4    // тривалість імпульсу STEP
+#define STEPPER_MAX_SPEED_SPS 2500  // максимальна швидкість (кроків/с), 2500 = 400 мкс між кроками
+#define STEPPER_ACCEL_SPS2 10000    // прискорення та гальмування (кроків/с²)
 #define LCD_UPDATE_MS 100  // інтервал оновлення LCD
-#define BUTTON_DEBOUNCE_MS 50  // затримка для кнопки (зменшено для кращої відповіді)
+#define DISPLAY_FLUSH_BUDGET_BYTES 4  // максимум байтів на LCD (символи + команди курсора) за один прохід loop()
+#define INPUT_DEBOUNCE_SAMPLE_MS 5  // інтервал зразків debounce кнопок (мс), стан змінюється після 4 однакових зразків (~20 мс)
 #define SAVE_MESSAGE_MS 400     // час показу повідомлення про збереження
+#define SAVE_MESSAGE_HOLD_MS 1000  // скільки екрани меню не оновлюються після "Position saved" (мс)
 #define LONG_PRESS_THRESHOLD_MS 2000 // Час для довгого натискання кнопки енкодера (мс) - 2 секунди
 #define STEP_BUTTON_REPEAT_DELAY_MS 100 // Затримка між кроками при довгому натисканні (мс)
 #define STEP_BUTTON_LONG_PRESS_MS 500 // Час до початку швидкого повторення кроків (мс)
 
+/* ================== ПЛАНУВАЛЬНИК LOOP() ================== */
+// Задачі loop(): період (мс), пріоритет (0 - найвищий) і бюджет часу одного запуску (мкс);
+// запуск довший за бюджет рахується як перевищення (Scheduler::getStats)
+#define SCHEDULER_MAX_TASKS 6
+#define TASK_MOTION_PERIOD_MS 1       // рух і замкнений контур
+#define TASK_MOTION_PRIORITY 0
+#define TASK_MOTION_BUDGET_US 300
+#define TASK_INPUT_PERIOD_MS 5        // події кнопок, енкодер, навігація меню
+#define TASK_INPUT_PRIORITY 1
+#define TASK_INPUT_BUDGET_US 500
+#define TASK_SENSING_PERIOD_MS 10     // абсолютний енкодер: цільовий кут, обнулення
+#define TASK_SENSING_PRIORITY 2
+#define TASK_SENSING_BUDGET_US 300
+#define TASK_PERSIST_PERIOD_MS 5      // збереження налаштувань у EEPROM
+#define TASK_PERSIST_PRIORITY 3
+#define TASK_PERSIST_BUDGET_US 300
+#define TASK_UI_PERIOD_MS 2           // екрани в буфер (раз на LCD_UPDATE_MS) і відправлення на дисплей
+#define TASK_UI_PRIORITY 4
+#define TASK_UI_BUDGET_US 1000
+
+/* ================== ПРОФІЛЮВАННЯ ================== */
+// 1 = вимірювання часу секцій loop() і звіт у Serial (команди: 'p' - звіт, 'r' - скидання),
+// 0 = макроси PROFILE_* порожні (ні коду, ні RAM); можна задати при компіляції (-DPROFILER_ENABLED=1)
+#ifndef PROFILER_ENABLED
+  #define PROFILER_ENABLED 0
+#endif
+#define PROFILER_SERIAL_BAUD 115200
+
+/* ================== НАЛАШТУВАННЯ ЧЕРЕЗ SERIAL ================== */
+// 1 = параметри з Settings задаються рядком "<тег hex> <значення>" (теги - SettingsTag у memory.h,
+// наприклад "10 3000" - максимальна швидкість), рядок "<тег hex>" показує значення; відповідь "ok" або "err".
+// Змінене одразу діє і зберігається в EEPROM. Порт спільний з профілювальником - не вмикати разом з ним
+#ifndef SETTINGS_SERIAL_ENABLED
+  #define SETTINGS_SERIAL_ENABLED 0
+#endif
+#define SETTINGS_SERIAL_BAUD 115200
+
+/* ================== ЗАМКНЕНИЙ КОНТУР ================== */
+// Корекція позиції за абсолютним енкодером: 1 = увімкнено, 0 = тільки зупинка по допуску ±2°
+#define CLOSED_LOOP_ENABLED 1
+#define CLOSED_LOOP_TOLERANCE_CDEG 50        // допуск позиціювання (соті градуса), 50 = 0.5°
+#define CLOSED_LOOP_SETTLE_MS 150            // пауза після руху перед вимірюванням кута (мс)
+#define CLOSED_LOOP_KP_PERCENT 80            // пропорційний коефіцієнт (% від помилки)
+#define CLOSED_LOOP_KI_PERCENT 20            // інтегральний коефіцієнт (% від суми помилок)
+#define CLOSED_LOOP_MAX_CORRECTION_STEPS 160 // максимальна одна корекція (кроків, ~18°)
+#define CLOSED_LOOP_MAX_ATTEMPTS 10          // максимальна кількість корекцій за одне позиціювання
+#define STEP_LOSS_THRESHOLD_CDEG 200         // розбіжність двигун/енкодер, що вважається втратою кроків (2°)
+
 #endif
@@ -1,25 +1,72 @@
 #include "display.h"
 #include "config.h"
+#include "format.h"
 #include <string.h>
 
-// Глобальна змінна для скидання сплеш-екрану
-static bool _splashNeedReset = false;
+DisplayBuffer::DisplayBuffer() : _stamp(0), _cols(MAX_COLS), _rows(MAX_ROWS), _col(0), _row(0) {
+  memset(_cells, ' ', sizeof(_cells));
+  memset(_rowStamp, 0, sizeof(_rowStamp));
+}
+
+void DisplayBuffer::setSize(uint8_t cols, uint8_t rows) {
+  _cols = (cols > MAX_COLS) ? MAX_COLS : cols;
+  _rows = (rows > MAX_ROWS) ? MAX_ROWS : rows;
+}
+
+void DisplayBuffer::clear() {
+  for (uint8_t row = 0; row < MAX_ROWS; row++) {
+    for (uint8_t col = 0; col < MAX_COLS; col++) {
+      if (_cells[row][col] != ' ') {
+        _cells[row][col] = ' ';
+        _rowStamp[row] = ++_stamp;
+      }
+    }
+  }
+  _col = 0;
+  _row = 0;
+}
+
+void DisplayBuffer::setCursor(uint8_t col, uint8_t row) {
+  _col = col;
+  _row = row;
+}
+
+void DisplayBuffer::clearToEndOfRow() {
+  while (_row < _rows && _col < _cols) {
+    write(' ');
+  }
+}
+
+size_t DisplayBuffer::write(uint8_t c) {
+  // Текст за межами екрану відкидаємо (реальний HD44780 переносив би його в інший рядок)
+  if (_row >= _rows || _col >= _cols) {
+    return 1;
+  }
+  if (_cells[_row][_col] != (char)c) {
+    _cells[_row][_col] = (char)c;
+    _rowStamp[_row] = ++_stamp;
+  }
+  _col++;
+  return 1;
+}
 
 #if LCD_MODE == 0
 // Конструктор для 4-bit режиму
 Display::Display(uint8_t rs, uint8_t enable, uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7)
-  : _lastDeg(999), _lastTargetDeg(999),
-    _lastUpdate(0), _messageShown(false), _messageStartTime(0), _isI2C(false), _setAngleNeedsRedraw(true) {
+  : _i2cAddress(0), _busClockHz(0), _lcdCol(0), _lcdRow(255), _sending(false), _flushRow(255), _flushCol(0),
+    _messageShown(false), _messageStartTime(0), _isI2C(false), _screen(SCREEN_NONE) {
   _cols = (LCD_TYPE == 1) ? 16 : 20;
   _rows = (LCD_TYPE == 1) ? 2 : 4;
   _lcd = new LiquidCrystal(rs, enable, d4, d5, d6, d7);
+  _frame.setSize(_cols, _rows);
 }
 #else
 // Конструктор для I2C режиму
 Display::Display(uint8_t i2cAddress, uint8_t cols, uint8_t rows)
-  : _cols(cols), _rows(rows), _lastDeg(999), _lastTargetDeg(999),
-    _lastUpdate(0), _messageShown(false), _messageStartTime(0), _isI2C(true), _setAngleNeedsRedraw(true) {
-  _lcd = new LiquidCrystal_I2C(i2cAddress, cols, rows);
+  : _cols(cols), _rows(rows), _i2cAddress(i2cAddress), _busClockHz(LCD_I2C_CLOCK_HZ), _lcdCol(0), _lcdRow(255), _sending(false), _flushRow(255), _flushCol(0),
+    _messageShown(false), _messageStartTime(0), _isI2C(true), _screen(SCREEN_NONE) {
+  _lcd = new LcdI2c(i2cAddress, cols, rows);
+  _frame.setSize(_cols, _rows);
 }
 #endif
 
@@ -29,19 +76,7 @@ void Display::begin() {
   // Затримка для ініціалізації дисплея (особливо важливо для I2C)
   delay(50);
   
-  // Створюємо кастомний символ градуса (0) в CGRAM
-  // Символ градуса: маленьке коло вгорі
-  uint8_t degreeChar[8] = {
-    0b01100,  //  **
-    0b10010,  // *  *
-    0b10010,  // *  *
-    0b01100,  //  **
-    0b00000,  //
-    0b00000,  //
-    0b00000,  //
-    0b00000   //
-  };
-  _lcd->createChar(0, degreeChar);
+  createDegreeChar();
   
   // Затримка після createChar (може зміщувати курсор)
   delay(10);
@@ -54,399 +89,500 @@ void Display::begin() {
   // Явно встановлюємо курсор на початок після clear
   _lcd->setCursor(0, 0);
   
+  // Після clear дисплей і буфер однакові - порожні
+  _frame.clear();
+  memset(_shown, ' ', sizeof(_shown));
+  _lcdCol = 0;
+  _lcdRow = 0;
+  _sending = false;
+  _flushRow = 255;
+  
   #if LCD_MODE == 1
   _lcd->backlight();
+  selectBusClock();
   #endif
 }
 
-void Display::printAt(uint8_t col, uint8_t row, const char* text) {
-  _lcd->setCursor(col, row);
-  _lcd->print(text);
+void Display::createDegreeChar() {
+  // Створюємо кастомний символ градуса (0) в CGRAM
+  // Символ градуса: маленьке коло вгорі
+  uint8_t degreeChar[8] = {
+    0b01100,  //  **
+    0b10010,  // *  *
+    0b10010,  // *  *
+    0b01100,  //  **
+    0b00000,  //
+    0b00000,  //
+    0b00000,  //
+    0b00000   //
+  };
+  _lcd->createChar(0, degreeChar);
+}
+
+void Display::invalidate() {
+  // Значення, якого немає в буфері кадру, - кожен символ вважається зміненим
+  memset(_shown, 0xFF, sizeof(_shown));
+  _lcdRow = 255;
+  _flushRow = 255;
 }
 
-void Display::printAt(uint8_t col, uint8_t row, uint16_t value) {
-  _lcd->setCursor(col, row);
-  if (value < 100) _lcd->print(' ');
-  if (value < 10)  _lcd->print(' ');
-  _lcd->print(value);
+bool Display::isLcdReady() {
+#if LCD_MODE == 1 && defined(LCD_I2C_ASYNC_USED)
+  // Після помилки шини драйвер ініціалізує HD44780 заново - вміст дисплея і CGRAM втрачено
+  if (_lcd->update()) {
+    createDegreeChar();
+    invalidate();
+  }
+  return _lcd->isReady();
+#else
+  return true;
+#endif
 }
 
-void Display::printAt(uint8_t col, uint8_t row, float value, uint8_t decimals) {
-  _lcd->setCursor(col, row);
-  // Обмежуємо значення до 0-360
-  if (value < 0.0) value = 0.0;
-  if (value >= 360.0) value = 359.99;
-  // Форматуємо з заданою кількістю знаків після коми
-  _lcd->print(value, decimals);
+#if LCD_MODE == 1
+void Display::setBusClock(uint32_t hz) {
+#if defined(LCD_I2C_ASYNC_USED)
+  _lcd->setClock(hz);
+#else
+  Wire.setClock(hz);
+#endif
+  _busClockHz = hz;
 }
 
-void Display::update(uint32_t position, uint32_t steps360) {
-  unsigned long now = millis();
-  
-  // Перевіряємо, чи потрібно приховати повідомлення
-  if (_messageShown && (now - _messageStartTime > SAVE_MESSAGE_MS)) {
-    _messageShown = false;
-    drawAngleOnly(position, steps360);
-    _lastDeg = (uint32_t)position * 360 / steps360;
+bool Display::probeBus() {
+#if defined(LCD_I2C_ASYNC_USED)
+  return _lcd->probe();
+#else
+  // Записуємо стан порту PCF8574 (підсвітка, E = 0) і читаємо його назад
+  Wire.beginTransmission(_i2cAddress);
+  Wire.write(0x08);
+  if (Wire.endTransmission() != 0) {
+    return false;
   }
-  
-  // Оновлюємо кут, якщо змінився
-  if (!_messageShown && (now - _lastUpdate > LCD_UPDATE_MS)) {
-    uint16_t deg = (uint32_t)position * 360 / steps360;
-    if (_lastDeg != deg) {
-      drawAngleOnly(position, steps360);
-      _lastDeg = deg;
-    }
-    _lastUpdate = now;
+  if (Wire.requestFrom(_i2cAddress, (uint8_t)1) != 1) {
+    return false;
   }
+  return Wire.read() == 0x08;
+#endif
 }
 
-void Display::showMessage(const char* line0, const char* line1) {
-  _lcd->setCursor(0, 0);
-  _lcd->print(line0);
-  _lcd->setCursor(0, 1);
-  _lcd->print(line1);
-  _messageShown = true;
-  _messageStartTime = millis();
+void Display::selectBusClock() {
+  // PCF8574 за специфікацією працює до 100 кГц, але більшість модулів тримають 400 кГц -
+  // перевіряємо запис і зворотне читання на швидкій частоті, при помилці повертаємось на 100 кГц
+  setBusClock(LCD_I2C_FAST_CLOCK_HZ);
+  if (!probeBus()) {
+    setBusClock(LCD_I2C_CLOCK_HZ);
+  }
 }
+#endif
 
-void Display::showAngle(uint32_t position, uint32_t steps360) {
-  drawFull(position, steps360);
-  _lastDeg = (uint32_t)position * 360 / steps360;
-  _lastUpdate = millis();
+bool Display::isFlushed() {
+  if (_sending) {
+    return false;
+  }
+  for (uint8_t row = 0; row < _rows; row++) {
+    if (memcmp(_frame.rowData(row), _shown[row], _cols) != 0) {
+      return false;
+    }
+  }
+#if LCD_MODE == 1 && defined(LCD_I2C_ASYNC_USED)
+  return _lcd->isIdle();
+#else
+  return true;
+#endif
 }
 
-void Display::clear() {
-  _lcd->clear();
-  // Скидаємо прапорець для повного перемалювання Set Angle меню
-  _setAngleNeedsRedraw = true;
+void Display::flushAll() {
+  while (!isFlushed() && isLcdReady()) {
+    flush();
+  }
 }
 
-void Display::drawFull(uint32_t position, uint32_t steps360) {
-  // Нормалізуємо позицію до діапазону 0-360 градусів
-  int32_t normalizedPosition = position;
-  while (normalizedPosition < 0) {
-    normalizedPosition += steps360;
-  }
-  while (normalizedPosition >= steps360) {
-    normalizedPosition -= steps360;
+void Display::runBenchmark() {
+  uint16_t cells = (uint16_t)_cols * _rows;
+  
+  // Повне перемалювання: кожен символ відрізняється від попереднього вмісту
+  for (uint8_t row = 0; row < _rows; row++) {
+    _frame.setCursor(0, row);
+    for (uint8_t col = 0; col < _cols; col++) {
+      _frame.write((_shown[row][col] == '#') ? '*' : '#');
+    }
   }
-  uint16_t deg = (uint32_t)normalizedPosition * 360 / steps360;
+  unsigned long start = micros();
+  flushAll();
+  unsigned long fullUs = micros() - start;
+  
+  // Один символ
+  _frame.setCursor(_cols / 2, 1);
+  _frame.write('0');
+  start = micros();
+  flushAll();
+  unsigned long cellUs = micros() - start;
+  
+  // Апаратне очищення дисплея (команда HD44780 виконується ~1.5 мс)
+  start = micros();
+  _lcd->clear();
+  unsigned long clearUs = micros() - start;
+  memset(_shown, ' ', sizeof(_shown));
+  _lcdCol = 0;
+  _lcdRow = 0;
+  _sending = false;
+  _flushRow = 255;
+  
+  // Результат: час у мкс і символів за секунду при повному перемалюванні
+  _frame.clear();
+  _frame.setCursor(0, 0);
+  _frame.print(F("Full:"));
+  _frame.print(fullUs);
+  _frame.print(F("us"));
+  _frame.setCursor(0, 1);
+  _frame.print(F("Cell:"));
+  _frame.print(cellUs);
+  _frame.print(F("us Clr:"));
+  _frame.print(clearUs);
+  _frame.setCursor(0, 2);
+  _frame.print((uint32_t)cells * 1000000UL / (fullUs ? fullUs : 1));
+  _frame.print(F(" chr/s"));
+  _frame.setCursor(0, 3);
+  _frame.print(F("I2C:"));
+  _frame.print(_busClockHz / 1000);
+  _frame.print(F("kHz"));
+  flushAll();
+}
 
-  _lcd->setCursor(0, 0);
-  _lcd->print("Manual mode");
-  if (_cols >= 20) _lcd->print("        ");
+void Display::printAt(uint8_t col, uint8_t row, uint16_t value) {
+  _frame.setCursor(col, row);
+  if (value < 100) _frame.print(' ');
+  if (value < 10)  _frame.print(' ');
+  _frame.print(value);
+}
 
-  _lcd->setCursor(0, 1);
-  _lcd->print("Angle: ");
-  printAt(7, 1, deg);
-  _lcd->print((char)223); // °
-  if (_cols >= 20) _lcd->print("         ");
+void Display::printCdegAt(uint8_t col, uint8_t row, uint16_t cdeg) {
+  _frame.setCursor(col, row);
+  // Обмежуємо значення до 0-359.99
+  if (cdeg >= 36000) cdeg = 35999;
+  // Форматуємо з двома знаками після коми без float ("123.45")
+  char text[8];
+  formatFixed(text, cdeg, 2);
+  _frame.print(text);
 }
 
-void Display::drawAngleOnly(uint32_t position, uint32_t steps360) {
-  // Нормалізуємо позицію до діапазону 0-360 градусів
-  int32_t normalizedPosition = position;
-  while (normalizedPosition < 0) {
-    normalizedPosition += steps360;
-  }
-  while (normalizedPosition >= steps360) {
-    normalizedPosition -= steps360;
-  }
-  uint16_t deg = (uint32_t)normalizedPosition * 360 / steps360;
+void Display::showMessage(const __FlashStringHelper* line0, const __FlashStringHelper* line1) {
+  printRow(0, line0);
+  printRow(1, line1);
+  startMessage();
+}
 
-  printAt(7, 1, deg);
-  _lcd->print((char)223); // °
-  if (_cols >= 20) _lcd->print("         ");
+void Display::showMessage(const __FlashStringHelper* line0, const char* line1) {
+  printRow(0, line0);
+  printRow(1, line1);
+  startMessage();
 }
 
-void Display::updateWithTarget(uint32_t position, uint32_t steps360, uint16_t targetAngle) {
-  unsigned long now = millis();
-  
-  // Перевіряємо, чи потрібно приховати повідомлення
-  if (_messageShown && (now - _messageStartTime > SAVE_MESSAGE_MS)) {
-    _messageShown = false;
-    drawWithTarget(position, steps360, targetAngle);
-    _lastDeg = (uint32_t)position * 360 / steps360;
-    _lastTargetDeg = targetAngle;
-  }
-  
-  // Оновлюємо, якщо змінився кут або цільовий кут
-  if (!_messageShown && (now - _lastUpdate > LCD_UPDATE_MS)) {
-    uint16_t deg = (uint32_t)position * 360 / steps360;
-    if (_lastDeg != deg || _lastTargetDeg != targetAngle) {
-      drawWithTarget(position, steps360, targetAngle);
-      _lastDeg = deg;
-      _lastTargetDeg = targetAngle;
-    }
-    _lastUpdate = now;
-  }
+void Display::startMessage() {
+  // Після повідомлення поточний екран перемальовується повністю
+  _screen = SCREEN_NONE;
+  _messageShown = true;
+  _messageStartTime = millis();
+}
+
+void Display::clear() {
+  // Очищається тільки буфер - flush() зітре на дисплеї лише те, що там справді було
+  _frame.clear();
+  // Наступний екран малюється повністю
+  _screen = SCREEN_NONE;
 }
 
-void Display::drawWithTarget(uint32_t position, uint32_t steps360, uint16_t targetAngle) {
-  // Нормалізуємо позицію до діапазону 0-360 градусів
-  int32_t normalizedPosition = position;
-  while (normalizedPosition < 0) {
-    normalizedPosition += steps360;
+void Display::flush() {
+  // Обмін з дисплеєм обмежений бюджетом на один виклик, решта продовжується в наступному проході loop().
+  // Відправляється знімок усього кадру; наступний знімок береться тільки після того, як попередній
+  // повністю на дисплеї, тому дисплей ніколи не показує рядки (чи частини рядка) з різних кадрів
+  if (!isLcdReady()) {
+    return;
   }
-  while (normalizedPosition >= steps360) {
-    normalizedPosition -= steps360;
+  uint8_t budget = DISPLAY_FLUSH_BUDGET_BYTES;
+#if LCD_MODE == 1 && defined(LCD_I2C_ASYNC_USED)
+  // Не більше, ніж вміщається в чергу драйвера, - інакше запис чекав би, поки звільниться місце
+  uint8_t room = _lcd->getQueueFree() / LcdI2cAsync::QUEUE_BYTES_PER_SEND;
+  if (room < budget) {
+    budget = room;
   }
-  uint16_t currentDeg = (uint32_t)normalizedPosition * 360 / steps360;
-
-  // LCD2004 (20x4)
-  // Рядок 0: Заголовок
-  _lcd->setCursor(0, 0);
-  _lcd->print("Turntable Control");
-  _lcd->print("    ");
-  
-  // Рядок 1: Поточний кут
-  _lcd->setCursor(0, 1);
-  _lcd->print("Current: ");
-  printAt(9, 1, currentDeg);
-  _lcd->print((char)223); // °
-  _lcd->print("      ");
-  
-  // Рядок 2: Цільовий кут
-  _lcd->setCursor(0, 2);
-  _lcd->print("Target:  ");
-  printAt(9, 2, targetAngle);
-  _lcd->print((char)223); // °
-  _lcd->print("      ");
+#endif
   
-  // Рядок 3: Додаткова інформація (позиція в кроках)
-  _lcd->setCursor(0, 3);
-  _lcd->print("Steps: ");
-  _lcd->print(position);
-  _lcd->print(" / ");
-  _lcd->print(STEPS_360);
-}
-
-void Display::printMenuItem(uint8_t row, uint8_t itemIndex, const char* text, bool selected) {
-  _lcd->setCursor(0, row);
-  if (selected) {
-    // Для "Set Angle" (itemIndex == 0) - дві стрілки, для інших - одна
-    if (itemIndex == 0 && strcmp(text, "Set Angle") == 0) {
-      _lcd->print(">>");
-    } else {
-      _lcd->print(">");
+  while (budget > 0) {
+    if (!_sending) {
+      bool changed = false;
+      for (uint8_t row = 0; row < _rows && !changed; row++) {
+        changed = memcmp(_frame.rowData(row), _shown[row], _cols) != 0;
+      }
+      if (!changed) {
+        return;  // Дисплей вже збігається з буфером
+      }
+      for (uint8_t row = 0; row < _rows; row++) {
+        memcpy(_pending[row], _frame.rowData(row), _cols);
+        _pendingStamp[row] = _frame.rowStamp(row);
+      }
+      _sending = true;
+      _flushRow = 255;
+    }
+    
+    if (_flushRow == 255) {
+      // Спершу рядок знімка, який оновлювався найпізніше - він найважливіший для користувача
+      uint8_t best = 255;
+      for (uint8_t row = 0; row < _rows; row++) {
+        if (memcmp(_pending[row], _shown[row], _cols) == 0) {
+          continue;
+        }
+        if (best == 255 || (int16_t)(_pendingStamp[row] - _pendingStamp[best]) > 0) {
+          best = row;
+        }
+      }
+      if (best == 255) {
+        _sending = false;  // Знімок повністю на дисплеї
+        continue;
+      }
+      _flushRow = best;
+      _flushCol = 0;
+    }
+    
+    uint8_t row = _flushRow;
+    uint8_t col = _flushCol;
+    while (col < _cols && _pending[row][col] == _shown[row][col]) {
+      col++;
+    }
+    if (col >= _cols) {
+      _flushRow = 255;  // Рядок відправлено повністю
+      continue;
+    }
+    
+    // Курсор ставимо тільки якщо дисплей не стоїть тут після попереднього запису (команда теж з бюджету)
+    if (_lcdRow != row || _lcdCol != col) {
+      _lcd->setCursor(col, row);
+      _lcdRow = row;
+      _lcdCol = col;
+      budget--;
+    }
+    
+    // Відправляємо відрізок змінених символів підряд (адреса DDRAM збільшується сама)
+    while (budget > 0 && col < _cols && _pending[row][col] != _shown[row][col]) {
+      _lcd->write((uint8_t)_pending[row][col]);
+      _shown[row][col] = _pending[row][col];
+      col++;
+      budget--;
+    }
+    _lcdCol = col;
+    _flushCol = col;
+    
+    // Після кінця рядка HD44780 переходить не на наступний рядок - позиція невідома
+    if (_lcdCol >= _cols) {
+      _lcdRow = 255;
     }
-  } else {
-    _lcd->print(" ");
-  }
-  _lcd->print(text);
-  // Очищаємо решту рядка
-  uint8_t len = strlen(text);
-  uint8_t arrowLen = (selected && itemIndex == 0 && strcmp(text, "Set Angle") == 0) ? 2 : 1;
-  for (uint8_t i = len + arrowLen; i < _cols; i++) {
-    _lcd->print(" ");
   }
 }
 
-void Display::resetSplashScreen() {
-  // Встановлюємо прапорець для скидання сплеш-екрану
-  _splashNeedReset = true;
-}
-
-void Display::showSplashScreen(float encoderAngle, uint16_t targetAngle, bool isRunning, bool motorEnabled) {
-  static float lastEncoderAngle = -1.0;
-  static float filteredEncoderAngle = -1.0;  // Фільтроване значення для стабільності
-  static uint16_t lastTargetAngle = 65535;
-  static bool lastIsRunning = false;
-  static bool lastMotorEnabled = true;
-  static bool firstDisplay = true;
-  static bool firstRow3Display = true;  // Для першого відображення рядка 3
-  
-  // Якщо потрібно скинути (викликано resetSplashScreen) - робимо це
-  if (_splashNeedReset) {
-    firstDisplay = true;
-    firstRow3Display = true;
-    _splashNeedReset = false;
-    lastEncoderAngle = -1.0;
-    filteredEncoderAngle = -1.0;
-    lastTargetAngle = 65535;
-    lastIsRunning = !isRunning;
-    lastMotorEnabled = !motorEnabled;  // Примусово оновити
-  }
+void Display::printMenuItem(uint8_t row, const char* label, bool selected) {
+  _frame.setCursor(0, row);
+  _frame.print(selected ? '>' : ' ');
+  _frame.print(menuText(label));
+  // Очищаємо решту рядка
+  _frame.clearToEndOfRow();
+}
 
-  if (firstDisplay) {
-    _lcd->clear();
-    firstDisplay = false;
-    lastEncoderAngle = -1.0; // Примусово оновити
-    filteredEncoderAngle = encoderAngle;  // Ініціалізуємо фільтроване значення
-    lastTargetAngle = 65535;
-    lastIsRunning = !isRunning;
-    lastMotorEnabled = !motorEnabled;  // Примусово оновити
-  }
-  
-  // Фільтрація значення кута для стабільності відображення (експоненційне усереднення)
-  if (filteredEncoderAngle < 0.0) {
-    filteredEncoderAngle = encoderAngle;
-  } else {
-    // Експоненційне усереднення з коефіцієнтом 0.7 (30% нового значення, 70% старого)
-    filteredEncoderAngle = filteredEncoderAngle * 0.7f + encoderAngle * 0.3f;
-  }
+void Display::printRow(uint8_t row, const char* text) {
+  _frame.setCursor(0, row);
+  _frame.print(text);
+  _frame.clearToEndOfRow();
+}
 
-  // LCD2004
-  // Заголовок - стан утримання двигуна
-  if (lastEncoderAngle == 65535 || lastMotorEnabled != motorEnabled) {
-    _lcd->setCursor(0, 0);
-    if (motorEnabled) {
-      _lcd->print("Motor:Hold ON");
-    } else {
-      _lcd->print("Motor:Released");
-    }
-    _lcd->print("    ");
-    lastMotorEnabled = motorEnabled;
-  }
+void Display::printRow(uint8_t row, const __FlashStringHelper* text) {
+  _frame.setCursor(0, row);
+  _frame.print(text);
+  _frame.clearToEndOfRow();
+}
 
-  // Кут з абсолютного енкодера (поточний стан)
-  if (lastEncoderAngle < 0.0) {
-    _lcd->setCursor(0, 1);
-    _lcd->print("Encoder: ");
-  }
-  // Оновлюємо якщо змінився фільтрований кут (з більшою толерантністю для стабільності)
-  float diff = (lastEncoderAngle < 0.0) ? 1.0 : ((filteredEncoderAngle > lastEncoderAngle) ? (filteredEncoderAngle - lastEncoderAngle) : (lastEncoderAngle - filteredEncoderAngle));
-  if (lastEncoderAngle < 0.0 || diff > 0.1f) {  // Поріг збільшено до 0.1 градуса для стабільності
-    printAt(9, 1, filteredEncoderAngle, 2);
-    _lcd->write((uint8_t)0);  // Кастомний символ градуса
-    _lcd->print("      ");
-    lastEncoderAngle = filteredEncoderAngle;
-  }
+void Display::clearRow(uint8_t row) {
+  _frame.setCursor(0, row);
+  _frame.clearToEndOfRow();
+}
 
-  // Цільовий кут (встановлений для руху)
-  if (lastTargetAngle == 65535) {
-    _lcd->setCursor(0, 2);
-    _lcd->print("Target: ");
-  }
-  if (lastTargetAngle != targetAngle) {
-    printAt(8, 2, targetAngle);
-    _lcd->write((uint8_t)0);  // Кастомний символ градуса
-    _lcd->print("      ");
-    lastTargetAngle = targetAngle;
+bool Display::enterScreen(ScreenId screen) {
+  // Новий екран малюється повністю поверх попереднього: кожен рядок дописується пробілами,
+  // тому clear() не потрібен, а на дисплей потрапляють тільки символи, що відрізняються
+  if (_screen == screen) {
+    return false;
   }
+  _screen = screen;
+  return true;
+}
 
-  // Стан та інструкції (рядок 3) - завжди виводимо для надійності
-  _lcd->setCursor(0, 3);
-  if (isRunning) {
-    _lcd->print("Status: RUNNING    ");
-  } else {
-    _lcd->print("Menu:Ok Btn:Start  ");
+bool Display::isMessageShown() {
+  // Поки повідомлення на екрані, екрани меню його не перемальовують
+  if (_messageShown && (millis() - _messageStartTime <= SAVE_MESSAGE_MS)) {
+    return true;
   }
-  // Заповнюємо решту рядка пробілами
-  _lcd->print(" ");
-  lastIsRunning = isRunning;
+  _messageShown = false;
+  return false;
 }
 
-void Display::showMainMenu(uint8_t selectedItem) {
-  static uint8_t lastSelectedItem = 255;
-  
-  // Оновлюємо тільки якщо змінився вибраний пункт
-  if (lastSelectedItem != selectedItem) {
-    _lcd->clear();
-    lastSelectedItem = selectedItem;
-  }
-  
-  // LCD2004 - показуємо всі пункти
-  _lcd->setCursor(0, 0);
-  _lcd->print("Main Menu");
-  _lcd->print("           ");
-  
-  printMenuItem(1, 0, "Set Angle", selectedItem == 0);
-  printMenuItem(2, 1, "Settings", selectedItem == 1);
-  
-  // Рядок 3: показуємо Save Position
-  printMenuItem(3, 2, "Save Position", selectedItem == 2);
+void Display::resetSplashScreen() {
+  // Сплеш-екран буде повністю перемальовано, фільтр кута починає заново
+  _splash.dirty = true;
+  _splash.filteredCdeg = -1;
+  _splash.shownCdeg = -1;
 }
 
-void Display::showSetAngleMenu(uint16_t targetAngle, uint8_t digitMode) {
-  static uint16_t lastTargetAngle = 65535;
-  static uint8_t lastDigitMode = 255;
+void Display::showSplashScreen(uint16_t encoderCdeg, uint16_t targetAngle, bool isRunning, bool motorEnabled) {
+  SplashState& state = _splash;
+  if (enterScreen(SCREEN_SPLASH)) {
+    state.dirty = true;
+  }
   
-  // Оновлюємо тільки якщо змінився кут, режим розряду або потрібно повне перемалювання
-  // Екран очищається в Turntable_P3032.ino при переході в меню
-  if (_setAngleNeedsRedraw || lastTargetAngle != targetAngle || lastDigitMode != digitMode) {
-    _setAngleNeedsRedraw = false;
-    lastTargetAngle = targetAngle;
-    lastDigitMode = digitMode;
+  // Фільтрація значення кута для стабільності відображення (експоненційне усереднення)
+  if (state.filteredCdeg < 0) {
+    state.filteredCdeg = encoderCdeg;
   } else {
-    // Нічого не змінилося - виводимо тільки перший рядок
-    _lcd->setCursor(0, 0);
-    _lcd->print("Target: ");
-    if (targetAngle < 100) _lcd->print(' ');
-    if (targetAngle < 10) _lcd->print(' ');
-    _lcd->print(targetAngle);
-    _lcd->write((uint8_t)0);
-    _lcd->print("       ");
+    // Експоненційне усереднення з коефіцієнтом 0.7 (30% нового значення, 70% старого),
+    // різниця - найкоротшим шляхом по колу, щоб біля 0° не показувати проміжні ~180°
+    int32_t step = (int32_t)encoderCdeg - state.filteredCdeg;
+    if (step > 18000) step -= 36000;
+    if (step < -18000) step += 36000;
+    state.filteredCdeg += step * 3 / 10;
+    if (state.filteredCdeg < 0) state.filteredCdeg += 36000;
+    if (state.filteredCdeg >= 36000) state.filteredCdeg -= 36000;
+  }
+  
+  if (isMessageShown()) {
     return;
   }
   
-  // Визначаємо назву режиму розряду
-  const char* modeName = "";
-  switch (digitMode) {
-    case 0: modeName = "Units"; break;
-    case 1: modeName = "Tens"; break;
-    case 2: modeName = "Hundreds"; break;
+  // Кут оновлюється, якщо фільтроване значення змінилось більше ніж на 0.1° (для стабільності)
+  int32_t diff = state.filteredCdeg - state.shownCdeg;
+  bool angleChanged = (state.shownCdeg < 0) || diff > 10 || diff < -10;
+  if (!state.dirty && !angleChanged && state.targetAngle == targetAngle &&
+      state.isRunning == isRunning && state.motorEnabled == motorEnabled) {
+    return;
+  }
+  if (angleChanged) {
+    state.shownCdeg = state.filteredCdeg;
   }
   
   // LCD2004
-  // Перший рядок - виводимо завжди (як рядок 3 на першому екрані)
-  _lcd->setCursor(0, 0);
-  _lcd->print("Target: ");
-  // Виводимо кут вручну для надійності
-  if (targetAngle < 100) _lcd->print(' ');
-  if (targetAngle < 10) _lcd->print(' ');
-  _lcd->print(targetAngle);
-  _lcd->write((uint8_t)0);  // Кастомний символ градуса
-  _lcd->print("       ");
+  // Заголовок - стан утримання двигуна
+  printRow(0, motorEnabled ? F("Motor:Hold ON") : F("Motor:Released"));
   
-  _lcd->setCursor(0, 1);
-  _lcd->print("Mode: ");
-  _lcd->print(modeName);
-  for (uint8_t i = 6 + strlen(modeName); i < _cols; i++) {
-    _lcd->print(" ");
-  }
+  // Кут з абсолютного енкодера (поточний стан)
+  _frame.setCursor(0, 1);
+  _frame.print(F("Encoder: "));
+  printCdegAt(9, 1, state.shownCdeg);
+  _frame.write((uint8_t)0);  // Кастомний символ градуса
+  _frame.clearToEndOfRow();
   
-  _lcd->setCursor(0, 3);
-  _lcd->print("Btn:Ok");
-  _lcd->print("                  ");
+  // Цільовий кут (встановлений для руху)
+  _frame.setCursor(0, 2);
+  _frame.print(F("Target: "));
+  printAt(8, 2, targetAngle);
+  _frame.write((uint8_t)0);  // Кастомний символ градуса
+  _frame.clearToEndOfRow();
+  
+  // Стан та інструкції
+  printRow(3, isRunning ? F("Status: RUNNING") : F("Menu:Ok Btn:Start"));
+  
+  state.targetAngle = targetAngle;
+  state.isRunning = isRunning;
+  state.motorEnabled = motorEnabled;
+  state.dirty = false;
 }
 
-void Display::showSettingsMenu(uint8_t direction) {
-  // Екран вже очищено в Turntable_P3032.ino при переході в меню
-  // Тут просто відображаємо вміст
+// Назви режимів розряду (порядок - як у DigitMode)
+static const char TEXT_UNITS[] PROGMEM = "Units";
+static const char TEXT_TENS[] PROGMEM = "Tens";
+static const char TEXT_HUNDREDS[] PROGMEM = "Hundreds";
+static const char* const DIGIT_MODE_NAMES[] PROGMEM = { TEXT_UNITS, TEXT_TENS, TEXT_HUNDREDS };
+
+void Display::showMenu(const MenuNode* node, uint8_t selectedItem, uint16_t value, uint8_t digitMode) {
+  MenuScreenState& state = _menuScreen;
+  if (enterScreen(SCREEN_MENU) || state.node != node) {
+    state.dirty = true;
+  }
+  if (isMessageShown()) {
+    return;
+  }
   
-  static uint8_t lastDirection = 255;
-  bool directionChanged = (lastDirection != direction);
-  lastDirection = direction;
+  // Оновлюємо тільки якщо змінився пункт, значення або режим розряду
+  if (!state.dirty && state.selectedItem == selectedItem && state.value == value && state.digitMode == digitMode) {
+    return;
+  }
   
-  // LCD2004
-  // Оновлюємо напрямок тільки якщо змінився
-  if (directionChanged) {
-    _lcd->setCursor(0, 1);
-    if (direction == 0) {
-      _lcd->print("> CW  (Clockwise)");
-      _lcd->print("  ");
-    } else {
-      _lcd->print("> CCW (Counter-CW)");
+  MenuNode current;
+  readMenuNode(node, current);
+  switch (current.type) {
+    case MENU_NODE_LIST: {
+      // Рядок 0 - заголовок, далі пункти; якщо всі не вміщаються - вікно прокручується за вибраним.
+      // Кожен рядок пишеться один раз разом з пробілами до кінця (без попереднього очищення)
+      printRow(0, menuText(current.title));
+      uint8_t visible = _rows - 1;
+      uint8_t first = (selectedItem >= visible) ? selectedItem - visible + 1 : 0;
+      for (uint8_t row = 1; row < _rows; row++) {
+        uint8_t item = first + row - 1;
+        if (item < current.itemCount) {
+          MenuNode child;
+          readMenuNode(readMenuChild(current, item), child);
+          printMenuItem(row, child.label, item == selectedItem);
+        } else {
+          clearRow(row);
+        }
+      }
+      break;
     }
+    
+    case MENU_NODE_VALUE:
+      _frame.setCursor(0, 0);
+      _frame.print(menuText(current.title));
+      _frame.print(F(": "));
+      _frame.print(value);
+      if (current.flags & MENU_FLAG_DEGREES) {
+        _frame.write((uint8_t)0);  // Кастомний символ градуса
+      }
+      _frame.clearToEndOfRow();
+      
+      if (current.flags & MENU_FLAG_DIGIT_MODE) {
+        _frame.setCursor(0, 1);
+        _frame.print(F("Mode: "));
+        _frame.print(menuText((const char*)pgm_read_ptr(&DIGIT_MODE_NAMES[digitMode])));
+        _frame.clearToEndOfRow();
+      } else {
+        clearRow(1);
+      }
+      
+      clearRow(2);
+      printRow(3, F("Btn:Ok"));
+      break;
+      
+    case MENU_NODE_CHOICE:
+      if (current.title) {
+        printRow(0, menuText(current.title));
+      } else {
+        clearRow(0);
+      }
+      _frame.setCursor(0, 1);
+      _frame.print(F("> "));
+      _frame.print(menuText(readMenuOption(current, value)));
+      _frame.clearToEndOfRow();
+      clearRow(2);
+      printRow(3, F("Btn:Ok"));
+      break;
+      
+    case MENU_NODE_CONFIRM:
+      clearRow(0);
+      printRow(1, menuText(current.label));
+      clearRow(2);
+      printRow(3, F("Btn:Ok"));
+      break;
   }
   
-  _lcd->setCursor(0, 3);
-  _lcd->print("Btn:Ok");
-  _lcd->print("                  ");
-}
-
-void Display::showSaveMenu() {
-  // Екран вже очищено в Turntable_P3032.ino при переході в меню
-  // Тут просто відображаємо вміст
-  
-  // LCD2004
-  _lcd->setCursor(0, 1);
-  _lcd->print("Save Position");
-  _lcd->print("        ");
-  
-  _lcd->setCursor(0, 3);
-  _lcd->print("Btn:Ok");
-  _lcd->print("                  ");
+  state.node = node;
+  state.selectedItem = selectedItem;
+  state.value = value;
+  state.digitMode = digitMode;
+  state.dirty = false;
 }
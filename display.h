@@ -3,15 +3,50 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "menu_node.h"
 
 // Умовна компіляція для вибору бібліотеки
 #if LCD_MODE == 0
   #include <LiquidCrystal.h>
+#elif LCD_I2C_ASYNC && (defined(__AVR__) || defined(ARDUINO_HOST))
+  // На ПК драйвер працює з моделлю шини TWI - тести проходять той самий шлях, що й на платі
+  #define LCD_I2C_ASYNC_USED
+  #include "lcd_i2c_async.h"
+  typedef LcdI2cAsync LcdI2c;
 #else
   #include <Wire.h>
   #include <LiquidCrystal_I2C.h>
+  typedef LiquidCrystal_I2C LcdI2c;
 #endif
 
+// Тіньовий буфер екрану: екранні функції пишуть сюди (як у LCD - setCursor/print),
+// а Display::flush() відправляє на дисплей тільки змінені символи
+class DisplayBuffer : public Print {
+public:
+  static const uint8_t MAX_COLS = 20;
+  static const uint8_t MAX_ROWS = 4;
+  
+  DisplayBuffer();
+  void setSize(uint8_t cols, uint8_t rows);
+  void clear();  // Заповнює буфер пробілами, курсор на початок (без обміну з дисплеєм)
+  void setCursor(uint8_t col, uint8_t row);
+  void clearToEndOfRow();  // Пробіли від курсора до кінця рядка
+  virtual size_t write(uint8_t c);
+  using Print::write;
+  char at(uint8_t col, uint8_t row) const { return _cells[row][col]; }
+  const char* rowData(uint8_t row) const { return _cells[row]; }
+  uint16_t rowStamp(uint8_t row) const { return _rowStamp[row]; }  // Коли рядок востаннє змінювався
+  
+private:
+  char _cells[MAX_ROWS][MAX_COLS];
+  uint16_t _rowStamp[MAX_ROWS];  // Порядковий номер останньої зміни кожного рядка
+  uint16_t _stamp;
+  uint8_t _cols;
+  uint8_t _rows;
+  uint8_t _col;
+  uint8_t _row;
+};
+
 class Display {
 public:
   // Конструктор для 4-bit режиму
@@ -21,44 +56,88 @@ public:
   Display(uint8_t i2cAddress, uint8_t cols, uint8_t rows);
   
   void begin();
-  void update(uint32_t position, uint32_t steps360);
-  void updateWithTarget(uint32_t position, uint32_t steps360, uint16_t targetAngle);
-  void showMessage(const char* line0, const char* line1);
-  void showAngle(uint32_t position, uint32_t steps360);
+  void showMessage(const __FlashStringHelper* line0, const __FlashStringHelper* line1);  // Рядки з flash (F())
+  void showMessage(const __FlashStringHelper* line0, const char* line1);  // Другий рядок - з RAM (сформований під час роботи)
   void clear();
+  void flush();  // Відправляє на дисплей зміни буфера, не більше DISPLAY_FLUSH_BUDGET_BYTES за виклик і не більше, ніж вільно в черзі I2C
+  void runBenchmark();  // Вимірює час перемалювання екрану, одного символу та clear() і показує результат
+  uint32_t getBusClock() const { return _busClockHz; }  // Частота I2C після узгодження (0 - 4-bit режим)
   
   // Відображення меню
-  void showSplashScreen(float encoderAngle, uint16_t targetAngle, bool isRunning, bool motorEnabled);
-  void resetSplashScreen(); // Скидання стану сплеш-екрану при поверненні
-  void showMainMenu(uint8_t selectedItem);
-  void showSetAngleMenu(uint16_t targetAngle, uint8_t digitMode);
-  void showSettingsMenu(uint8_t direction);  // direction: 0 = CW, 1 = CCW
-  void showSaveMenu();
+  void showSplashScreen(uint16_t encoderCdeg, uint16_t targetAngle, bool isRunning, bool motorEnabled);  // Кут енкодера в сотих градуса
+  void resetSplashScreen(); // Примусове повне перемалювання сплеш-екрану
+  void showMenu(const MenuNode* node, uint8_t selectedItem, uint16_t value, uint8_t digitMode);  // Екран вузла меню (node - у PROGMEM)
   
 private:
+  // Який екран зараз у буфері: при переході на інший екран він малюється повністю
+  enum ScreenId {
+    SCREEN_NONE,
+    SCREEN_SPLASH,
+    SCREEN_MENU
+  };
+  
+  // Стан кожного екрану: що на ньому показано і чи потрібно перемалювати
+  struct SplashState {
+    bool dirty;
+    int32_t filteredCdeg;  // Фільтрований кут енкодера (-1 - фільтр не ініціалізовано)
+    int32_t shownCdeg;  // Кут, що показано (-1 - ще не показано)
+    uint16_t targetAngle;
+    bool isRunning;
+    bool motorEnabled;
+    SplashState() : dirty(true), filteredCdeg(-1), shownCdeg(-1), targetAngle(0), isRunning(false), motorEnabled(false) {}
+  };
+  struct MenuScreenState {
+    bool dirty;
+    const MenuNode* node;  // Вузол, що показано
+    uint8_t selectedItem;
+    uint16_t value;
+    uint8_t digitMode;
+    MenuScreenState() : dirty(true), node(nullptr), selectedItem(0), value(0), digitMode(0) {}
+  };
+  
   #if LCD_MODE == 0
     LiquidCrystal* _lcd;
   #else
-    LiquidCrystal_I2C* _lcd;
+    LcdI2c* _lcd;
   #endif
   
   uint8_t _cols;
   uint8_t _rows;
-  uint16_t _lastDeg;
-  uint16_t _lastTargetDeg;
-  unsigned long _lastUpdate;
+  uint8_t _i2cAddress;
+  uint32_t _busClockHz;
+  DisplayBuffer _frame;  // Що має бути на екрані
+  char _shown[DisplayBuffer::MAX_ROWS][DisplayBuffer::MAX_COLS];  // Що зараз на дисплеї
+  uint8_t _lcdCol;  // Позиція курсора дисплея після останнього запису (255 - невідома)
+  uint8_t _lcdRow;
+  char _pending[DisplayBuffer::MAX_ROWS][DisplayBuffer::MAX_COLS];  // Знімок кадру, що зараз відправляється
+  uint16_t _pendingStamp[DisplayBuffer::MAX_ROWS];  // Коли рядки знімка змінювались (порядок відправки)
+  bool _sending;  // Знімок ще не відправлено повністю
+  uint8_t _flushRow;  // Рядок знімка, що відправляється (255 - вибрати наступний)
+  uint8_t _flushCol;  // З якого стовпця продовжити
   bool _messageShown;
   unsigned long _messageStartTime;
   bool _isI2C;
-  bool _setAngleNeedsRedraw;
+  ScreenId _screen;
+  SplashState _splash;
+  MenuScreenState _menuScreen;
   
-  void drawFull(uint32_t position, uint32_t steps360);
-  void drawAngleOnly(uint32_t position, uint32_t steps360);
-  void drawWithTarget(uint32_t position, uint32_t steps360, uint16_t targetAngle);
-  void printAt(uint8_t col, uint8_t row, const char* text);
+  void selectBusClock();  // 400 кГц, якщо модуль проходить перевірку, інакше 100 кГц
+  bool probeBus();
+  void setBusClock(uint32_t hz);
+  void createDegreeChar();
+  void invalidate();  // Вміст дисплея невідомий - наступні flush() перемальовують усе
+  bool isLcdReady();  // Веде повторну ініціалізацію дисплея після помилки шини; false - писати ще не можна
+  bool isFlushed();  // Буфер повністю на дисплеї і передача завершена
+  void flushAll();  // Блокуюче відправлення всього буфера (тільки для вимірювань)
   void printAt(uint8_t col, uint8_t row, uint16_t value);
-  void printAt(uint8_t col, uint8_t row, float value, uint8_t decimals = 2);
-  void printMenuItem(uint8_t row, uint8_t itemIndex, const char* text, bool selected);
+  void printCdegAt(uint8_t col, uint8_t row, uint16_t cdeg);  // Кут у сотих градуса як "123.45"
+  void printMenuItem(uint8_t row, const char* label, bool selected);  // label - у PROGMEM
+  void printRow(uint8_t row, const char* text);  // Рядок повністю: текст і пробіли до кінця
+  void printRow(uint8_t row, const __FlashStringHelper* text);  // Те саме для рядка з flash
+  void clearRow(uint8_t row);
+  void startMessage();  // Позначає, що на екрані повідомлення
+  bool enterScreen(ScreenId screen);  // true, якщо екран змінився і його треба малювати повністю
+  bool isMessageShown();
 };
 
 #endif
@@ -2,8 +2,18 @@
 
 Encoder* Encoder::_instance = nullptr;
 
+// Зміна лічильника для переходу (попередній стан << 2) | новий стан, стан = (A << 1) | B.
+// Переходи, в яких змінились обидва сигнали (пропущено фронт), дають 0
+static const int8_t TRANSITION_TABLE[16] = {
+   0, +1, -1,  0,
+  -1,  0,  0, +1,
+  +1,  0,  0, -1,
+   0, -1, +1,  0
+};
+
 Encoder::Encoder(uint8_t pinA, uint8_t pinB) 
-  : _pinA(pinA), _pinB(pinB), _delta(0) {
+  : _pinA(pinA), _pinB(pinB), _delta(0), _state(0), _subSteps(0),
+    _lastDetentUs(0), _detentIntervalUs(0), _lastDirection(0) {
   _instance = this;
 }
 
@@ -11,8 +21,17 @@ void Encoder::begin() {
   pinMode(_pinA, INPUT_PULLUP);
   pinMode(_pinB, INPUT_PULLUP);
   
-  attachInterrupt(digitalPinToInterrupt(_pinA), isrA, CHANGE);
-  attachInterrupt(digitalPinToInterrupt(_pinB), isrB, CHANGE);
+#if defined(__AVR__)
+  // Регістри та маски визначаємо один раз, у перериванні - тільки читання порту
+  _inA = portInputRegister(digitalPinToPort(_pinA));
+  _inB = portInputRegister(digitalPinToPort(_pinB));
+  _maskA = digitalPinToBitMask(_pinA);
+  _maskB = digitalPinToBitMask(_pinB);
+#endif
+  _state = readState();
+  
+  attachInterrupt(digitalPinToInterrupt(_pinA), isr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(_pinB), isr, CHANGE);
 }
 
 int16_t Encoder::read() {
@@ -30,28 +49,84 @@ int16_t Encoder::getDelta() {
   return d;
 }
 
-void Encoder::isrA() {
-  if (_instance) {
-    _instance->handleA();
+uint16_t Encoder::getSpeed() {
+  noInterrupts();
+  unsigned long last = _lastDetentUs;
+  unsigned long interval = _detentIntervalUs;
+  interrupts();
+  
+  // Давно не було клацань - енкодер зупинився, старий інтервал вже не актуальний
+  if (interval == 0 || micros() - last > ENCODER_SPEED_TIMEOUT_MS * 1000UL) {
+    return 0;
   }
+  return (uint16_t)(1000000UL / interval);
 }
 
-void Encoder::isrB() {
+void Encoder::isr() {
   if (_instance) {
-    _instance->handleB();
+    _instance->handleChange();
+  }
+}
+
+uint8_t Encoder::readState() {
+#if defined(__AVR__)
+  if (_inA == _inB) {
+    // Обидва піни на одному порту - одне читання (на Nano/Uno та Mega піни 2 і 3 саме такі)
+    uint8_t port = *_inA;
+    return ((port & _maskA) ? 2 : 0) | ((port & _maskB) ? 1 : 0);
   }
+  return ((*_inA & _maskA) ? 2 : 0) | ((*_inB & _maskB) ? 1 : 0);
+#else
+  return (digitalRead(_pinA) ? 2 : 0) | (digitalRead(_pinB) ? 1 : 0);
+#endif
 }
 
-void Encoder::handleA() {
-  if (digitalRead(_pinA) == digitalRead(_pinB))
-    _delta++;
-  else
-    _delta--;
+void Encoder::handleChange() {
+  uint8_t state = readState();
+  int8_t step = TRANSITION_TABLE[(_state << 2) | state];
+  _state = state;
+  
+#if ENCODER_STEPS_PER_DETENT == 1
+  if (step != 0) {
+    countDetent(step);
+  }
+#else
+  _subSteps += step;
+  
+  // Клацання зараховується в положенні фіксації (обидва сигнали HIGH, для 2 переходів на клацання - також обидва LOW),
+  // якщо до нього пройдено більше половини переходів: брязкіт (+1 -1) взаємно знищується,
+  // а при 4 переходах на клацання один пропущений фронт не губить клацання (3 з 4)
+#if ENCODER_STEPS_PER_DETENT == 2
+  bool detent = (state == 0x03 || state == 0x00);
+#else
+  bool detent = (state == 0x03);
+#endif
+  if (detent) {
+    if (_subSteps > ENCODER_STEPS_PER_DETENT / 2) {
+      countDetent(1);
+    } else if (_subSteps < -(ENCODER_STEPS_PER_DETENT / 2)) {
+      countDetent(-1);
+    }
+    _subSteps = 0;
+  }
+#endif
 }
 
-void Encoder::handleB() {
-  if (digitalRead(_pinA) != digitalRead(_pinB))
-    _delta++;
-  else
-    _delta--;
+void Encoder::countDetent(int8_t direction) {
+  _delta += direction;
+  
+  unsigned long now = micros();
+  unsigned long interval = now - _lastDetentUs;
+  _lastDetentUs = now;
+  
+  if (direction != _lastDirection || interval > ENCODER_SPEED_TIMEOUT_MS * 1000UL) {
+    // Перше клацання після паузи або зміни напрямку - швидкість ще невідома
+    _detentIntervalUs = 0;
+  } else if (_detentIntervalUs == 0) {
+    _detentIntervalUs = interval;
+  } else {
+    // Середнє з попереднім інтервалом: одне нерівне клацання не смикає швидкість
+    _detentIntervalUs = (_detentIntervalUs + interval) / 2;
+  }
+  _lastDirection = direction;
 }
@@ -2,24 +2,40 @@
 #define ENCODER_H
 
 #include <Arduino.h>
+#include "config.h"
 
+// Квадратурний декодер на таблиці переходів коду Грея: обидва піни читаються
+// одним читанням порту (якщо вони на одному порту), неможливі переходи (змінились
+// обидва сигнали) відкидаються, а лічильник змінюється на 1 за клацання (ENCODER_STEPS_PER_DETENT)
 class Encoder {
 public:
   Encoder(uint8_t pinA, uint8_t pinB);
   void begin();
-  int16_t read();  // Читає та скидає дельту
+  int16_t read();  // Читає та скидає дельту (у клацаннях)
   int16_t getDelta();  // Читає дельту без скидання
+  uint16_t getSpeed();  // Швидкість обертання (клацань/с) за часом між клацаннями, 0 - енкодер стоїть
   
 private:
   uint8_t _pinA;
   uint8_t _pinB;
   volatile int16_t _delta;
+  uint8_t _state;  // Останній стан пінів: (A << 1) | B
+  int8_t _subSteps;  // Переходи від останнього положення фіксації
+  volatile unsigned long _lastDetentUs;  // Час останнього клацання (micros)
+  volatile unsigned long _detentIntervalUs;  // Згладжений інтервал між клацаннями (0 - невідомий)
+  int8_t _lastDirection;  // Напрямок останнього клацання
+#if defined(__AVR__)
+  volatile uint8_t* _inA;  // Регістри PINx для швидкого читання в перериванні
+  volatile uint8_t* _inB;
+  uint8_t _maskA;
+  uint8_t _maskB;
+#endif
   
   static Encoder* _instance;
-  static void isrA();
-  static void isrB();
-  void handleA();
-  void handleB();
+  static void isr();
+  uint8_t readState();
+  void handleChange();
+  void countDetent(int8_t direction);
 };
 
 #endif
@@ -0,0 +1,109 @@
+#include "encoder_calibration.h"
+
+EncoderCalibration::EncoderCalibration(Stepper& stepper, AbsoluteEncoder& encoder)
+  : _stepper(stepper), _encoder(encoder), _state(STATE_IDLE), _point(0),
+    _idleSince(0), _wasIdle(false) {
+  for (uint8_t i = 0; i < ABS_ENC_CAL_POINTS; i++) {
+    _measured[i] = 0;
+    _table[i] = 0;
+  }
+}
+
+int32_t EncoderCalibration::wrapDiff(int32_t diff) const {
+  int32_t fullScale = _encoder.getMaxAngleCdeg();
+  while (diff > fullScale / 2) diff -= fullScale;
+  while (diff < -fullScale / 2) diff += fullScale;
+  return diff;
+}
+
+uint16_t EncoderCalibration::wrapAngle(int32_t angle) const {
+  int32_t fullScale = _encoder.getMaxAngleCdeg();
+  while (angle < 0) angle += fullScale;
+  while (angle >= fullScale) angle -= fullScale;
+  return (uint16_t)angle;
+}
+
+void EncoderCalibration::start() {
+  _point = 0;
+  _wasIdle = false;
+  _state = STATE_SETTLE;
+}
+
+void EncoderCalibration::update(unsigned long now) {
+  if (_state != STATE_SETTLE) {
+    return;
+  }
+  
+  // Чекаємо, поки двигун зупиниться, і ще ABS_ENC_CAL_SETTLE_MS на заспокоєння
+  if (_stepper.getRemaining() != 0) {
+    _wasIdle = false;
+    return;
+  }
+  // Кут читається на кожному виклику паузи: поза AVR фільтр отримує зразок тільки при читанні,
+  // і до кінця паузи в ньому лишаються зразки нового положення, а не попередньої точки
+  uint16_t cdeg = _encoder.readRawAngleCdeg();
+  if (!_wasIdle) {
+    _wasIdle = true;
+    _idleSince = now;
+  }
+  if (now - _idleSince < ABS_ENC_CAL_SETTLE_MS) {
+    return;
+  }
+  
+  _measured[_point] = cdeg;
+  _point++;
+  
+  if (_point >= ABS_ENC_CAL_POINTS) {
+    // Доїжджаємо останній сегмент, щоб стіл повернувся у вихідне положення
+    _stepper.move(STEPS_PER_POINT);
+    buildTable();
+    _state = STATE_DONE;
+    return;
+  }
+  
+  _stepper.move(STEPS_PER_POINT);
+  _wasIdle = false;
+}
+
+void EncoderCalibration::buildTable() {
+  // Напрямок зростання кута енкодера відносно кроків двигуна
+  int8_t sign = (wrapDiff((int32_t)_measured[1] - _measured[0]) >= 0) ? 1 : -1;
+  int32_t segment = _encoder.getMaxAngleCdeg() / ABS_ENC_CAL_POINTS;  // Як вузли в AbsoluteEncoder::applyCalibration
+  
+  // Поправка в кожній виміряній точці: справжній кут (за двигуном) мінус виміряний
+  // (перша точка - опорна, в ній поправка нульова)
+  int16_t errors[ABS_ENC_CAL_POINTS];
+  for (uint8_t k = 0; k < ABS_ENC_CAL_POINTS; k++) {
+    int32_t truth = (int32_t)_measured[0] + sign * (int32_t)k * segment;
+    errors[k] = (int16_t)wrapDiff(truth - _measured[k]);
+  }
+  
+  // Перераховуємо поправки у рівномірні вузли сирого кута j * segment:
+  // шукаємо найближчі виміряні точки зліва та справа від вузла і інтерполюємо
+  for (uint8_t j = 0; j < ABS_ENC_CAL_POINTS; j++) {
+    uint16_t knot = (uint16_t)(j * segment);
+    uint8_t below = 0;
+    uint8_t above = 0;
+    uint16_t distBelow = 0xFFFF;
+    uint16_t distAbove = 0xFFFF;
+    for (uint8_t k = 0; k < ABS_ENC_CAL_POINTS; k++) {
+      uint16_t forward = wrapAngle((int32_t)knot - _measured[k]);  // Точка k лежить зліва на цю відстань
+      uint16_t backward = wrapAngle((int32_t)_measured[k] - knot);  // Точка k лежить справа на цю відстань
+      if (forward < distBelow) {
+        distBelow = forward;
+        below = k;
+      }
+      if (backward != 0 && backward < distAbove) {
+        distAbove = backward;
+        above = k;
+      }
+    }
+    
+    uint32_t span = (uint32_t)distBelow + distAbove;
+    if (span == 0) {
+      _table[j] = errors[below];
+    } else {
+      _table[j] = (int16_t)(errors[below] + ((int32_t)(errors[above] - errors[below]) * (int32_t)distBelow) / (int32_t)span);
+    }
+  }
+}
@@ -0,0 +1,46 @@
+#ifndef ENCODER_CALIBRATION_H
+#define ENCODER_CALIBRATION_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "stepper.h"
+#include "absolute_encoder.h"
+
+// Неблокуюча процедура калібрування абсолютного енкодера.
+// Стіл робить повний оберт кроковим двигуном з зупинками в ABS_ENC_CAL_POINTS точках;
+// у кожній точці кут енкодера порівнюється з кутом, пройденим двигуном, і з розбіжностей
+// будується таблиця поправок у рівномірних вузлах сирого кута (для AbsoluteEncoder::setCalibration)
+class EncoderCalibration {
+public:
+  EncoderCalibration(Stepper& stepper, AbsoluteEncoder& encoder);
+  void start();
+  void update(unsigned long now);  // Викликається з loop(), поки isActive()
+  bool isActive() const { return _state != STATE_IDLE && _state != STATE_DONE; }
+  bool isDone() const { return _state == STATE_DONE; }
+  uint8_t getProgress() const { return _point; }  // Кількість виміряних точок
+  const int16_t* getTable() const { return _table; }
+  
+private:
+  enum State {
+    STATE_IDLE,
+    STATE_SETTLE,   // Чекаємо зупинки двигуна та заспокоєння фільтра
+    STATE_DONE
+  };
+  
+  Stepper& _stepper;
+  AbsoluteEncoder& _encoder;
+  State _state;
+  uint8_t _point;
+  unsigned long _idleSince;
+  bool _wasIdle;
+  uint16_t _measured[ABS_ENC_CAL_POINTS];  // Сирі кути енкодера в точках (соті градуса)
+  int16_t _table[ABS_ENC_CAL_POINTS];
+  
+  static const int32_t STEPS_PER_POINT = STEPS_360 / ABS_ENC_CAL_POINTS;
+  
+  void buildTable();
+  int32_t wrapDiff(int32_t diff) const;  // Різниця кутів у межах ± половини шкали енкодера
+  uint16_t wrapAngle(int32_t angle) const;  // Кут у межах шкали енкодера (0-35999 для 360°)
+};
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef FAST_PIN_H
+#define FAST_PIN_H
+
+#include <Arduino.h>
+
+// Швидкий доступ до пінів через регістри портів AVR.
+// Порт і біт визначаються на етапі компіляції з номера піна Arduino (STEP_PIN, DIR_PIN тощо),
+// тому high()/low() компілюються в одну інструкцію sbi/cbi (2 такти, 0.125 мкс при 16 МГц)
+// замість digitalWrite() (пошук у таблицях PROGMEM, перевірка PWM, cli - близько 50-60 тактів, ~3.5 мкс).
+// Порти H-L на ATmega2560 лежать поза зоною sbi/cbi - там запис виконується
+// як читання-модифікація-запис із забороною переривань (~8 тактів).
+// Для інших платформ використовується digitalWrite()/digitalRead().
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__)
+  #define FAST_PIN_AVAILABLE 1
+  // Таблиці для Nano/Uno: D0-D7 = PORTD, D8-D13 = PORTB, A0-A5 (14-19) = PORTC
+  #define FAST_PIN_PORTS "DDDDDDDDBBBBBBCCCCCC"
+  #define FAST_PIN_BITS  "01234567012345012345"
+  #define FAST_PIN_COUNT 20
+#elif defined(__AVR_ATmega2560__) || defined(__AVR_ATmega1280__)
+  #define FAST_PIN_AVAILABLE 1
+  // Таблиці для Mega (відповідають pins_arduino.h варіанту "mega")
+  #define FAST_PIN_PORTS "EEEEGEHHHHBBBBJJHHDDDDAAAAAAAACCCCCCCCDGGGLLLLLLLLBBBBFFFFFFFFKKKKKKKK"
+  #define FAST_PIN_BITS  "0145533456456710103210012345677654321072107654321032100123456701234567"
+  #define FAST_PIN_COUNT 70
+#else
+  #define FAST_PIN_AVAILABLE 0
+#endif
+
+#if FAST_PIN_AVAILABLE
+
+constexpr char fastPinPort(uint8_t pin) {
+  return pin < FAST_PIN_COUNT ? FAST_PIN_PORTS[pin] : 0;
+}
+
+constexpr uint8_t fastPinMask(uint8_t pin) {
+  return pin < FAST_PIN_COUNT ? (uint8_t)(1 << (FAST_PIN_BITS[pin] - '0')) : 0;
+}
+
+// Регістри порту за його літерою. ATOMIC = true, якщо порт доступний для sbi/cbi
+template <char PORT> struct FastPort;
+
+#define FAST_PIN_DEFINE_PORT(letter, atomic) \
+  template <> struct FastPort<#letter[0]> { \
+    static const bool ATOMIC = atomic; \
+    static volatile uint8_t& out() { return PORT##letter; } \
+    static volatile uint8_t& in() { return PIN##letter; } \
+  };
+
+#ifdef PORTA
+FAST_PIN_DEFINE_PORT(A, true)
+#endif
+#ifdef PORTB
+FAST_PIN_DEFINE_PORT(B, true)
+#endif
+#ifdef PORTC
+FAST_PIN_DEFINE_PORT(C, true)
+#endif
+#ifdef PORTD
+FAST_PIN_DEFINE_PORT(D, true)
+#endif
+#ifdef PORTE
+FAST_PIN_DEFINE_PORT(E, true)
+#endif
+#ifdef PORTF
+FAST_PIN_DEFINE_PORT(F, true)
+#endif
+#ifdef PORTG
+FAST_PIN_DEFINE_PORT(G, true)
+#endif
+#ifdef PORTH
+FAST_PIN_DEFINE_PORT(H, false)
+#endif
+#ifdef PORTJ
+FAST_PIN_DEFINE_PORT(J, false)
+#endif
+#ifdef PORTK
+FAST_PIN_DEFINE_PORT(K, false)
+#endif
+#ifdef PORTL
+FAST_PIN_DEFINE_PORT(L, false)
+#endif
+
+#undef FAST_PIN_DEFINE_PORT
+
+template <uint8_t PIN>
+class FastPin {
+public:
+  typedef FastPort<fastPinPort(PIN)> Port;
+  static const uint8_t MASK = fastPinMask(PIN);
+  
+  static inline void high() {
+    if (Port::ATOMIC) {
+      Port::out() |= MASK;  // sbi
+    } else {
+      uint8_t oldSREG = SREG;
+      cli();
+      Port::out() |= MASK;
+      SREG = oldSREG;
+    }
+  }
+  
+  static inline void low() {
+    if (Port::ATOMIC) {
+      Port::out() &= (uint8_t)~MASK;  // cbi
+    } else {
+      uint8_t oldSREG = SREG;
+      cli();
+      Port::out() &= (uint8_t)~MASK;
+      SREG = oldSREG;
+    }
+  }
+  
+  static inline void write(bool value) {
+    if (value) high(); else low();
+  }
+  
+  static inline bool read() {
+    return (Port::in() & MASK) != 0;
+  }
+};
+
+#else
+
+// Резервний варіант для не-AVR плат: стандартні функції Arduino
+template <uint8_t PIN>
+class FastPin {
+public:
+  static inline void high() { digitalWrite(PIN, HIGH); }
+  static inline void low() { digitalWrite(PIN, LOW); }
+  static inline void write(bool value) { digitalWrite(PIN, value ? HIGH : LOW); }
+  static inline bool read() { return digitalRead(PIN) == HIGH; }
+};
+
+#endif
+
+#endif
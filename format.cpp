@@ -0,0 +1,21 @@
+#include "format.h"
+
+uint8_t formatFixed(char* buffer, uint16_t value, uint8_t decimals) {
+  // Цифри у зворотному порядку; щонайменше decimals + 1, щоб завжди був ведучий нуль ("0.05")
+  char digits[5];
+  uint8_t count = 0;
+  do {
+    digits[count++] = '0' + value % 10;
+    value /= 10;
+  } while ((value > 0 || count <= decimals) && count < sizeof(digits));
+  
+  uint8_t length = 0;
+  while (count > 0) {
+    if (count == decimals) {
+      buffer[length++] = '.';
+    }
+    buffer[length++] = digits[--count];
+  }
+  buffer[length] = '\0';
+  return length;
+}
@@ -0,0 +1,12 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <Arduino.h>
+
+// Цілочисельне форматування чисел з фіксованою комою для дисплея (без float і Print::print(double))
+// formatFixed(buf, 12345, 2) -> "123.45", formatFixed(buf, 5, 2) -> "0.05"
+// Буфер має вміщувати щонайменше 8 символів (5 цифр, кома, ведучий нуль, '\0').
+// Повертає кількість записаних символів (без завершального '\0').
+uint8_t formatFixed(char* buffer, uint16_t value, uint8_t decimals);
+
+#endif
@@ -0,0 +1,187 @@
+#include "input_scanner.h"
+
+InputScanner* InputScanner::_instance = nullptr;
+
+#if defined(__AVR__)
+ISR(TIMER0_COMPB_vect) {
+  InputScanner::tickIsr();
+}
+#endif
+
+// Піни та часові параметри кнопок (порядок - як у InputButton)
+const InputScanner::ButtonConfig InputScanner::BUTTONS[INPUT_BUTTON_COUNT] = {
+  { ENC_BTN, LONG_PRESS_THRESHOLD_MS, 0, 0 },
+  { DIGIT_MODE_BUTTON_PIN, 0, 0, 0 },
+  { ENCODER_ZERO_BUTTON_PIN, 0, 0, 0 },
+  { STEP_FINE_ADJUST_BUTTON_PIN, 0, STEP_BUTTON_LONG_PRESS_MS, STEP_BUTTON_REPEAT_DELAY_MS },
+  { START_STOP_BUTTON_PIN, 0, 0, 0 }
+};
+
+InputScanner::InputScanner()
+  : _debounced(0), _count0(0xFF), _count1(0xFF), _sampleDivider(INPUT_DEBOUNCE_SAMPLE_MS),
+    _sampleMs(INPUT_DEBOUNCE_SAMPLE_MS), _head(0), _tail(0), _overflowCount(0) {
+#if !defined(__AVR__)
+  _lastTickTime = 0;
+#endif
+  for (uint8_t i = 0; i < INPUT_BUTTON_COUNT; i++) {
+    _heldMs[i] = 0;
+    _repeatInMs[i] = 0;
+    _longPressMs[i] = BUTTONS[i].longPressMs;
+  }
+  _instance = this;
+}
+
+void InputScanner::begin() {
+  for (uint8_t i = 0; i < INPUT_BUTTON_COUNT; i++) {
+    pinMode(BUTTONS[i].pin, INPUT_PULLUP);
+#if defined(__AVR__)
+    _inputs[i] = portInputRegister(digitalPinToPort(BUTTONS[i].pin));
+    _masks[i] = digitalPinToBitMask(BUTTONS[i].pin);
+#endif
+  }
+  delayMicroseconds(10);  // Підтяжка встигає зарядити вхід
+
+  // Кнопки, натиснуті при старті, вважаються стабільно натиснутими, але без події PRESS;
+  // позначка HELD_SINCE_BOOT не дає LONG/REPEAT, а відпускання не сприймається як коротке натискання
+  _debounced = samplePins();
+  for (uint8_t i = 0; i < INPUT_BUTTON_COUNT; i++) {
+    _heldMs[i] = (_debounced & (1 << i)) ? HELD_SINCE_BOOT : 0;
+  }
+
+#if defined(__AVR__)
+  // Timer0 вже працює для millis() (переповнення кожні 1.024 мс при 16 МГц);
+  // переривання за збігом каналу B посередині періоду дає такт з тією ж частотою
+  noInterrupts();
+  OCR0B = 0x80;
+  TIFR0 = _BV(OCF0B);
+  TIMSK0 |= _BV(OCIE0B);
+  interrupts();
+#else
+  _lastTickTime = millis();
+#endif
+}
+
+void InputScanner::update() {
+#if !defined(__AVR__)
+  // Опитувальний режим: наздоганяємо такти, що пройшли з попереднього виклику
+  unsigned long now = millis();
+  while (now - _lastTickTime >= 1) {
+    _lastTickTime++;
+    tick();
+  }
+#endif
+}
+
+void InputScanner::tickIsr() {
+  if (_instance) {
+    _instance->tick();
+  }
+}
+
+uint8_t InputScanner::samplePins() {
+  uint8_t pressed = 0;
+  for (uint8_t i = 0; i < INPUT_BUTTON_COUNT; i++) {
+#if defined(__AVR__)
+    if (!(*_inputs[i] & _masks[i])) {
+#else
+    if (!digitalRead(BUTTONS[i].pin)) {
+#endif
+      pressed |= (1 << i);  // INPUT_PULLUP: LOW = натиснуто
+    }
+  }
+  return pressed;
+}
+
+void InputScanner::tick() {
+  uint8_t changed = 0;
+  if (--_sampleDivider == 0) {
+    _sampleDivider = _sampleMs;
+
+    // Векторні лічильники: для кожної кнопки, чий зразок відрізняється від стабільного стану,
+    // 2-бітний лічильник (_count1:_count0) рахує 3 -> 2 -> 1 -> 0 і на четвертому зразку
+    // стан перемикається; будь-який збіг зі стабільним станом скидає лічильник у 3
+    changed = _debounced ^ samplePins();
+    _count0 = ~(_count0 & changed);
+    _count1 = _count0 ^ (_count1 & changed);
+    changed &= _count0 & _count1;
+    _debounced ^= changed;
+  }
+
+  uint8_t debounced = _debounced;
+  for (uint8_t i = 0; i < INPUT_BUTTON_COUNT; i++) {
+    uint8_t bit = 1 << i;
+    if (changed & bit) {
+      if (debounced & bit) {
+        _heldMs[i] = 0;
+        _repeatInMs[i] = BUTTONS[i].repeatDelayMs;
+        push(i, INPUT_EVENT_PRESS, 0);
+      } else {
+        push(i, INPUT_EVENT_RELEASE, _heldMs[i]);
+      }
+    } else if ((debounced & bit) && _heldMs[i] != HELD_SINCE_BOOT) {
+      // Час утримання насичується, а автоповтор відлічується окремо і триває, скільки кнопку тримають
+      uint16_t held = _heldMs[i];
+      if (held < HELD_MS_MAX) {
+        _heldMs[i] = ++held;
+        if (held == _longPressMs[i]) {
+          push(i, INPUT_EVENT_LONG, held);
+        }
+      }
+      if (BUTTONS[i].repeatDelayMs != 0 && --_repeatInMs[i] == 0) {
+        push(i, INPUT_EVENT_REPEAT, held);
+        _repeatInMs[i] = BUTTONS[i].repeatIntervalMs;
+      }
+    }
+  }
+}
+
+void InputScanner::push(uint8_t button, uint8_t type, uint16_t duration) {
+  uint8_t next = (_head + 1) & (QUEUE_SIZE - 1);
+  if (next == _tail) {
+    // Черга заповнена (loop() довго не читав) - нова подія відкидається
+    if (_overflowCount != 0xFF) {
+      _overflowCount++;
+    }
+    return;
+  }
+  _queue[_head].button = button;
+  _queue[_head].type = type;
+  _queue[_head].duration = duration;
+  _head = next;
+}
+
+bool InputScanner::read(InputEvent& event) {
+  noInterrupts();
+  if (_tail == _head) {
+    interrupts();
+    return false;
+  }
+  event = _queue[_tail];
+  _tail = (_tail + 1) & (QUEUE_SIZE - 1);
+  interrupts();
+  return true;
+}
+
+void InputScanner::clearEvents() {
+  noInterrupts();
+  _tail = _head;
+  interrupts();
+}
+
+void InputScanner::setLongPressMs(uint8_t button, uint16_t ms) {
+  noInterrupts();
+  _longPressMs[button] = ms;
+  interrupts();
+}
+
+void InputScanner::setDebounceSampleMs(uint8_t ms) {
+  if (ms == 0) ms = 1;
+  noInterrupts();
+  _sampleMs = ms;
+  if (_sampleDivider > ms) _sampleDivider = ms;
+  interrupts();
+}
+
+bool InputScanner::isHeld(uint8_t button) {
+  return (_debounced & (1 << button)) != 0;
+}
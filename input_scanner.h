@@ -0,0 +1,89 @@
+#ifndef INPUT_SCANNER_H
+#define INPUT_SCANNER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Кнопки, які опитує сканер (порядок = номер біта у векторних лічильниках)
+enum InputButton {
+  INPUT_ENCODER_BUTTON = 0,  // Кнопка енкодера (меню)
+  INPUT_DIGIT_MODE = 1,      // Перемикання розрядів
+  INPUT_ENCODER_ZERO = 2,    // Обнулення абсолютного енкодера
+  INPUT_STEP_FINE = 3,       // Рух на один крок
+  INPUT_START_STOP = 4,      // Старт-стоп
+  INPUT_BUTTON_COUNT = 5     // Не більше 8 (один байт на біт кожної кнопки)
+};
+
+enum InputEventType {
+  INPUT_EVENT_PRESS,    // Кнопку натиснуто (після debounce)
+  INPUT_EVENT_RELEASE,  // Кнопку відпущено, duration - скільки утримувалась
+  INPUT_EVENT_LONG,     // Утримується довше порогу довгого натискання (один раз)
+  INPUT_EVENT_REPEAT    // Автоповтор під час утримання
+};
+
+struct InputEvent {
+  uint8_t button;    // InputButton
+  uint8_t type;      // InputEventType
+  uint16_t duration; // Час утримання (мс) на момент події
+};
+
+// Опитування всіх кнопок з фіксованим тактом 1 мс: на AVR - переривання Timer0 COMPB
+// (Timer0 вже тактує millis(), канал B не зайнятий), поза AVR - з update() за millis().
+// Піни читаються з регістрів PINx, debounce всіх кнопок одночасно - векторні лічильники
+// (2-бітний лічильник на кнопку розкладено по двох байтах, стан змінюється після
+// 4 однакових зразків підряд з інтервалом INPUT_DEBOUNCE_SAMPLE_MS або з налаштувань).
+// Події складаються в кільцеву чергу і читаються з loop() через read().
+class InputScanner {
+public:
+  InputScanner();
+  void begin();  // Налаштовує піни та запускає такт; кнопки, утримувані при старті, не дають PRESS
+  void update();  // Поза AVR виконує пропущені такти (на AVR нічого не робить)
+  bool read(InputEvent& event);  // Наступна подія з черги; false - черга порожня
+  void clearEvents();  // Відкидає всі накопичені події
+  bool isHeld(uint8_t button);  // Стабільний (після debounce) стан кнопки
+  void setLongPressMs(uint8_t button, uint16_t ms);  // Поріг довгого натискання (0 - вимкнено)
+  void setDebounceSampleMs(uint8_t ms);  // Інтервал зразків debounce (1-255 мс)
+  uint8_t getOverflowCount() const { return _overflowCount; }  // Події, що не вмістились у чергу
+
+  static void tickIsr();  // Викликається з ISR(TIMER0_COMPB_vect)
+
+private:
+  static const uint8_t QUEUE_SIZE = 16;  // Степінь двійки
+  static const uint16_t HELD_MS_MAX = 0xFFFE;  // Насичення часу утримання
+  static const uint16_t HELD_SINCE_BOOT = 0xFFFF;  // Кнопка натиснута ще при старті - без LONG/REPEAT
+
+  struct ButtonConfig {
+    uint8_t pin;
+    uint16_t longPressMs;       // 0 - без довгого натискання
+    uint16_t repeatDelayMs;     // 0 - без автоповтору
+    uint16_t repeatIntervalMs;
+  };
+  static const ButtonConfig BUTTONS[INPUT_BUTTON_COUNT];
+
+#if defined(__AVR__)
+  volatile uint8_t* _inputs[INPUT_BUTTON_COUNT];  // Регістри PINx
+  uint8_t _masks[INPUT_BUTTON_COUNT];
+#else
+  unsigned long _lastTickTime;
+#endif
+  volatile uint8_t _debounced;  // Біт = кнопка натиснута (після debounce)
+  uint8_t _count0;  // Молодший біт векторних лічильників
+  uint8_t _count1;  // Старший біт
+  uint8_t _sampleDivider;  // Такти до наступного зразка debounce
+  uint8_t _sampleMs;  // Інтервал зразків debounce (такти)
+  uint16_t _heldMs[INPUT_BUTTON_COUNT];  // Тривалість утримання (насичується на HELD_MS_MAX)
+  uint16_t _repeatInMs[INPUT_BUTTON_COUNT];  // Скільки лишилось до наступного автоповтору (не залежить від насичення)
+  uint16_t _longPressMs[INPUT_BUTTON_COUNT];  // Поріг довгого натискання (з BUTTONS або налаштувань)
+  InputEvent _queue[QUEUE_SIZE];
+  volatile uint8_t _head;  // Куди пише переривання
+  volatile uint8_t _tail;  // Звідки читає loop()
+  volatile uint8_t _overflowCount;
+
+  static InputScanner* _instance;
+
+  uint8_t samplePins();  // Біт = пін у LOW (INPUT_PULLUP, натиснуто)
+  void tick();  // Один такт 1 мс
+  void push(uint8_t button, uint8_t type, uint16_t duration);
+};
+
+#endif
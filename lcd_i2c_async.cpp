@@ -0,0 +1,390 @@
+#include "lcd_i2c_async.h"
+
+#if defined(__AVR__) || defined(ARDUINO_HOST)
+
+#if defined(__AVR__)
+#include <util/twi.h>
+
+ISR(TWI_vect) {
+  LcdI2cAsync::twiIsr();
+}
+
+// Регістри TWI; на ПК замість них модель шини з одним PCF8574
+static inline uint8_t twiStatus() { return TW_STATUS; }
+static inline uint8_t twiControl() { return TWCR; }
+static inline void twiSetControl(uint8_t value) { TWCR = value; }
+static inline uint8_t twiData() { return TWDR; }
+static inline void twiSetData(uint8_t value) { TWDR = value; }
+static inline void twiSetBitRate(uint8_t value) { TWBR = value; }
+static inline void twiSetPrescaler(uint8_t value) { TWSR = value; }
+#else
+#include <twi.h>
+#endif
+
+LcdI2cAsync* LcdI2cAsync::_instance = nullptr;
+
+LcdI2cAsync::LcdI2cAsync(uint8_t address, uint8_t cols, uint8_t rows)
+  : _address(address), _rows(rows), _backlight(PIN_BACKLIGHT), _head(0), _tail(0),
+    _busy(false), _errorCount(0), _resyncStep(RESYNC_REQUESTED), _resyncTimed(false),
+    _resyncAtUs(0), _resyncWaitUs(0) {
+  (void)cols;
+  _instance = this;
+#if !defined(__AVR__)
+  twiAttachInterrupt(twiIsr);
+#endif
+}
+
+void LcdI2cAsync::twiIsr() {
+  if (_instance) {
+    _instance->handleTwi();
+  }
+}
+
+void LcdI2cAsync::handleTwi() {
+  switch (twiStatus()) {
+    case TW_START:
+    case TW_REP_START:
+      twiSetData((_address << 1) | TW_WRITE);
+      twiSetControl(_BV(TWINT) | _BV(TWEN) | _BV(TWIE));
+      break;
+
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      if (_tail != _head) {
+        // Поки в черзі є дані, продовжуємо ту саму транзакцію
+        twiSetData(_queue[_tail]);
+        _tail = (_tail + 1) & (QUEUE_SIZE - 1);
+        twiSetControl(_BV(TWINT) | _BV(TWEN) | _BV(TWIE));
+      } else {
+        twiSetControl(_BV(TWINT) | _BV(TWEN) | _BV(TWSTO));
+        _busy = false;
+      }
+      break;
+
+    default:
+      // Немає ACK або втрачено арбітраж
+      abortTransfer();
+      twiSetControl(_BV(TWINT) | _BV(TWEN) | _BV(TWSTO));
+      break;
+  }
+}
+
+void LcdI2cAsync::abortTransfer() {
+  // Решта черги відкидається, тому HD44780 міг отримати лише частину півбайтів - update() ініціалізує його заново
+  _tail = _head;
+  _errorCount++;
+  _resyncStep = RESYNC_REQUESTED;
+  _resyncTimed = false;
+  _busy = false;
+}
+
+void LcdI2cAsync::resetBus() {
+  // Шина не відповідає в межах тайм-ауту: вимикаємо TWI (апарат відпускає лінії) і скидаємо передачу
+  noInterrupts();
+  twiSetControl(0);
+  twiSetControl(_BV(TWEN));
+  abortTransfer();
+  interrupts();
+}
+
+void LcdI2cAsync::startTransfer() {
+  noInterrupts();
+  if (_busy || _tail == _head) {
+    interrupts();
+    return;
+  }
+  _busy = true;
+  interrupts();
+
+  if (!waitStop()) {
+    resetBus();
+    return;
+  }
+  twiSetControl(_BV(TWINT) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTA));
+}
+
+bool LcdI2cAsync::waitStop() {
+  // Попередній STOP ще може формуватися на шині
+  if (!(twiControl() & _BV(TWSTO))) {
+    return true;
+  }
+  unsigned long start = micros();
+  while (twiControl() & _BV(TWSTO)) {
+    if (micros() - start > BUS_TIMEOUT_US) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void LcdI2cAsync::enqueue(uint8_t data) {
+  uint8_t next = (_head + 1) & (QUEUE_SIZE - 1);
+  // Черга заповнена - чекаємо, поки переривання звільнить місце. Сюди доходять тільки
+  // блокуючі виклики (begin, clear, createChar): Display::flush() пише не більше, ніж getQueueFree().
+  // Байт відправляється за ~0.1 мс; якщо місце не звільнилось, передачу скинуто - черга порожня
+  if (next == _tail) {
+    unsigned long start = micros();
+    while (next == _tail) {
+      startTransfer();
+      if (micros() - start > BUS_TIMEOUT_US) {
+        resetBus();
+      }
+    }
+  }
+  _queue[_head] = data;
+  _head = next;
+}
+
+uint8_t LcdI2cAsync::getQueueDepth() {
+  noInterrupts();
+  uint8_t depth = (_head - _tail) & (QUEUE_SIZE - 1);
+  interrupts();
+  return depth;
+}
+
+uint8_t LcdI2cAsync::getQueueFree() {
+  // Одна комірка завжди порожня - інакше повна черга не відрізнялась би від порожньої
+  return QUEUE_SIZE - 1 - getQueueDepth();
+}
+
+bool LcdI2cAsync::isIdle() {
+  noInterrupts();
+  bool idle = !_busy && _tail == _head;
+  interrupts();
+  return idle;
+}
+
+bool LcdI2cAsync::waitIdle() {
+  startTransfer();
+  unsigned long start = micros();
+  while (!isIdle()) {
+    if (micros() - start > IDLE_TIMEOUT_US) {
+      resetBus();
+      return false;
+    }
+  }
+  return true;
+}
+
+void LcdI2cAsync::writeNibble(uint8_t nibble) {
+  // Дані виставляються, потім строб E: HD44780 забирає півбайт по спаду E
+  enqueue(nibble | _backlight);
+  enqueue(nibble | PIN_EN | _backlight);
+  enqueue((nibble & ~PIN_EN) | _backlight);
+}
+
+void LcdI2cAsync::send(uint8_t value, uint8_t mode) {
+  writeNibble((value & 0xF0) | mode);
+  writeNibble(((value << 4) & 0xF0) | mode);
+}
+
+void LcdI2cAsync::command(uint8_t value) {
+  send(value, 0);
+  startTransfer();
+}
+
+size_t LcdI2cAsync::write(uint8_t value) {
+  // Поки триває повторна ініціалізація, дані відкидаються (Display перемалює екран після неї)
+  if (!isReady()) {
+    return 0;
+  }
+  send(value, PIN_RS);
+  startTransfer();
+  return 1;
+}
+
+void LcdI2cAsync::begin(uint8_t cols, uint8_t rows) {
+  (void)cols;
+  _rows = rows;
+
+  // TWI: дільник 1, внутрішні підтяжки на SDA/SCL (як у Wire)
+  digitalWrite(LCD_I2C_SDA, HIGH);
+  digitalWrite(LCD_I2C_SCL, HIGH);
+  twiSetPrescaler(0);
+  twiSetControl(_BV(TWEN));
+  setClock(LCD_I2C_CLOCK_HZ);
+
+  // Та сама послідовність, що й після помилки, але з паузами на місці: не більше RESYNC_DONE кроків,
+  // кожен обмежений тайм-аутом шини. Якщо модуль не відповідає, ініціалізація продовжиться з update()
+  uint16_t errors = _errorCount;
+  _resyncStep = RESYNC_REQUESTED;
+  _resyncTimed = false;
+  while (_errorCount == errors) {
+    resyncStep(_resyncStep);
+    if (isReady() || !waitIdle()) {
+      break;
+    }
+    delay(_resyncWaitUs / 1000);
+    delayMicroseconds(_resyncWaitUs % 1000);
+  }
+}
+
+bool LcdI2cAsync::update() {
+  if (isReady()) {
+    return false;
+  }
+  startTransfer();
+  if (!isIdle()) {
+    return false;
+  }
+  // Пауза кроку відлічується від кінця передачі - HD44780 виконує команду після строба
+  if (!_resyncTimed) {
+    _resyncAtUs = micros();
+    _resyncTimed = true;
+    return false;
+  }
+  if (micros() - _resyncAtUs < _resyncWaitUs) {
+    return false;
+  }
+  resyncStep(_resyncStep);
+  return isReady();
+}
+
+void LcdI2cAsync::resyncStep(uint8_t step) {
+  // Наступний крок записується до передачі: помилка в ній поверне ініціалізацію на початок
+  _resyncStep = step + 1;
+  _resyncTimed = false;
+  switch (step) {
+    case RESYNC_REQUESTED:
+      // Порт у стан E = 0; після ввімкнення живлення HD44780 потрібно щонайменше 40 мс
+      enqueue(_backlight);
+      _resyncWaitUs = 50000;
+      break;
+
+    case RESYNC_NIBBLE_1:
+    case RESYNC_NIBBLE_2:
+      // Послідовність з даташиту HD44780 (як у LiquidCrystal_I2C)
+      writeNibble(0x03 << 4);
+      _resyncWaitUs = 4500;
+      break;
+
+    case RESYNC_NIBBLE_3:
+      writeNibble(0x03 << 4);
+      _resyncWaitUs = 150;
+      break;
+
+    case RESYNC_FUNCTION:
+      writeNibble(0x02 << 4);
+      command(0x20 | ((_rows > 1) ? 0x08 : 0x00));  // 4 біти, кількість рядків, шрифт 5x8
+      command(0x0C);  // Дисплей увімкнено, курсор вимкнено
+      command(0x01);  // Очищення (~1.5 мс)
+      _resyncWaitUs = 2000;
+      break;
+
+    case RESYNC_ENTRY_MODE:
+      command(0x06);  // Зсув курсора вправо, без зсуву екрану
+      command(0x02);  // Курсор на початок
+      _resyncWaitUs = 2000;
+      break;
+
+    default:  // RESYNC_DONE
+      _resyncStep = RESYNC_NONE;
+      return;
+  }
+  startTransfer();
+}
+
+void LcdI2cAsync::setClock(uint32_t hz) {
+  waitIdle();
+  // Дільник 1: f = F_CPU / (16 + 2 * TWBR)
+  twiSetBitRate(((F_CPU / hz) - 16) / 2);
+}
+
+bool LcdI2cAsync::probeStep(uint8_t control, uint8_t expectedStatus) {
+  twiSetControl(control);
+  unsigned long start = micros();
+  while (!(twiControl() & _BV(TWINT))) {
+    if (micros() - start > BUS_TIMEOUT_US) {
+      return false;
+    }
+  }
+  return twiStatus() == expectedStatus;
+}
+
+bool LcdI2cAsync::probe() {
+  // START одразу після STOP останньої транзакції став би повторним - чекаємо, поки STOP завершиться
+  if (!waitIdle()) {
+    return false;
+  }
+  if (!waitStop()) {
+    resetBus();
+    return false;
+  }
+  
+  // Записуємо в порт поточний стан (E = 0, дисплей не реагує) і читаємо його назад:
+  // при R/W = 0 HD44780 не керує лініями даних, тому прочитане має збігтися із записаним.
+  // Опитування TWINT без TWIE - переривання в цей час не спрацьовує
+  uint8_t written = _backlight;
+  bool ok = probeStep(_BV(TWINT) | _BV(TWSTA) | _BV(TWEN), TW_START);
+  if (ok) {
+    twiSetData((_address << 1) | TW_WRITE);
+    ok = probeStep(_BV(TWINT) | _BV(TWEN), TW_MT_SLA_ACK);
+  }
+  if (ok) {
+    twiSetData(written);
+    ok = probeStep(_BV(TWINT) | _BV(TWEN), TW_MT_DATA_ACK);
+  }
+  if (ok) {
+    ok = probeStep(_BV(TWINT) | _BV(TWSTA) | _BV(TWEN), TW_REP_START);
+  }
+  if (ok) {
+    twiSetData((_address << 1) | TW_READ);
+    ok = probeStep(_BV(TWINT) | _BV(TWEN), TW_MR_SLA_ACK);
+  }
+  if (ok) {
+    // Один байт без ACK - кінець читання
+    ok = probeStep(_BV(TWINT) | _BV(TWEN), TW_MR_DATA_NACK) && twiData() == written;
+  }
+  
+  twiSetControl(_BV(TWINT) | _BV(TWEN) | _BV(TWSTO));
+  unsigned long start = micros();
+  while ((twiControl() & _BV(TWSTO)) && micros() - start < BUS_TIMEOUT_US) {
+  }
+  return ok;
+}
+
+void LcdI2cAsync::clear() {
+  if (!isReady()) {
+    return;
+  }
+  command(0x01);
+  waitIdle();
+  delayMicroseconds(2000);
+}
+
+void LcdI2cAsync::setCursor(uint8_t col, uint8_t row) {
+  static const uint8_t rowOffsets[] = { 0x00, 0x40, 0x14, 0x54 };
+  if (!isReady()) {
+    return;
+  }
+  if (row >= _rows) {
+    row = _rows - 1;
+  }
+  command(0x80 | (col + rowOffsets[row]));
+}
+
+void LcdI2cAsync::createChar(uint8_t location, uint8_t charmap[]) {
+  if (!isReady()) {
+    return;
+  }
+  location &= 0x07;
+  command(0x40 | (location << 3));
+  for (uint8_t i = 0; i < 8; i++) {
+    send(charmap[i], PIN_RS);
+  }
+  startTransfer();
+}
+
+void LcdI2cAsync::backlight() {
+  _backlight = PIN_BACKLIGHT;
+  enqueue(_backlight);
+  startTransfer();
+}
+
+void LcdI2cAsync::noBacklight() {
+  _backlight = 0;
+  enqueue(_backlight);
+  startTransfer();
+}
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef LCD_I2C_ASYNC_H
+#define LCD_I2C_ASYNC_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Тільки AVR (на платах без TWI - LiquidCrystal_I2C) і збирання тестів на ПК з моделлю шини
+#if defined(__AVR__) || defined(ARDUINO_HOST)
+
+// Драйвер LCD з I2C-модулем PCF8574 без бібліотеки Wire: байти для розширювача
+// складаються в кільцеву чергу, а переривання TWI відправляє їх однією транзакцією,
+// поки черга не спорожніє. write()/setCursor() лише ставлять байти в чергу і одразу повертаються.
+// Послідовність байтів така сама, як у LiquidCrystal_I2C: на кожен півбайт
+// три записи (дані, дані + E, дані без E), на символ - шість.
+// Wire у цьому режимі не підключається (обидва обробляли б TWI_vect).
+// Якщо транзакція обривається (немає ACK, втрачено арбітраж), HD44780 може залишитись
+// посеред півбайта - update() заново проходить 4-бітну ініціалізацію, не блокуючи loop().
+// Кожне очікування шини обмежене за часом: якщо TWI зависла, передача скидається так само, як при помилці.
+// Регістри TWI читаються і пишуться через функції twi*() - на ПК їх дає модель шини (test/host/twi.h).
+class LcdI2cAsync : public Print {
+public:
+  LcdI2cAsync(uint8_t address, uint8_t cols, uint8_t rows);
+  void begin(uint8_t cols, uint8_t rows);  // Ініціалізація HD44780 (блокуюча, тільки при старті)
+  bool update();  // Крок повторної ініціалізації після помилки; true - щойно завершено (вміст дисплея і CGRAM втрачено)
+  bool isReady() const { return _resyncStep == RESYNC_NONE; }  // Дисплей ініціалізовано, можна писати
+  void clear();  // Блокуюча: команда очищення виконується ~1.5 мс
+  void setCursor(uint8_t col, uint8_t row);
+  void createChar(uint8_t location, uint8_t charmap[]);
+  void backlight();
+  void noBacklight();
+  virtual size_t write(uint8_t value);
+  using Print::write;
+
+  void setClock(uint32_t hz);  // Частота шини (чекає завершення поточної транзакції)
+  bool probe();  // Запис і зворотне читання порту PCF8574 на поточній частоті (блокуюче)
+  uint8_t getQueueDepth();  // Скільки байтів чекає на відправку
+  uint8_t getQueueFree();  // Скільки байтів ще вміщається в чергу
+  bool isIdle();  // Черга порожня і транзакція завершена
+  uint16_t getErrorCount() const { return _errorCount; }  // Транзакції без ACK (модуль не відповідає)
+
+  static void twiIsr();  // Викликається з ISR(TWI_vect)
+
+  static const uint8_t QUEUE_BYTES_PER_SEND = 6;  // Місце в черзі на один символ або команду
+
+private:
+  static const uint8_t QUEUE_SIZE = 64;  // Степінь двійки
+  static const uint8_t PIN_RS = 0x01;
+  static const uint8_t PIN_EN = 0x04;
+  static const uint8_t PIN_BACKLIGHT = 0x08;
+  static const unsigned long BUS_TIMEOUT_US = 1000;  // Крок обміну (байт, STOP) - шина зависла або модуль не відповідає
+  static const unsigned long IDLE_TIMEOUT_US = 10000;  // Уся черга: 64 байти на 100 кГц - ~6 мс
+
+  // Кроки ініціалізації HD44780; кожен виконується, коли попередній відправлено і витримано паузу
+  enum ResyncStep {
+    RESYNC_NONE,       // Ініціалізовано
+    RESYNC_REQUESTED,  // Помилка шини (або старт) - починаємо спочатку
+    RESYNC_NIBBLE_1,   // Три півбайти 0x3 переводять HD44780 у 8-бітний режим з будь-якого стану
+    RESYNC_NIBBLE_2,
+    RESYNC_NIBBLE_3,
+    RESYNC_FUNCTION,   // 4-бітний режим, увімкнення і очищення
+    RESYNC_ENTRY_MODE,
+    RESYNC_DONE
+  };
+
+  uint8_t _address;
+  uint8_t _rows;
+  uint8_t _backlight;
+  volatile uint8_t _queue[QUEUE_SIZE];
+  volatile uint8_t _head;  // Куди пише основний код
+  volatile uint8_t _tail;  // Звідки читає переривання
+  volatile bool _busy;  // Транзакція TWI триває
+  volatile uint16_t _errorCount;
+  volatile uint8_t _resyncStep;  // ResyncStep; переривання повертає в RESYNC_REQUESTED при помилці
+  volatile bool _resyncTimed;  // Пауза поточного кроку вже відлічується
+  unsigned long _resyncAtUs;  // Коли попередній крок закінчив передачу
+  uint16_t _resyncWaitUs;  // Пауза перед наступним кроком
+
+  static LcdI2cAsync* _instance;
+
+  void handleTwi();
+  void enqueue(uint8_t data);
+  void startTransfer();
+  bool waitStop();  // false - STOP не завершився за BUS_TIMEOUT_US
+  bool waitIdle();  // false - шина не звільнилась за IDLE_TIMEOUT_US, передачу скинуто
+  void abortTransfer();  // Черга відкидається, HD44780 ініціалізується заново (викликається при вимкнених перериваннях)
+  void resetBus();  // Тайм-аут очікування: перезапуск TWI і abortTransfer()
+  bool probeStep(uint8_t control, uint8_t expectedStatus);  // Один крок обміну без переривання
+  void send(uint8_t value, uint8_t mode);  // Байт для HD44780 як два півбайти
+  void writeNibble(uint8_t nibble);  // Півбайт у старших бітах + строб E
+  void command(uint8_t value);
+  void resyncStep(uint8_t step);  // Відправляє крок ініціалізації і задає паузу після нього
+};
+
+#endif
+
+#endif
@@ -1,9 +1,108 @@
 #include "memory.h"
 
 const int Memory::EEPROM_ADDRESS;
+const int Memory::CALIBRATION_ADDRESS;
+const int Memory::JOURNAL_ADDRESS;
+
+Memory* Memory::_instance = nullptr;
+
+#if defined(__AVR__)
+ISR(EE_READY_vect) {
+  Memory::eepromReadyIsr();
+}
+#endif
+
+// Поля запису v2 (теги - SettingsTag). Таблиця у flash; діапазон перевіряється при завантаженні
+// і в Settings::set(): значення поза ним - пошкоджений запис, діє значення з config.h
+struct SettingsField {
+  uint8_t tag;
+  uint8_t size;
+  uint8_t offset;  // Зсув поля в Settings
+  uint16_t override;  // Біт SettingsOverride (0 - стан, записується завжди)
+  uint16_t minValue;  // Допустимий діапазон параметра (для стану не використовується)
+  uint16_t maxValue;
+};
+
+static const SettingsField SETTINGS_FIELDS[] PROGMEM = {
+  { SETTING_TAG_POSITION, sizeof(int32_t), offsetof(Settings, position), 0, 0, 0 },
+  { SETTING_TAG_DIRECTION, sizeof(uint8_t), offsetof(Settings, direction), 0, 0, 0 },
+  { SETTING_TAG_STEPPER_ZERO, sizeof(int32_t), offsetof(Settings, stepperZero), 0, 0, 0 },
+  { SETTING_TAG_MAX_SPEED, sizeof(uint16_t), offsetof(Settings, maxSpeedSps), SETTING_MAX_SPEED, 1, 0xFFFF },
+  { SETTING_TAG_ACCEL, sizeof(uint16_t), offsetof(Settings, accelSps2), SETTING_ACCEL, 1, 0xFFFF },
+  { SETTING_TAG_TOLERANCE, sizeof(uint16_t), offsetof(Settings, toleranceCdeg), SETTING_TOLERANCE, 0, 0xFFFF },
+  { SETTING_TAG_KP, sizeof(uint8_t), offsetof(Settings, kpPercent), SETTING_KP, 0, 0xFF },
+  { SETTING_TAG_KI, sizeof(uint8_t), offsetof(Settings, kiPercent), SETTING_KI, 0, 0xFF },
+  { SETTING_TAG_MAX_CORRECTION, sizeof(uint16_t), offsetof(Settings, maxCorrectionSteps), SETTING_MAX_CORRECTION, 0, 0xFFFF },
+  { SETTING_TAG_ENCODER_ACCEL, sizeof(uint8_t), offsetof(Settings, encoderAccelMax), SETTING_ENCODER_ACCEL, 1, 0xFF },
+  { SETTING_TAG_LONG_PRESS, sizeof(uint16_t), offsetof(Settings, longPressMs), SETTING_LONG_PRESS, 1, 0xFFFF },
+  { SETTING_TAG_LCD_UPDATE, sizeof(uint16_t), offsetof(Settings, lcdUpdateMs), SETTING_LCD_UPDATE, 1, 0xFFFF },
+  { SETTING_TAG_DEBOUNCE, sizeof(uint8_t), offsetof(Settings, debounceSampleMs), SETTING_DEBOUNCE, 1, 0xFF },
+  { SETTING_TAG_FILTER_WINDOW, sizeof(uint8_t), offsetof(Settings, filterWindow), SETTING_FILTER_WINDOW, 1, ABS_ENC_FILTER_WINDOW },
+  { SETTING_TAG_FILTER_ALPHA, sizeof(uint16_t), offsetof(Settings, filterAlpha), SETTING_FILTER_ALPHA, 1, 256 }
+};
+static const uint8_t SETTINGS_FIELD_COUNT = sizeof(SETTINGS_FIELDS) / sizeof(SETTINGS_FIELDS[0]);
+
+// Запис з усіма параметрами - 58 байтів TLV, рівно RECORD_TLV_MAX (перевіряє test_memory);
+// для нового параметра слот журналу доведеться збільшити
+
+static void readField(uint8_t index, SettingsField& field) {
+  memcpy_P(&field, &SETTINGS_FIELDS[index], sizeof(SettingsField));
+}
+
+// Значення параметра (1 або 2 байти, little-endian як у пам'яті AVR)
+static uint16_t fieldValue(const Settings& settings, const SettingsField& field) {
+  uint16_t value = 0;
+  memcpy(&value, (const uint8_t*)&settings + field.offset, field.size);
+  return value;
+}
+
+Settings::Settings()
+  : position(0), direction(0), stepperZero(0),
+    maxSpeedSps(STEPPER_MAX_SPEED_SPS), accelSps2(STEPPER_ACCEL_SPS2),
+    toleranceCdeg(CLOSED_LOOP_TOLERANCE_CDEG), kpPercent(CLOSED_LOOP_KP_PERCENT),
+    kiPercent(CLOSED_LOOP_KI_PERCENT), maxCorrectionSteps(CLOSED_LOOP_MAX_CORRECTION_STEPS),
+    encoderAccelMax(ENCODER_ACCEL_MAX), longPressMs(LONG_PRESS_THRESHOLD_MS), lcdUpdateMs(LCD_UPDATE_MS),
+    debounceSampleMs(INPUT_DEBOUNCE_SAMPLE_MS), filterWindow(ABS_ENC_FILTER_WINDOW), filterAlpha(ABS_ENC_FILTER_ALPHA),
+    overridden(0) {
+}
+
+bool Settings::set(uint8_t tag, uint16_t value) {
+  SettingsField field;
+  for (uint8_t i = 0; i < SETTINGS_FIELD_COUNT; i++) {
+    readField(i, field);
+    if (field.tag != tag) {
+      continue;
+    }
+    if (!field.override || value < field.minValue || value > field.maxValue) {
+      return false;
+    }
+    if (fieldValue(*this, field) != value) {
+      memcpy((uint8_t*)this + field.offset, &value, field.size);
+      overridden |= field.override;
+    }
+    return true;
+  }
+  return false;
+}
+
+uint16_t Settings::get(uint8_t tag) const {
+  SettingsField field;
+  for (uint8_t i = 0; i < SETTINGS_FIELD_COUNT; i++) {
+    readField(i, field);
+    if (field.tag == tag && field.override) {
+      return fieldValue(*this, field);
+    }
+  }
+  return 0;
+}
 
 Memory::Memory(int32_t minPos, int32_t maxPos)
-  : _minPos(minPos), _maxPos(maxPos) {
+  : _minPos(minPos), _maxPos(maxPos), _newestSlot(NO_SLOT), _sequence(0xFFFF),
+    _storedLength(0), _pendingLength(0), _dirty(false),
+    _writeLength(0), _writeAddress(0), _writeIndex(0), _writing(false) {
+  uint16_t slots = (EEPROM.length() - JOURNAL_ADDRESS) / JOURNAL_SLOT_SIZE;
+  _slotCount = (slots > NO_SLOT - 1) ? (NO_SLOT - 1) : slots;
+  _instance = this;
 }
 
 void Memory::load(int32_t& position) {
@@ -33,36 +132,290 @@ uint8_t Memory::calculateChecksum(const SettingsData& data) {
   return sum;
 }
 
-void Memory::loadSettings(int32_t& position, uint8_t& direction, int32_t& stepperZero) {
+uint16_t Memory::updateCrc(uint16_t crc, uint8_t data) {
+  // CRC16-CCITT (поліном 0x1021, початкове значення 0xFFFF)
+  crc ^= (uint16_t)data << 8;
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : (crc << 1);
+  }
+  return crc;
+}
+
+uint16_t Memory::calculateCrc(const uint8_t* data, uint8_t length) {
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < length; i++) {
+    crc = updateCrc(crc, data[i]);
+  }
+  return crc;
+}
+
+bool Memory::readRecordHeader(uint8_t slot, uint16_t& sequence) {
+  uint16_t address = slotAddress(slot);
+  uint8_t length = EEPROM.read(address + 1);
+  if (EEPROM.read(address) != RECORD_VERSION || length > RECORD_TLV_MAX) {
+    return false;
+  }
+  
+  uint8_t total = RECORD_HEADER_SIZE + length;
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < total; i++) {
+    crc = updateCrc(crc, EEPROM.read(address + i));
+  }
+  uint16_t storedCrc;
+  EEPROM.get(address + total, storedCrc);
+  EEPROM.get(address + 2, sequence);
+  return crc == storedCrc;
+}
+
+uint8_t Memory::encodeSettings(const Settings& settings, uint8_t* tlv) {
+  // Байти значень - як у пам'яті AVR (little-endian).
+  // Параметри, не змінені відносно config.h, не записуються - при читанні діє config.h
+  uint8_t length = 0;
+  SettingsField field;
+  for (uint8_t i = 0; i < SETTINGS_FIELD_COUNT; i++) {
+    readField(i, field);
+    if (field.override && !(settings.overridden & field.override)) {
+      continue;
+    }
+    tlv[length++] = field.tag;
+    tlv[length++] = field.size;
+    memcpy(tlv + length, (const uint8_t*)&settings + field.offset, field.size);
+    length += field.size;
+  }
+  return length;
+}
+
+void Memory::decodeSettings(uint16_t address, uint8_t length, Settings& settings) {
+  uint16_t end = address + length;
+  while (address + 2 <= end) {
+    uint8_t tag = EEPROM.read(address);
+    uint8_t size = EEPROM.read(address + 1);
+    address += 2;
+    if (address + size > end) {
+      break;
+    }
+    // Невідомий тег або інший розмір (запис новішої прошивки) - пропускаємо
+    SettingsField field;
+    for (uint8_t i = 0; i < SETTINGS_FIELD_COUNT; i++) {
+      readField(i, field);
+      if (field.tag == tag && field.size == size) {
+        uint8_t* value = (uint8_t*)&settings + field.offset;
+        for (uint8_t b = 0; b < size; b++) {
+          value[b] = EEPROM.read(address + b);
+        }
+        settings.overridden |= field.override;
+        break;
+      }
+    }
+    address += size;
+  }
+}
+
+void Memory::loadV0(Settings& settings) {
   SettingsData data;
   EEPROM.get(EEPROM_ADDRESS, data);
   
-  // Перевіряємо checksum
+  // Перевіряємо checksum (пошкоджені дані - залишаються значення за замовчуванням).
+  // Чиста EEPROM (усі 0xFF) теж дає правильний XOR - її відсікає перевірка напрямку
   uint8_t calculatedChecksum = calculateChecksum(data);
-  if (data.checksum != calculatedChecksum) {
-    // Дані пошкоджені - використовуємо значення за замовчуванням
-    position = 0;
-    direction = 0;  // DIR_CW
-    stepperZero = 0;
+  if (data.checksum == calculatedChecksum && data.direction <= 1) {
+    settings.position = data.position;
+    settings.direction = data.direction;
+    settings.stepperZero = data.stepperZero;
+  }
+}
+
+void Memory::loadSettings(Settings& settings) {
+  settings = Settings();
+  
+  // Найновіший правильний запис журналу. Номери порівнюються з урахуванням переповнення:
+  // усі записи в журналі відрізняються не більше ніж на кількість слотів.
+  // Запис, перерваний вимкненням живлення, не проходить CRC - тоді знаходиться попередній
+  uint16_t sequence;
+  _newestSlot = NO_SLOT;
+  for (uint8_t slot = 0; slot < _slotCount; slot++) {
+    if (readRecordHeader(slot, sequence) &&
+        (_newestSlot == NO_SLOT || (int16_t)(sequence - _sequence) > 0)) {
+      _sequence = sequence;
+      _newestSlot = slot;
+    }
+  }
+  
+  if (_newestSlot != NO_SLOT) {
+    uint16_t address = slotAddress(_newestSlot);
+    decodeSettings(address + RECORD_HEADER_SIZE, EEPROM.read(address + 1), settings);
+  } else {
+    // Журналу немає - старий запис за адресою 0; у журнал він потрапить з першим збереженням
+    loadV0(settings);
+  }
+  
+  // Захист від некоректних значень
+  Settings defaults;
+  if (settings.position < _minPos || settings.position > _maxPos) {
+    settings.position = 0;
+  }
+  if (settings.direction > 1) {
+    settings.direction = 0;  // DIR_CW
+  }
+  // Параметр поза діапазоном (нульова швидкість, інтервал, вікно більше за буфер фільтра) -
+  // пошкоджений запис: діє значення з config.h
+  SettingsField field;
+  for (uint8_t i = 0; i < SETTINGS_FIELD_COUNT; i++) {
+    readField(i, field);
+    uint16_t value = fieldValue(settings, field);
+    if (field.override && (value < field.minValue || value > field.maxValue)) {
+      memcpy((uint8_t*)&settings + field.offset, (const uint8_t*)&defaults + field.offset, field.size);
+      settings.overridden &= ~field.override;
+    }
+  }
+  
+  // Завантажене вважається вже збереженим (після міграції - до першої зміни)
+  _storedLength = encodeSettings(settings, _storedTlv);
+  _pendingLength = 0;
+  _dirty = false;
+}
+
+void Memory::saveSettings(const Settings& settings) {
+  // Тільки кеш: кілька збережень до початку запису зливаються в одне,
+  // а незмінені налаштування не записуються зовсім
+  _pendingLength = encodeSettings(settings, _pendingTlv);
+  _dirty = (_pendingLength != _storedLength || memcmp(_pendingTlv, _storedTlv, _pendingLength) != 0);
+}
+
+void Memory::update() {
+  if (_writing) {
+#if !defined(__AVR__)
+    // Без переривання EE_READY - один байт за прохід loop()
+    if (!writeNextByte()) {
+      _writing = false;
+    }
+#endif
     return;
   }
+  if (_dirty) {
+    startWrite();
+  }
+}
+
+void Memory::flush() {
+  while (_dirty || _writing) {
+    update();
+  }
+}
+
+bool Memory::isPersisted() {
+  return !_dirty && !_writing;
+}
+
+void Memory::startWrite() {
+  // Наступний слот по колу; номер і CRC обчислюються тут, а не при кожному збереженні
+  uint8_t slot = (_newestSlot == NO_SLOT || _newestSlot + 1 >= _slotCount) ? 0 : _newestSlot + 1;
+  _sequence++;
+  
+  _writeBuffer[0] = RECORD_VERSION;
+  _writeBuffer[1] = _pendingLength;
+  memcpy(_writeBuffer + 2, &_sequence, sizeof(_sequence));
+  memcpy(_writeBuffer + RECORD_HEADER_SIZE, _pendingTlv, _pendingLength);
+  _writeLength = RECORD_HEADER_SIZE + _pendingLength;
+  uint16_t crc = calculateCrc(_writeBuffer, _writeLength);
+  memcpy(_writeBuffer + _writeLength, &crc, sizeof(crc));
+  _writeLength += sizeof(crc);
+  
+  _writeAddress = slotAddress(slot);
+  _writeIndex = 0;
+  memcpy(_storedTlv, _pendingTlv, _pendingLength);
+  _storedLength = _pendingLength;
+  _newestSlot = slot;
+  _dirty = false;
+  _writing = true;
   
-  // Перевіряємо позицію
-  if (data.position < _minPos || data.position > _maxPos) {
-    data.position = 0;
+#if defined(__AVR__)
+  // Переривання спрацьовує, щойно EEPROM готова, і далі - після кожного записаного байта
+  EECR |= _BV(EERIE);
+#endif
+}
+
+bool Memory::writeNextByte() {
+  // Пропускаємо байти, що вже мають потрібне значення (стирання + запис ~3.3 мс на байт)
+  while (_writeIndex < _writeLength) {
+    uint16_t address = _writeAddress + _writeIndex;
+    uint8_t value = _writeBuffer[_writeIndex];
+    _writeIndex++;
+#if defined(__AVR__)
+    EEAR = address;
+    EECR |= _BV(EERE);
+    if (EEDR != value) {
+      EEDR = value;
+      EECR |= _BV(EEMPE);
+      EECR |= _BV(EEPE);  // Не пізніше 4 тактів після EEMPE (у перериванні інші переривання заборонені)
+      return true;
+    }
+#else
+    if (EEPROM.read(address) != value) {
+      EEPROM.write(address, value);
+      return true;
+    }
+#endif
+  }
+  return false;
+}
+
+void Memory::eepromReadyIsr() {
+#if defined(__AVR__)
+  if (_instance && _instance->_writing && _instance->writeNextByte()) {
+    return;
+  }
+  // Запис завершено - вимикаємо переривання (інакше воно спрацьовує безперервно)
+  EECR &= ~_BV(EERIE);
+  if (_instance) {
+    _instance->_writing = false;
+  }
+#endif
+}
+
+bool Memory::loadCalibration(int16_t* table, uint8_t count) {
+  uint8_t magic = EEPROM.read(CALIBRATION_ADDRESS);
+  if ((magic != CALIBRATION_MAGIC && magic != CALIBRATION_MAGIC_XOR) || EEPROM.read(CALIBRATION_ADDRESS + 1) != count) {
+    return false;
   }
   
-  position = data.position;
-  direction = (data.direction > 1) ? 0 : data.direction;  // Захист від некоректних значень
-  stepperZero = data.stepperZero;
+  // CRC16 охоплює кількість точок і таблицю; старий формат мав лише XOR байтів таблиці
+  uint16_t crc = updateCrc(0xFFFF, count);
+  uint8_t sum = 0;
+  int address = CALIBRATION_ADDRESS + 2;
+  for (uint8_t i = 0; i < count; i++) {
+    EEPROM.get(address, table[i]);
+    const uint8_t* bytes = (const uint8_t*)&table[i];
+    for (size_t b = 0; b < sizeof(table[i]); b++) {
+      crc = updateCrc(crc, bytes[b]);
+      sum ^= bytes[b];
+    }
+    address += sizeof(table[i]);
+  }
+  
+  if (magic == CALIBRATION_MAGIC_XOR) {
+    return EEPROM.read(address) == sum;
+  }
+  uint16_t stored;
+  EEPROM.get(address, stored);
+  return stored == crc;
 }
 
-void Memory::saveSettings(int32_t position, uint8_t direction, int32_t stepperZero) {
-  SettingsData data;
-  data.position = position;
-  data.direction = direction;
-  data.stepperZero = stepperZero;
-  data.checksum = calculateChecksum(data);
+void Memory::saveCalibration(const int16_t* table, uint8_t count) {
+  // Блокуючий запис через EEPROM не повинен перетинатися з фоновим записом журналу
+  flush();
   
-  EEPROM.put(EEPROM_ADDRESS, data);
+  uint16_t crc = updateCrc(0xFFFF, count);
+  int address = CALIBRATION_ADDRESS + 2;
+  for (uint8_t i = 0; i < count; i++) {
+    EEPROM.put(address, table[i]);
+    const uint8_t* bytes = (const uint8_t*)&table[i];
+    for (size_t b = 0; b < sizeof(table[i]); b++) {
+      crc = updateCrc(crc, bytes[b]);
+    }
+    address += sizeof(table[i]);
+  }
+  EEPROM.put(address, crc);
+  EEPROM.update(CALIBRATION_ADDRESS + 1, count);
+  EEPROM.update(CALIBRATION_ADDRESS, CALIBRATION_MAGIC);  // Маркер останнім - таблиця вже записана
 }
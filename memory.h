@@ -3,6 +3,7 @@
 
 #include <EEPROM.h>
 #include <Arduino.h>
+#include "config.h"
 
 // Структура для збереження налаштувань
 struct SettingsData {
@@ -12,6 +13,81 @@ struct SettingsData {
   uint8_t checksum;        // Контрольна сума для перевірки цілісності
 };
 
+// Параметри, значення яких задано явно (біти Settings::overridden). Лише вони записуються в EEPROM;
+// решта береться з config.h, тому зміна config.h діє після перепрошивки.
+// Код, що змінює параметр під час роботи, встановлює його біт
+enum SettingsOverride {
+  SETTING_MAX_SPEED = 0x0001,
+  SETTING_ACCEL = 0x0002,
+  SETTING_TOLERANCE = 0x0004,
+  SETTING_KP = 0x0008,
+  SETTING_KI = 0x0010,
+  SETTING_MAX_CORRECTION = 0x0020,
+  SETTING_ENCODER_ACCEL = 0x0040,
+  SETTING_LONG_PRESS = 0x0080,
+  SETTING_LCD_UPDATE = 0x0100,
+  SETTING_DEBOUNCE = 0x0200,
+  SETTING_FILTER_WINDOW = 0x0400,
+  SETTING_FILTER_ALPHA = 0x0800
+};
+
+// Теги полів запису (групи: 0x0_ - стан, 0x1_ - рух, 0x2_ - замкнений контур, 0x3_ - інтерфейс,
+// 0x4_ - абсолютний енкодер). Номер тегу не змінюється ніколи; новий параметр - новий тег.
+// Тегом параметр задається з меню і з послідовного порту (Settings::set)
+enum SettingsTag {
+  SETTING_TAG_POSITION = 0x01,
+  SETTING_TAG_DIRECTION = 0x02,
+  SETTING_TAG_STEPPER_ZERO = 0x03,
+  SETTING_TAG_MAX_SPEED = 0x10,
+  SETTING_TAG_ACCEL = 0x11,
+  SETTING_TAG_TOLERANCE = 0x20,
+  SETTING_TAG_KP = 0x21,
+  SETTING_TAG_KI = 0x22,
+  SETTING_TAG_MAX_CORRECTION = 0x23,
+  SETTING_TAG_ENCODER_ACCEL = 0x30,
+  SETTING_TAG_LONG_PRESS = 0x31,
+  SETTING_TAG_LCD_UPDATE = 0x32,
+  SETTING_TAG_DEBOUNCE = 0x33,
+  SETTING_TAG_FILTER_WINDOW = 0x40,
+  SETTING_TAG_FILTER_ALPHA = 0x41
+};
+
+// Усі налаштування в RAM: завантажуються при старті одним проходом, далі модулі
+// читають їх звідси. Конструктор заповнює значеннями з config.h - вони ж діють для
+// параметрів, яких немає в збереженому записі (не змінювались або старий формат)
+struct Settings {
+  // Стан (зберігається завжди)
+  int32_t position;            // Позиція двигуна
+  uint8_t direction;           // Напрямок руху (0 = CW, 1 = CCW)
+  int32_t stepperZero;         // Нульова позиція двигуна
+  // Рух
+  uint16_t maxSpeedSps;        // STEPPER_MAX_SPEED_SPS
+  uint16_t accelSps2;          // STEPPER_ACCEL_SPS2
+  // Замкнений контур
+  uint16_t toleranceCdeg;      // CLOSED_LOOP_TOLERANCE_CDEG
+  uint8_t kpPercent;           // CLOSED_LOOP_KP_PERCENT
+  uint8_t kiPercent;           // CLOSED_LOOP_KI_PERCENT
+  uint16_t maxCorrectionSteps; // CLOSED_LOOP_MAX_CORRECTION_STEPS
+  // Інтерфейс
+  uint8_t encoderAccelMax;     // ENCODER_ACCEL_MAX
+  uint16_t longPressMs;        // LONG_PRESS_THRESHOLD_MS
+  uint16_t lcdUpdateMs;        // LCD_UPDATE_MS
+  uint8_t debounceSampleMs;    // INPUT_DEBOUNCE_SAMPLE_MS
+  // Абсолютний енкодер
+  uint8_t filterWindow;        // ABS_ENC_FILTER_WINDOW (фільтр ABS_ENC_FILTER_MEAN)
+  uint16_t filterAlpha;        // ABS_ENC_FILTER_ALPHA (фільтр ABS_ENC_FILTER_EMA)
+  
+  uint16_t overridden;         // SettingsOverride: параметри, що відрізняються від config.h
+  
+  Settings();
+  
+  // Зміна параметра під час роботи (меню, послідовний порт): нове значення встановлює біт overridden,
+  // тому воно записується в EEPROM. false - немає такого параметра або значення поза діапазоном
+  // (стан через set() не змінюється)
+  bool set(uint8_t tag, uint16_t value);
+  uint16_t get(uint8_t tag) const;  // 0 - немає такого параметра
+};
+
 class Memory {
 public:
   Memory(int32_t minPos, int32_t maxPos);
@@ -19,16 +95,61 @@ public:
   void save(int32_t position);
   
   // Нові методи для збереження налаштувань
-  void loadSettings(int32_t& position, uint8_t& direction, int32_t& stepperZero);
-  void saveSettings(int32_t position, uint8_t direction, int32_t stepperZero);
+  void loadSettings(Settings& settings);  // Найновіший запис журналу (при старті)
+  void saveSettings(const Settings& settings);  // Не блокує, запис - у фоні
+  void update();  // Запускає фоновий запис накопичених змін (викликається з loop())
+  void flush();  // Блокуюче дописує все накопичене
+  bool isPersisted();  // Усі збережені налаштування вже в EEPROM
+  
+  // Таблиця калібрування абсолютного енкодера (поправки в сотих градуса)
+  bool loadCalibration(int16_t* table, uint8_t count);  // false - таблиці немає або вона пошкоджена
+  void saveCalibration(const int16_t* table, uint8_t count);  // Блокуюча, спершу дописує журнал
+  
+  static void eepromReadyIsr();  // Викликається з ISR(EE_READY_vect)
+  static uint16_t calculateCrc(const uint8_t* data, uint8_t length);  // CRC16-CCITT запису журналу
   
 private:
   int32_t _minPos;
   int32_t _maxPos;
-  static const int EEPROM_ADDRESS = 0;
+  static const int EEPROM_ADDRESS = 0;  // Старий формат (один запис SettingsData), читається лише для міграції
+  static const int CALIBRATION_ADDRESS = 16;  // Після SettingsData: маркер, кількість, таблиця, CRC16
+  static const uint8_t CALIBRATION_MAGIC = 0xCB;
+  static const uint8_t CALIBRATION_MAGIC_XOR = 0xCA;  // Старий формат з XOR-сумою, читається лише для міграції
+  static const int JOURNAL_ADDRESS = 64;  // Після таблиці калібрування
+  static const uint8_t JOURNAL_SLOT_SIZE = 64;
+  static const uint8_t RECORD_VERSION = 2;
+  static const uint8_t RECORD_HEADER_SIZE = 4;  // Версія, довжина TLV, порядковий номер
+  static const uint8_t RECORD_TLV_MAX = JOURNAL_SLOT_SIZE - RECORD_HEADER_SIZE - 2;
+  static const uint8_t NO_SLOT = 0xFF;
+  
+  uint8_t _slotCount;
+  uint8_t _newestSlot;  // Слот останнього записаного запису (NO_SLOT - журнал v2 порожній)
+  uint16_t _sequence;  // Номер останнього записаного запису
+  uint8_t _storedTlv[RECORD_TLV_MAX];  // Поля останнього записаного (або такого, що записується) запису
+  uint8_t _storedLength;
+  uint8_t _pendingTlv[RECORD_TLV_MAX];  // Останнє збереження, ще не передане на запис
+  uint8_t _pendingLength;
+  bool _dirty;  // _pendingTlv відрізняється від _storedTlv
+  
+  // Фоновий запис (спільний з перериванням)
+  uint8_t _writeBuffer[JOURNAL_SLOT_SIZE];
+  uint8_t _writeLength;
+  uint16_t _writeAddress;
+  volatile uint8_t _writeIndex;
+  volatile bool _writing;
+  
+  static Memory* _instance;
   
   // Допоміжний метод для обчислення checksum
   uint8_t calculateChecksum(const SettingsData& data);
+  static uint16_t updateCrc(uint16_t crc, uint8_t data);  // CRC16-CCITT, один байт
+  uint16_t slotAddress(uint8_t slot) const { return JOURNAL_ADDRESS + slot * JOURNAL_SLOT_SIZE; }
+  bool readRecordHeader(uint8_t slot, uint16_t& sequence);  // false - не запис v2 або CRC не збігається
+  static uint8_t encodeSettings(const Settings& settings, uint8_t* tlv);  // Повертає довжину TLV
+  void decodeSettings(uint16_t address, uint8_t length, Settings& settings);
+  void loadV0(Settings& settings);  // Міграція зі старого запису за адресою 0
+  bool writeNextByte();  // Один байт фонового запису; false - запис завершено
+  void startWrite();
 };
 
 #endif
@@ -1,9 +1,99 @@
 #include "menu.h"
+#include "memory.h"
 
+/* ================== ДЕРЕВО МЕНЮ (FLASH) ================== */
+// Рядки
+static const char TEXT_MAIN_MENU[] PROGMEM = "Main Menu";
+static const char TEXT_SET_ANGLE[] PROGMEM = "Set Angle";
+static const char TEXT_TARGET[] PROGMEM = "Target";
+static const char TEXT_SETTINGS[] PROGMEM = "Settings";
+static const char TEXT_SAVE_POSITION[] PROGMEM = "Save Position";
+static const char TEXT_CW[] PROGMEM = "CW  (Clockwise)";
+static const char TEXT_CCW[] PROGMEM = "CCW (Counter-CW)";
+static const char TEXT_TUNING[] PROGMEM = "Tuning";
+static const char TEXT_MAX_SPEED[] PROGMEM = "Max Speed";
+static const char TEXT_ACCEL[] PROGMEM = "Accel";
+static const char TEXT_DEBOUNCE[] PROGMEM = "Debounce";
+static const char TEXT_FILTER[] PROGMEM = "Filter";
+
+// Варіанти напрямку - в порядку значень RotationDirection
+static const char* const DIRECTION_OPTIONS[] PROGMEM = { TEXT_CW, TEXT_CCW };
+
+// Встановлення кута: 0-359° по колу, крок розряду вибирається кнопкою, кнопка енкодера - готово
+static const MenuNode NODE_SET_ANGLE PROGMEM = {
+  MENU_NODE_VALUE, MENU_FLAG_DEGREES | MENU_FLAG_DIGIT_MODE, MENU_VALUE_TARGET_ANGLE, MENU_ACTION_NONE,
+  TEXT_SET_ANGLE, TEXT_TARGET, nullptr, nullptr, 0, 0, 359, 1, 0
+};
+
+// Налаштування: напрямок руху
+static const MenuNode NODE_SETTINGS PROGMEM = {
+  MENU_NODE_CHOICE, 0, MENU_VALUE_DIRECTION, MENU_ACTION_NONE,
+  TEXT_SETTINGS, nullptr, nullptr, DIRECTION_OPTIONS, 2, 0, 0, 0, 0
+};
+
+// Збереження позиції
+static const MenuNode NODE_SAVE PROGMEM = {
+  MENU_NODE_CONFIRM, 0, MENU_VALUE_NONE, MENU_ACTION_SAVE,
+  TEXT_SAVE_POSITION, nullptr, nullptr, nullptr, 0, 0, 0, 0, 0
+};
+
+// Параметри з Settings: значення змінюється одразу, при виході з меню налаштування зберігаються
+static const MenuNode NODE_MAX_SPEED PROGMEM = {
+  MENU_NODE_VALUE, 0, MENU_VALUE_SETTING, MENU_ACTION_NONE,
+  TEXT_MAX_SPEED, TEXT_MAX_SPEED, nullptr, nullptr, 0, 100, 5000, 50, SETTING_TAG_MAX_SPEED
+};
+
+static const MenuNode NODE_ACCEL PROGMEM = {
+  MENU_NODE_VALUE, 0, MENU_VALUE_SETTING, MENU_ACTION_NONE,
+  TEXT_ACCEL, TEXT_ACCEL, nullptr, nullptr, 0, 500, 30000, 500, SETTING_TAG_ACCEL
+};
+
+static const MenuNode NODE_DEBOUNCE PROGMEM = {
+  MENU_NODE_VALUE, 0, MENU_VALUE_SETTING, MENU_ACTION_NONE,
+  TEXT_DEBOUNCE, TEXT_DEBOUNCE, nullptr, nullptr, 0, 1, 20, 1, SETTING_TAG_DEBOUNCE
+};
+
+#if ABS_ENC_FILTER == ABS_ENC_FILTER_MEAN
+// Вікно середнього абсолютного енкодера
+static const MenuNode NODE_FILTER PROGMEM = {
+  MENU_NODE_VALUE, 0, MENU_VALUE_SETTING, MENU_ACTION_NONE,
+  TEXT_FILTER, TEXT_FILTER, nullptr, nullptr, 0, 1, ABS_ENC_FILTER_WINDOW, 1, SETTING_TAG_FILTER_WINDOW
+};
+#elif ABS_ENC_FILTER == ABS_ENC_FILTER_EMA
+// Коефіцієнт EMA абсолютного енкодера (у 1/256)
+static const MenuNode NODE_FILTER PROGMEM = {
+  MENU_NODE_VALUE, 0, MENU_VALUE_SETTING, MENU_ACTION_NONE,
+  TEXT_FILTER, TEXT_FILTER, nullptr, nullptr, 0, 1, 256, 1, SETTING_TAG_FILTER_ALPHA
+};
+#endif
+
+// Медіанний фільтр не має параметрів - пункту Filter немає
+static const MenuNode* const TUNING_ITEMS[] PROGMEM = {
+  &NODE_MAX_SPEED, &NODE_ACCEL, &NODE_DEBOUNCE,
+#if ABS_ENC_FILTER != ABS_ENC_FILTER_MEDIAN
+  &NODE_FILTER
+#endif
+};
+
+static const MenuNode NODE_TUNING PROGMEM = {
+  MENU_NODE_LIST, 0, MENU_VALUE_NONE, MENU_ACTION_NONE,
+  TEXT_TUNING, TEXT_TUNING, TUNING_ITEMS, nullptr, sizeof(TUNING_ITEMS) / sizeof(TUNING_ITEMS[0]), 0, 0, 0, 0
+};
+
+static const MenuNode* const MAIN_MENU_ITEMS[] PROGMEM = { &NODE_SET_ANGLE, &NODE_SETTINGS, &NODE_TUNING, &NODE_SAVE };
+
+// Головне меню - корінь дерева
+static const MenuNode NODE_MAIN_MENU PROGMEM = {
+  MENU_NODE_LIST, 0, MENU_VALUE_NONE, MENU_ACTION_NONE,
+  TEXT_MAIN_MENU, TEXT_MAIN_MENU, MAIN_MENU_ITEMS, nullptr, sizeof(MAIN_MENU_ITEMS) / sizeof(MAIN_MENU_ITEMS[0]), 0, 0, 0, 0
+};
+
+/* ================== НАВІГАЦІЯ ================== */
 Menu::Menu()
-  : _currentMenu(MENU_SPLASH), _currentItem(0), _targetAngle(0),
+  : _currentMenu(MENU_SPLASH), _node(nullptr), _currentItem(0), _targetAngle(0),
     _targetPosition(0), _shouldSave(false), _manualAngleSet(false),
-    _shouldResetSplash(false), _shouldResetPosition(false), _lastAbsoluteAngle(999), _lastMenuChangeTime(0), _digitMode(DIGIT_UNITS), _selectedDirection(DIR_CW), _stepperZeroPosition(0) {
+    _shouldResetSplash(false), _shouldResetPosition(false), _lastAbsoluteAngle(999), _lastMenuChangeTime(0), _digitMode(DIGIT_UNITS), _lastDigitButton(false), _selectedDirection(DIR_CW), _stepperZeroPosition(0), _encoderAccelMax(ENCODER_ACCEL_MAX),
+    _settings(nullptr), _settingsChanged(false), _shouldApplySettings(false), _shouldSaveSettings(false) {
 }
 
 int32_t Menu::angleToSteps(uint16_t angle) {
@@ -13,7 +103,7 @@ int32_t Menu::angleToSteps(uint16_t angle) {
 
 void Menu::updateTargetAngle(uint16_t absoluteAngle) {
   // Якщо активний режим редагування через меню - не оновлюємо
-  if (_currentMenu == MENU_SET_ANGLE) {
+  if (isEditingAngle()) {
     return;
   }
   
@@ -79,8 +169,7 @@ void Menu::setStepperZeroPosition(int32_t zeroPosition) {
 void Menu::handleSplashMenu(bool buttonPressed, bool startButtonPressed) {
   // Кнопка енкодера - перехід в головне меню
   if (buttonPressed) {
-    _currentMenu = MENU_MAIN;
-    _currentItem = 0;
+    enterNode(&NODE_MAIN_MENU);
     return;
   }
   
@@ -91,41 +180,102 @@ void Menu::handleSplashMenu(bool buttonPressed, bool startButtonPressed) {
   }
 }
 
-void Menu::updateNavigation(int16_t encoderDelta, bool buttonPressed) {
-  // Обробка навігації залежно від поточного меню
-  switch (_currentMenu) {
-    case MENU_SPLASH:
-      // Сплаш-екран обробляється окремо через handleSplashMenu
+bool Menu::isEditingAngle() const {
+  return _currentMenu == MENU_TREE && pgm_read_byte(&_node->valueId) == MENU_VALUE_TARGET_ANGLE;
+}
+
+uint16_t Menu::getCurrentValue() const {
+  return (_currentMenu == MENU_TREE) ? getValue(pgm_read_byte(&_node->valueId), pgm_read_byte(&_node->setting)) : 0;
+}
+
+uint16_t Menu::getValue(uint8_t valueId, uint8_t setting) const {
+  switch (valueId) {
+    case MENU_VALUE_TARGET_ANGLE:
+      return _targetAngle;
+    case MENU_VALUE_DIRECTION:
+      return _selectedDirection;
+    case MENU_VALUE_SETTING:
+      return _settings ? _settings->get(setting) : 0;
+  }
+  return 0;
+}
+
+void Menu::setValue(uint8_t valueId, uint8_t setting, uint16_t value) {
+  switch (valueId) {
+    case MENU_VALUE_TARGET_ANGLE:
+      setTargetAngle(value);  // Також перераховує цільову позицію і позначає кут як встановлений вручну
+      break;
+    case MENU_VALUE_DIRECTION:
+      _selectedDirection = (RotationDirection)value;
       break;
-      
-    case MENU_MAIN:
-      handleMainMenu(encoderDelta, buttonPressed);
+    case MENU_VALUE_SETTING:
+      // Settings::set() встановлює біт overridden - значення з меню записується в EEPROM
+      if (_settings && _settings->get(setting) != value && _settings->set(setting, value)) {
+        _settingsChanged = true;
+        _shouldApplySettings = true;
+      }
+      break;
+  }
+}
+
+void Menu::enterNode(const MenuNode* node) {
+  _currentMenu = MENU_TREE;
+  _node = node;
+  _currentItem = 0;
+  _lastMenuChangeTime = millis();
+}
+
+void Menu::finish(uint8_t action) {
+  if (action == MENU_ACTION_SAVE) {
+    _shouldSave = true;
+  }
+  if (_settingsChanged) {
+    _shouldSaveSettings = true;
+    _settingsChanged = false;
+  }
+  _currentMenu = MENU_SPLASH;
+  _node = nullptr;
+  _currentItem = 0;
+  _shouldResetSplash = true;  // Встановлюємо прапорець для скидання сплеш-екрану
+  _lastMenuChangeTime = millis();
+}
+
+void Menu::updateNavigation(int16_t encoderDelta, bool buttonPressed, uint16_t encoderSpeed) {
+  // Сплеш-екран обробляється окремо через handleSplashMenu
+  if (_currentMenu != MENU_TREE) {
+    return;
+  }
+  
+  MenuNode node;
+  readMenuNode(_node, node);
+  switch (node.type) {
+    case MENU_NODE_LIST:
+      handleList(node, encoderDelta, buttonPressed);
       break;
-    case MENU_SET_ANGLE:
-      handleSetAngleMenu(encoderDelta, buttonPressed);
+    case MENU_NODE_VALUE:
+      handleValue(node, encoderDelta, buttonPressed, encoderSpeed);
       break;
-    case MENU_SETTINGS:
-      handleSettingsMenu(encoderDelta, buttonPressed);
+    case MENU_NODE_CHOICE:
+      handleChoice(node, encoderDelta, buttonPressed);
       break;
-    case MENU_SAVE:
-      handleSaveMenu(buttonPressed);
+    case MENU_NODE_CONFIRM:
+      if (buttonPressed) {
+        finish(node.action);
+      }
       break;
   }
 }
 
-void Menu::handleMainMenu(int16_t encoderDelta, bool buttonPressed) {
-  // Навігація по головному меню з затримкою для плавної навігації
+void Menu::handleList(const MenuNode& node, int16_t encoderDelta, bool buttonPressed) {
+  // Навігація по списку з затримкою для плавної навігації
   unsigned long now = millis();
   if (encoderDelta != 0 && (now - _lastMenuChangeTime >= MENU_CHANGE_DELAY_MS)) {
-    // Обмежуємо крок до ±1 для плавної навігації
-    int8_t step = (encoderDelta > 0) ? 1 : -1;
-    _currentItem += step;
-    
-    // Обмежуємо в межах меню
-    if (_currentItem < 0)
-      _currentItem = ITEM_COUNT - 1;
-    else if (_currentItem >= ITEM_COUNT)
-      _currentItem = 0;
+    // Обмежуємо крок до ±1, по колу
+    if (encoderDelta > 0) {
+      _currentItem = (_currentItem + 1 >= node.itemCount) ? 0 : _currentItem + 1;
+    } else {
+      _currentItem = (_currentItem == 0) ? node.itemCount - 1 : _currentItem - 1;
+    }
     
     // Запам'ятовуємо час зміни
     _lastMenuChangeTime = now;
@@ -133,95 +283,88 @@ void Menu::handleMainMenu(int16_t encoderDelta, bool buttonPressed) {
   
   // Обробка вибору пункту
   if (buttonPressed) {
-    // Скидаємо затримку при натисканні кнопки для негайної реакції
-    _lastMenuChangeTime = now;
-    
-    switch (_currentItem) {
-      case ITEM_SET_ANGLE:
-        _currentMenu = MENU_SET_ANGLE;
-        break;
-      case ITEM_SETTINGS:
-        _currentMenu = MENU_SETTINGS;
-        break;
-      case ITEM_SAVE:
-        _currentMenu = MENU_SAVE;
-        break;
-    }
+    enterNode(readMenuChild(node, _currentItem));
   }
 }
 
 void Menu::updateDigitMode(bool digitButtonPressed) {
   // Обробка натискання кнопки перемикання розрядів
-  static bool lastButtonState = false;
-  
-  if (digitButtonPressed && !lastButtonState) {
+  // (попередній стан - у полі об'єкта, а не в static: кожен Menu починає з відпущеної кнопки)
+  if (digitButtonPressed && !_lastDigitButton) {
     // Перемикаємо режим редагування розряду
     _digitMode = (DigitMode)((_digitMode + 1) % 3);
   }
   
-  lastButtonState = digitButtonPressed;
+  _lastDigitButton = digitButtonPressed;
 }
 
-void Menu::handleSetAngleMenu(int16_t encoderDelta, bool buttonPressed) {
-  // Редагування кута через інкрементальний енкодер з затримкою
-  unsigned long now = millis();
-  
-  // При натисканні кнопки енкодера - повернення на стартовий екран
+uint8_t Menu::accelerationFactor(uint16_t encoderSpeed) const {
+  if (encoderSpeed <= ENCODER_ACCEL_SLOW_DPS) {
+    return 1;
+  }
+  if (encoderSpeed >= ENCODER_ACCEL_FAST_DPS) {
+    return _encoderAccelMax;
+  }
+  // Лінійно між SLOW (x1) та FAST (xMAX)
+  return 1 + (uint8_t)((uint16_t)(_encoderAccelMax - 1) * (encoderSpeed - ENCODER_ACCEL_SLOW_DPS)
+                       / (ENCODER_ACCEL_FAST_DPS - ENCODER_ACCEL_SLOW_DPS));
+}
+
+void Menu::handleValue(const MenuNode& node, int16_t encoderDelta, bool buttonPressed, uint16_t encoderSpeed) {
+  // При натисканні кнопки енкодера - значення прийнято, повернення на стартовий екран
+  // (для кута - позначаємо його встановленим вручну, навіть якщо він не змінювався)
   if (buttonPressed) {
-    _manualAngleSet = true;
-    _currentMenu = MENU_SPLASH;
-    _currentItem = 0;
-    _shouldResetSplash = true;  // Встановлюємо прапорець для скидання сплеш-екрану
+    setValue(node.valueId, node.setting, getValue(node.valueId, node.setting));
+    finish(node.action);
     return;
   }
   
-  // Обробка обертання енкодера
-  if (encoderDelta != 0 && (now - _lastMenuChangeTime >= MENU_CHANGE_DELAY_MS)) {
-    // Визначаємо крок залежно від вибраного розряду
-    int16_t step = 0;
-    switch (_digitMode) {
-      case DIGIT_UNITS:
-        step = (encoderDelta > 0) ? 1 : -1;  // Одиниці: ±1
-        break;
-      case DIGIT_TENS:
-        step = (encoderDelta > 0) ? 10 : -10;  // Десятки: ±10
-        break;
-      case DIGIT_HUNDREDS:
-        step = (encoderDelta > 0) ? 100 : -100;  // Сотні: ±100
-        break;
-    }
-    
-    // Змінюємо кут з відповідним кроком
-    int32_t newAngle = (int32_t)_targetAngle + step;
-    
-    // Обмежуємо в межах 0-359
-    if (newAngle < 0) {
-      newAngle = 359;
-    } else if (newAngle >= 360) {
-      newAngle = 0;
+  // Обробка обертання енкодера: враховується кожне клацання (без затримки між змінами).
+  // В режимі одиниць повільне обертання дає ±step на клацання, швидке - з множником прискорення;
+  // десятки і сотні не прискорюються (там крок і так великий)
+  if (encoderDelta != 0) {
+    int32_t step = node.step;
+    if (!(node.flags & MENU_FLAG_DIGIT_MODE) || _digitMode == DIGIT_UNITS) {
+      step *= accelerationFactor(encoderSpeed);  // Одиниці (з прискоренням)
+    } else if (_digitMode == DIGIT_TENS) {
+      step *= 10;  // Десятки
+    } else {
+      step *= 100;  // Сотні
     }
     
-    _targetAngle = (uint16_t)newAngle;
-    
-    // Оновлюємо цільову позицію відносно нульової позиції
-    int32_t angleInSteps = angleToSteps(_targetAngle);
-    int32_t newTarget = _stepperZeroPosition + angleInSteps;
-    
-    // Нормалізуємо до діапазону 0-360 градусів
-    while (newTarget < 0) {
-      newTarget += STEPS_360;
+    // Змінюємо значення з відповідним кроком і переходимо через межі по колу
+    // (крок може бути більшим за весь діапазон)
+    int32_t range = (int32_t)node.maxValue - node.minValue + 1;
+    int32_t newValue = ((int32_t)getValue(node.valueId, node.setting) - node.minValue + encoderDelta * step) % range;
+    if (newValue < 0) {
+      newValue += range;
     }
-    while (newTarget >= STEPS_360) {
-      newTarget -= STEPS_360;
-    }
-    _targetPosition = newTarget;
-    
-    // Встановлюємо прапорець, що кут встановлений вручну
-    _manualAngleSet = true;
+    setValue(node.valueId, node.setting, (uint16_t)(newValue + node.minValue));
     
     // Запам'ятовуємо час зміни
+    _lastMenuChangeTime = millis();
+  }
+}
+
+void Menu::handleChoice(const MenuNode& node, int16_t encoderDelta, bool buttonPressed) {
+  // Перемикання варіантів по колу з затримкою між змінами
+  unsigned long now = millis();
+  
+  if (encoderDelta != 0 && (now - _lastMenuChangeTime >= MENU_CHANGE_DELAY_MS)) {
+    uint16_t value = getValue(node.valueId, node.setting);
+    if (encoderDelta > 0) {
+      value = (value + 1 >= node.itemCount) ? 0 : value + 1;
+    } else {
+      value = (value == 0) ? node.itemCount - 1 : value - 1;
+    }
+    setValue(node.valueId, node.setting, value);
     _lastMenuChangeTime = now;
   }
+  
+  // При натисканні кнопки повертаємось на стартовий екран
+  if (buttonPressed) {
+    finish(node.action);
+  }
 }
 
 void Menu::setTargetAngle(uint16_t angle) {
@@ -246,36 +389,6 @@ void Menu::setTargetAngle(uint16_t angle) {
   _manualAngleSet = true;
 }
 
-void Menu::handleSettingsMenu(int16_t encoderDelta, bool buttonPressed) {
-  // Обробка перемикання напрямку (CW/CCW)
-  unsigned long now = millis();
-  
-  if (encoderDelta != 0 && (now - _lastMenuChangeTime >= MENU_CHANGE_DELAY_MS)) {
-    // Перемикаємо напрямок
-    _selectedDirection = (_selectedDirection == DIR_CW) ? DIR_CCW : DIR_CW;
-    _lastMenuChangeTime = now;
-  }
-  
-  // При натисканні кнопки повертаємось на стартовий екран
-  if (buttonPressed) {
-    _currentMenu = MENU_SPLASH;
-    _currentItem = 0;
-    _shouldResetSplash = true;  // Встановлюємо прапорець для скидання сплеш-екрану
-    _lastMenuChangeTime = now;
-  }
-}
-
-void Menu::handleSaveMenu(bool buttonPressed) {
-  // При натисканні кнопки зберігаємо позицію та повертаємось на стартовий екран
-  if (buttonPressed) {
-    _shouldSave = true;
-    _currentMenu = MENU_SPLASH;
-    _currentItem = 0;
-    _shouldResetSplash = true;  // Встановлюємо прапорець для скидання сплеш-екрану
-    _lastMenuChangeTime = millis();
-  }
-}
-
 bool Menu::isPositionReached(int32_t currentPos, int32_t remaining) const {
   // Перевіряємо, чи поточна позиція відповідає цільовій
   int32_t effectivePos = currentPos + remaining;
@@ -287,18 +400,8 @@ bool Menu::isPositionReached(int32_t currentPos, int32_t remaining) const {
 
 void Menu::handleLongPress() {
   // Довге натискання в будь-якому меню (крім сплеш-екрану) - повертаємося на сплеш-екран
+  // (встановлений вручну кут залишається - _manualAngleSet не скидається)
   if (_currentMenu != MENU_SPLASH) {
-    // Зберігаємо інформацію про те, чи були в меню Set Angle (перед зміною меню)
-    bool wasInSetAngle = (_currentMenu == MENU_SET_ANGLE);
-    
-    _currentMenu = MENU_SPLASH;
-    _currentItem = 0;
-    _shouldResetSplash = true;
-    _lastMenuChangeTime = millis();
-    
-    // Зберігаємо встановлений вручну кут, якщо були в меню Set Angle
-    if (wasInSetAngle) {
-      // _manualAngleSet залишається true
-    }
+    finish(MENU_ACTION_NONE);
   }
 }
@@ -3,6 +3,9 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "menu_node.h"
+
+struct Settings;
 
 // Типи напрямку обертання
 enum RotationDirection {
@@ -13,26 +16,17 @@ enum RotationDirection {
 // Типи меню
 enum MenuType {
   MENU_SPLASH,         // Початковий екран
-  MENU_MAIN,           // Головне меню
-  MENU_SET_ANGLE,      // Встановлення кута (редагування)
-  MENU_SETTINGS,       // Налаштування
-  MENU_SAVE            // Збереження
-};
-
-// Пункти головного меню
-enum MainMenuItem {
-  ITEM_SET_ANGLE = 0,  // Встановлення кута
-  ITEM_SETTINGS = 1,
-  ITEM_SAVE = 2,
-  ITEM_COUNT = 3
+  MENU_TREE            // Дерево меню (поточний вузол - getCurrentNode())
 };
 
+// Навігація по дереву меню з menu.cpp (опис вузлів - у flash, див. menu_node.h)
 class Menu {
 public:
   Menu();
   
   // Оновлення меню з інкрементальним енкодером (навігація)
-  void updateNavigation(int16_t encoderDelta, bool buttonPressed);
+  // encoderSpeed - швидкість обертання (клацань/с) для прискорення при введенні кута
+  void updateNavigation(int16_t encoderDelta, bool buttonPressed, uint16_t encoderSpeed = 0);
   
   // Оновлення режиму редагування розрядів (для меню Set Angle)
   void updateDigitMode(bool digitButtonPressed);
@@ -57,14 +51,20 @@ public:
   // Отримання поточного типу меню
   MenuType getCurrentMenu() const { return _currentMenu; }
   
-  // Отримання поточного пункту меню
+  // Поточний вузол дерева (у flash; nullptr на сплеш-екрані)
+  const MenuNode* getCurrentNode() const { return _node; }
+  
+  // Отримання поточного пункту меню (для вузла-списку)
   uint8_t getCurrentItem() const { return _currentItem; }
   
+  // Значення змінної, яку редагує поточний вузол
+  uint16_t getCurrentValue() const;
+  
   // Отримання цільового кута
   uint16_t getTargetAngle() const { return _targetAngle; }
   
   // Перевірка, чи активний режим редагування кута
-  bool isEditingAngle() const { return _currentMenu == MENU_SET_ANGLE; }
+  bool isEditingAngle() const;
   
   // Отримання поточного режиму редагування розряду
   uint8_t getDigitMode() const { return _digitMode; }
@@ -95,11 +95,26 @@ public:
   // Отримання нульової позиції двигуна
   int32_t getStepperZeroPosition() const { return _stepperZeroPosition; }
   
+  // Множник прискорення енкодера на швидкості ENCODER_ACCEL_FAST_DPS (з налаштувань)
+  void setEncoderAccelerationMax(uint8_t factor) { _encoderAccelMax = factor; }
+  
+  // Налаштування, які редагують вузли MENU_VALUE_SETTING (зміна - через Settings::set, з бітом overridden)
+  void setSettings(Settings* settings) { _settings = settings; }
+  
+  // Параметр змінено в меню - його треба застосувати до модулів (одразу, під час редагування)
+  bool shouldApplySettings() const { return _shouldApplySettings; }
+  void clearApplySettingsFlag() { _shouldApplySettings = false; }
+  
+  // Вихід з меню після зміни параметрів - налаштування треба зберегти
+  bool shouldSaveSettings() const { return _shouldSaveSettings; }
+  void clearSaveSettingsFlag() { _shouldSaveSettings = false; }
+  
   // Обробка довгого натискання кнопки (повернення на сплеш-екран)
   void handleLongPress();
   
 private:
   MenuType _currentMenu;
+  const MenuNode* _node;  // Поточний вузол дерева (у flash)
   uint8_t _currentItem;
   uint16_t _targetAngle;
   int32_t _targetPosition;
@@ -111,6 +126,11 @@ private:
   unsigned long _lastMenuChangeTime;  // Час останньої зміни пункту меню
   static const unsigned long MENU_CHANGE_DELAY_MS = 150;  // Затримка між змінами пунктів меню
   int32_t _stepperZeroPosition;  // Нульова позиція двигуна (встановлюється при обнуленні енкодера)
+  uint8_t _encoderAccelMax;  // Множник кроку на швидкості ENCODER_ACCEL_FAST_DPS і вище
+  Settings* _settings;  // nullptr - вузли MENU_VALUE_SETTING показують 0 і нічого не змінюють
+  bool _settingsChanged;  // Параметри змінено з моменту входу в меню
+  bool _shouldApplySettings;
+  bool _shouldSaveSettings;
   
   // Режими редагування розрядів кута
   enum DigitMode {
@@ -119,13 +139,18 @@ private:
     DIGIT_HUNDREDS = 2  // Сотні (±100)
   };
   DigitMode _digitMode;  // Поточний режим редагування розряду
+  bool _lastDigitButton;  // Стан кнопки розрядів у попередньому виклику updateDigitMode()
   RotationDirection _selectedDirection;  // Вибраний напрямок руху (CW/CCW)
   
   int32_t angleToSteps(uint16_t angle);
-  void handleMainMenu(int16_t encoderDelta, bool buttonPressed);
-  void handleSetAngleMenu(int16_t encoderDelta, bool buttonPressed);
-  void handleSettingsMenu(int16_t encoderDelta, bool buttonPressed);
-  void handleSaveMenu(bool buttonPressed);
+  uint8_t accelerationFactor(uint16_t encoderSpeed) const;  // Множник кроку за швидкістю енкодера
+  uint16_t getValue(uint8_t valueId, uint8_t setting) const;  // Змінна, прив'язана до вузла (MenuValueId, SettingsTag)
+  void setValue(uint8_t valueId, uint8_t setting, uint16_t value);
+  void enterNode(const MenuNode* node);
+  void finish(uint8_t action);  // Виконує дію вузла і повертає на сплеш-екран
+  void handleList(const MenuNode& node, int16_t encoderDelta, bool buttonPressed);
+  void handleValue(const MenuNode& node, int16_t encoderDelta, bool buttonPressed, uint16_t encoderSpeed);
+  void handleChoice(const MenuNode& node, int16_t encoderDelta, bool buttonPressed);
 };
 
 #endif
@@ -0,0 +1,75 @@
+#ifndef MENU_NODE_H
+#define MENU_NODE_H
+
+#include <Arduino.h>
+#if defined(__AVR__)
+  #include <avr/pgmspace.h>
+#endif
+
+// Опис дерева меню: вузли, списки дочірніх вузлів і всі рядки лежать у flash (PROGMEM)
+// і читаються через pgm_read_*/memcpy_P, тому не займають SRAM.
+// Меню (Menu) і дисплей (Display) інтерпретують вузли за типом - новий пункт
+// додається одним описом вузла в menu.cpp без нового коду.
+
+// Тип вузла визначає навігацію і вигляд екрану
+enum MenuNodeType {
+  MENU_NODE_LIST,     // Список дочірніх вузлів (енкодер - вибір, кнопка - перехід)
+  MENU_NODE_VALUE,    // Числове значення в діапазоні minValue..maxValue по колу
+  MENU_NODE_CHOICE,   // Вибір одного з варіантів (options)
+  MENU_NODE_CONFIRM   // Підтвердження дії кнопкою
+};
+
+// Змінна меню, яку редагує вузол VALUE/CHOICE
+enum MenuValueId {
+  MENU_VALUE_NONE,
+  MENU_VALUE_TARGET_ANGLE,  // Цільовий кут (градуси)
+  MENU_VALUE_DIRECTION,     // Напрямок руху (RotationDirection)
+  MENU_VALUE_SETTING        // Параметр з Settings (тег - у полі setting)
+};
+
+// Дія після натискання кнопки на вузлі (після неї - повернення на сплеш-екран)
+enum MenuAction {
+  MENU_ACTION_NONE,
+  MENU_ACTION_SAVE  // Зберегти позицію
+};
+
+enum MenuNodeFlags {
+  MENU_FLAG_DEGREES = 0x01,    // Після значення - символ градуса
+  MENU_FLAG_DIGIT_MODE = 0x02  // Кнопка розрядів перемикає крок: одиниці/десятки/сотні
+};
+
+struct MenuNode {
+  uint8_t type;       // MenuNodeType
+  uint8_t flags;      // MenuNodeFlags
+  uint8_t valueId;    // MenuValueId
+  uint8_t action;     // MenuAction
+  const char* label;  // Текст пункту у батьківському списку (PROGMEM)
+  const char* title;  // Заголовок власного екрану (PROGMEM, nullptr - немає)
+  const MenuNode* const* children;  // LIST: масив вузлів (PROGMEM)
+  const char* const* options;       // CHOICE: масив рядків (PROGMEM)
+  uint8_t itemCount;  // Кількість дочірніх вузлів або варіантів
+  uint16_t minValue;  // VALUE: діапазон (включно), за межами - перехід по колу
+  uint16_t maxValue;
+  uint16_t step;      // VALUE: крок на одне клацання (у режимі одиниць)
+  uint8_t setting;    // MENU_VALUE_SETTING: тег параметра (SettingsTag)
+};
+
+// Копія вузла з flash у RAM (на час обробки)
+inline void readMenuNode(const MenuNode* node, MenuNode& out) {
+  memcpy_P(&out, node, sizeof(MenuNode));
+}
+
+inline const MenuNode* readMenuChild(const MenuNode& list, uint8_t index) {
+  return (const MenuNode*)pgm_read_ptr(&list.children[index]);
+}
+
+inline const char* readMenuOption(const MenuNode& choice, uint8_t index) {
+  return (const char*)pgm_read_ptr(&choice.options[index]);
+}
+
+// Рядок з flash для Print::print()
+inline const __FlashStringHelper* menuText(const char* text) {
+  return reinterpret_cast<const __FlashStringHelper*>(text);
+}
+
+#endif
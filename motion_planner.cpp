@@ -0,0 +1,72 @@
+#include "motion_planner.h"
+
+MotionPlanner::MotionPlanner(uint32_t tickHz)
+  : _tickHz(tickHz), _c0(INTERVAL_MAX_Q8), _cMin(INTERVAL_MAX_Q8), _c(0), _n(0) {
+}
+
+uint16_t MotionPlanner::isqrt32(uint32_t value) {
+  // Цілочисельний квадратний корінь (побітовий метод)
+  uint32_t result = 0;
+  uint32_t bit = 1UL << 30;
+  while (bit > value) {
+    bit >>= 2;
+  }
+  while (bit != 0) {
+    if (value >= result + bit) {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint16_t)result;
+}
+
+void MotionPlanner::configure(uint16_t maxSpeed, uint16_t accel) {
+  if (maxSpeed == 0) maxSpeed = 1;
+  if (accel == 0) accel = 1;
+  
+  // c0 = 0.676 * f * sqrt(2 / a); sqrt(2 / a) = sqrt(2e8 / a) / 1e4
+  // Коефіцієнт 0.676 компенсує похибку рекурентної формули на першому кроці
+  uint32_t c0 = (_tickHz / 1000UL) * 676UL / 100UL * isqrt32(200000000UL / accel) / 100UL;
+  uint32_t cMin = _tickHz / maxSpeed;
+  
+  if (c0 > 0xFFFFUL) c0 = 0xFFFFUL;
+  if (cMin > 0xFFFFUL) cMin = 0xFFFFUL;
+  if (cMin == 0) cMin = 1;
+  if (c0 < cMin) c0 = cMin;
+  
+  _c0 = c0 << 8;
+  _cMin = cMin << 8;
+}
+
+void MotionPlanner::reset() {
+  _n = 0;
+  _c = _c0;
+}
+
+uint16_t MotionPlanner::nextInterval(uint32_t stepsLeft) {
+  if (_n == 0) {
+    // Перший інтервал з місця
+    _c = _c0;
+    _n = 1;
+  } else if (stepsLeft < _n) {
+    // Кроків залишилось менше, ніж інтервалів на рампі - гальмуємо
+    if (_n > 1) {
+      _c += (_c << 1) / ((uint32_t)_n * 4 - 5);
+      if (_c > _c0) _c = _c0;
+      _n--;
+    }
+  } else if (_c > _cMin) {
+    // Розгін до максимальної швидкості
+    _c -= (_c << 1) / ((uint32_t)_n * 4 + 1);
+    if (_c < _cMin) _c = _cMin;
+    _n++;
+  }
+  // Інакше - рух з постійною (максимальною) швидкістю
+  
+  uint32_t interval = (_c + 128) >> 8;
+  if (interval > 0xFFFFUL) interval = 0xFFFFUL;
+  return (uint16_t)interval;
+}
@@ -0,0 +1,35 @@
+#ifndef MOTION_PLANNER_H
+#define MOTION_PLANNER_H
+
+#include <Arduino.h>
+
+// Планувальник профілю швидкості для крокового двигуна.
+// Трапецієвидний профіль з постійним прискоренням, інтервал між кроками
+// обчислюється рекурентно (D. Austin, "Generate stepper-motor speed profiles in real time"):
+//   розгін:      c[n] = c[n-1] - 2*c[n-1] / (4n + 1)
+//   гальмування: c[n-1] = c[n] + 2*c[n] / (4n - 1)
+// (c[0] - перший інтервал з місця, n - номер інтервалу на рампі)
+// Вся арифметика цілочисельна, інтервали зберігаються у форматі Q24.8 (тіки таймера * 256),
+// тому тривалість руху залежить тільки від відстані та налаштувань, а не від швидкості loop().
+class MotionPlanner {
+public:
+  MotionPlanner(uint32_t tickHz);
+  void configure(uint16_t maxSpeed, uint16_t accel);  // кроків/с, кроків/с²
+  void reset();  // Двигун зупинений - наступний рух починається з розгону
+  uint16_t nextInterval(uint32_t stepsLeft);  // Інтервал (тіки) до наступного кроку; stepsLeft - кроків ще не зроблено
+  bool isStopped() const { return _n == 0; }
+  uint16_t getRampSteps() const { return _n; }  // Інтервалів на рампі (приблизно кроків, потрібних для зупинки)
+  
+private:
+  uint32_t _tickHz;
+  uint32_t _c0;    // Перший інтервал розгону, Q24.8
+  uint32_t _cMin;  // Інтервал на максимальній швидкості, Q24.8
+  uint32_t _c;     // Поточний інтервал, Q24.8
+  uint16_t _n;     // Кількість інтервалів на рампі, _c = c[_n - 1] (0 = стоїмо)
+  
+  static const uint32_t INTERVAL_MAX_Q8 = 0xFFFFUL << 8;  // Обмеження 16-бітного регістра порівняння
+  
+  static uint16_t isqrt32(uint32_t value);
+};
+
+#endif
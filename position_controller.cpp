@@ -0,0 +1,88 @@
+#include "position_controller.h"
+
+PositionController::PositionController()
+  : _targetCdeg(0), _integral(0), _lastError(0), _idleSince(0), _attempts(0),
+    _stepLossCount(0), _settled(false), _failed(false), _wasIdle(false),
+    _toleranceCdeg(CLOSED_LOOP_TOLERANCE_CDEG), _kpPercent(CLOSED_LOOP_KP_PERCENT),
+    _kiPercent(CLOSED_LOOP_KI_PERCENT), _maxCorrectionSteps(CLOSED_LOOP_MAX_CORRECTION_STEPS) {
+}
+
+void PositionController::configure(uint16_t toleranceCdeg, uint8_t kpPercent, uint8_t kiPercent, uint16_t maxCorrectionSteps) {
+  _toleranceCdeg = toleranceCdeg;
+  _kpPercent = kpPercent;
+  _kiPercent = kiPercent;
+  _maxCorrectionSteps = maxCorrectionSteps;
+}
+
+void PositionController::begin(uint16_t targetCdeg) {
+  _targetCdeg = targetCdeg;
+  _integral = 0;
+  _lastError = 0;
+  _attempts = 0;
+  _settled = false;
+  _failed = false;
+  _wasIdle = false;
+}
+
+int16_t PositionController::wrapError(int32_t diff) {
+  while (diff > 18000) diff -= 36000;
+  while (diff < -18000) diff += 36000;
+  return (int16_t)diff;
+}
+
+int32_t PositionController::update(uint16_t encoderCdeg, bool motorIdle, unsigned long now) {
+  if (_settled || _failed) {
+    return 0;
+  }
+  
+  // Поки двигун рухається - тільки запам'ятовуємо момент зупинки
+  if (!motorIdle) {
+    _wasIdle = false;
+    return 0;
+  }
+  if (!_wasIdle) {
+    _wasIdle = true;
+    _idleSince = now;
+  }
+  
+  // Чекаємо, поки механіка і фільтр енкодера заспокояться
+  if (now - _idleSince < CLOSED_LOOP_SETTLE_MS) {
+    return 0;
+  }
+  
+  int16_t error = wrapError((int32_t)_targetCdeg - encoderCdeg);
+  _lastError = error;
+  
+  if (abs(error) <= _toleranceCdeg) {
+    _settled = true;
+    return 0;
+  }
+  
+  if (_attempts >= CLOSED_LOOP_MAX_ATTEMPTS) {
+    _failed = true;
+    return 0;
+  }
+  
+  // Двигун вважає, що він на місці, а енкодер показує велику розбіжність - кроки втрачено
+  if (abs(error) >= STEP_LOSS_THRESHOLD_CDEG && _stepLossCount < 255) {
+    _stepLossCount++;
+  }
+  
+  // PI-регулятор: u = Kp * e + Ki * сума(e)
+  _integral += error;
+  if (_integral > INTEGRAL_LIMIT_CDEG) _integral = INTEGRAL_LIMIT_CDEG;
+  if (_integral < -INTEGRAL_LIMIT_CDEG) _integral = -INTEGRAL_LIMIT_CDEG;
+  int32_t outputCdeg = ((int32_t)error * _kpPercent + _integral * _kiPercent) / 100;
+  
+  // Переводимо в кроки (мінімум один крок у бік помилки)
+  int32_t steps = outputCdeg * STEPS_360 / 36000L;
+  if (steps == 0) {
+    steps = (error > 0) ? 1 : -1;
+  }
+  if (steps > _maxCorrectionSteps) steps = _maxCorrectionSteps;
+  if (steps < -_maxCorrectionSteps) steps = -_maxCorrectionSteps;
+  
+  _attempts++;
+  _wasIdle = false;  // Після корекції знову чекаємо заспокоєння
+  return steps;
+}
@@ -0,0 +1,46 @@
+#ifndef POSITION_CONTROLLER_H
+#define POSITION_CONTROLLER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Замкнений контур позиціювання за абсолютним енкодером.
+// Після того як Stepper відпрацював рух (open-loop), регулятор чекає заспокоєння,
+// порівнює кут енкодера з заданим і видає обмежену корекцію в кроках (PI-регулятор).
+// Кути - в сотих долях градуса (0-35999)
+class PositionController {
+public:
+  PositionController();
+  // Параметри регулятора (за замовчуванням - CLOSED_LOOP_* з config.h)
+  void configure(uint16_t toleranceCdeg, uint8_t kpPercent, uint8_t kiPercent, uint16_t maxCorrectionSteps);
+  void begin(uint16_t targetCdeg);  // Починає нове позиціювання
+  // Викликається кожну ітерацію loop(); повертає логічну корекцію в кроках (0 = нічого не робити).
+  // Інверсія напрямку (Stepper::setDirectionInvert) узгоджує логічні кроки з кутом енкодера,
+  // тому корекція має той самий знак, що й помилка
+  int32_t update(uint16_t encoderCdeg, bool motorIdle, unsigned long now);
+  bool isSettled() const { return _settled; }  // Енкодер збігся з ціллю в межах допуску
+  bool hasFailed() const { return _failed; }  // Вичерпано кількість спроб корекції
+  uint8_t getStepLossCount() const { return _stepLossCount; }  // Скільки разів виявлено втрату кроків
+  int16_t getLastError() const { return _lastError; }  // Остання помилка (соті градуса)
+  
+private:
+  uint16_t _targetCdeg;
+  int32_t _integral;  // Сума помилок (соті градуса)
+  int16_t _lastError;
+  unsigned long _idleSince;  // Час зупинки двигуна
+  uint8_t _attempts;
+  uint8_t _stepLossCount;
+  bool _settled;
+  bool _failed;
+  bool _wasIdle;
+  uint16_t _toleranceCdeg;
+  uint8_t _kpPercent;
+  uint8_t _kiPercent;
+  int32_t _maxCorrectionSteps;
+  
+  static const int32_t INTEGRAL_LIMIT_CDEG = 2000;  // Обмеження інтегральної складової (anti-windup)
+  
+  static int16_t wrapError(int32_t diff);  // Найкоротша різниця кутів у діапазоні ±18000
+};
+
+#endif
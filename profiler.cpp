@@ -0,0 +1,139 @@
+#include "profiler.h"
+
+#if PROFILER_ENABLED
+
+Profiler::SectionStats Profiler::_stats[PROFILE_SECTION_COUNT];
+uint32_t Profiler::_lastMarkUs[PROFILE_SECTION_COUNT];
+uint16_t Profiler::_marked = 0;
+
+// Назви секцій для звіту (порядок - як у ProfileSection)
+static const char NAME_LOOP[] PROGMEM = "loop";
+static const char NAME_STEPPER_GAP[] PROGMEM = "step gap";
+static const char NAME_MOTION_PERIOD[] PROGMEM = "mot per";
+static const char NAME_MOTION[] PROGMEM = "motion";
+static const char NAME_INPUT[] PROGMEM = "input";
+static const char NAME_SENSING[] PROGMEM = "sensing";
+static const char NAME_PERSIST[] PROGMEM = "persist";
+static const char NAME_UI[] PROGMEM = "ui";
+static const char* const SECTION_NAMES[PROFILE_SECTION_COUNT] PROGMEM = {
+  NAME_LOOP, NAME_STEPPER_GAP, NAME_MOTION_PERIOD, NAME_MOTION,
+  NAME_INPUT, NAME_SENSING, NAME_PERSIST, NAME_UI
+};
+
+void Profiler::begin() {
+  Serial.begin(PROFILER_SERIAL_BAUD);
+  reset();
+}
+
+uint8_t Profiler::bucketOf(uint32_t us) {
+  // Кількість значущих бітів: 0 -> 0, 1 -> 1, 2-3 -> 2, 4-7 -> 3, ...
+  uint8_t bucket = 0;
+  while (us != 0 && bucket < BUCKETS - 1) {
+    us >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+void Profiler::record(uint8_t section, uint32_t us) {
+  SectionStats& stats = _stats[section];
+  uint16_t value = (us > 0xFFFF) ? 0xFFFF : us;
+
+  // Лічильник і сума діляться навпіл разом - середнє зберігається, старі зразки важать менше
+  if (stats.count == 0xFFFF) {
+    stats.count >>= 1;
+    stats.sumUs >>= 1;
+  }
+  if (stats.count == 0 || value < stats.minUs) {
+    stats.minUs = value;
+  }
+  if (value > stats.maxUs) {
+    stats.maxUs = value;
+  }
+  stats.count++;
+  stats.sumUs += value;
+
+  uint8_t bucket = bucketOf(us);
+  if (stats.histogram[bucket] == 0xFF) {
+    // Ділимо всі кошики - форма розподілу зберігається
+    for (uint8_t i = 0; i < BUCKETS; i++) {
+      stats.histogram[i] >>= 1;
+    }
+  }
+  stats.histogram[bucket]++;
+}
+
+void Profiler::markInterval(uint8_t section) {
+  uint32_t now = micros();
+  uint16_t bit = 1 << section;
+  if (_marked & bit) {
+    record(section, now - _lastMarkUs[section]);
+  }
+  _lastMarkUs[section] = now;
+  _marked |= bit;
+}
+
+void Profiler::reset() {
+  for (uint8_t i = 0; i < PROFILE_SECTION_COUNT; i++) {
+    _stats[i] = SectionStats();
+  }
+  _marked = 0;
+}
+
+void Profiler::dump(Print& out) {
+  // section n min mean max (мкс), далі ненульові кошики: "<верхня межа:кількість"
+  out.println(F("section n min mean max [us]"));
+  for (uint8_t i = 0; i < PROFILE_SECTION_COUNT; i++) {
+    const SectionStats& stats = _stats[i];
+    out.print(reinterpret_cast<const __FlashStringHelper*>(pgm_read_ptr(&SECTION_NAMES[i])));
+    out.print(' ');
+    out.print(stats.count);
+    if (stats.count == 0) {
+      out.println();
+      continue;
+    }
+    out.print(' ');
+    out.print(stats.minUs);
+    out.print(' ');
+    out.print(stats.sumUs / stats.count);
+    out.print(' ');
+    out.println(stats.maxUs);
+
+    for (uint8_t bucket = 0; bucket < BUCKETS; bucket++) {
+      if (stats.histogram[bucket] == 0) {
+        continue;
+      }
+      out.print(F("  "));
+      if (bucket == BUCKETS - 1) {
+        out.print(F(">="));
+        out.print(1UL << (BUCKETS - 2));
+      } else {
+        out.print('<');
+        out.print(1UL << bucket);
+      }
+      out.print(':');
+      out.print(stats.histogram[bucket]);
+    }
+    out.println();
+  }
+}
+
+void Profiler::poll() {
+  if (!Serial.available()) {
+    return;
+  }
+  switch (Serial.read()) {
+    case 'p':
+      dump(Serial);
+      break;
+    case 'r':
+      reset();
+      break;
+    default:
+      return;
+  }
+  // Інтервал, що включає виведення звіту, не враховується
+  _marked = 0;
+}
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Профілювання loop(): тривалість секцій і інтервали між подіями за micros().
+// Для кожної секції - кількість, мінімум, максимум, середнє і гістограма з кошиками
+// за степенями двійки. Звіт виводиться в Serial за командою ('p' - звіт, 'r' - скидання).
+// При PROFILER_ENABLED == 0 макроси PROFILE_* порожні, а клас не компілюється.
+//
+//   PROFILE_SCOPE(PROFILE_UI);           // час від цього місця до кінця блоку
+//   PROFILE_INTERVAL(PROFILE_LOOP_GAP);  // час від попереднього виклику з тією ж секцією
+
+enum ProfileSection {
+  PROFILE_LOOP,           // Один прохід loop()
+  PROFILE_STEPPER_GAP,    // Інтервал між викликами stepper.update()
+  PROFILE_MOTION_PERIOD,  // Інтервал між запусками задачі руху (джитер такту)
+  PROFILE_MOTION,         // Задача руху
+  PROFILE_INPUT,          // Задача введення (кнопки, енкодер меню)
+  PROFILE_SENSING,        // Задача абсолютного енкодера (АЦП)
+  PROFILE_PERSIST,        // Задача збереження (EEPROM)
+  PROFILE_UI,             // Задача інтерфейсу (дисплей)
+  PROFILE_SECTION_COUNT
+};
+
+#if PROFILER_ENABLED
+
+class Profiler {
+public:
+  // Кошик k: від 2^(k-1) до 2^k - 1 мкс (кошик 0 - 0 мкс), останній - 2^14 мкс і більше
+  static const uint8_t BUCKETS = 16;
+
+  static void begin();  // Запускає Serial
+  static void record(uint8_t section, uint32_t us);
+  static void markInterval(uint8_t section);  // Записує час від попередньої позначки секції
+  static void reset();
+  static void dump(Print& out);
+  static void poll();  // Команди з Serial
+
+private:
+  struct SectionStats {
+    uint16_t count;
+    uint16_t minUs;
+    uint16_t maxUs;
+    uint32_t sumUs;
+    uint8_t histogram[BUCKETS];  // При переповненні кошика всі кошики діляться навпіл
+  };
+
+  static SectionStats _stats[PROFILE_SECTION_COUNT];
+  static uint32_t _lastMarkUs[PROFILE_SECTION_COUNT];
+  static uint16_t _marked;  // Біт = у секції є попередня позначка
+
+  static uint8_t bucketOf(uint32_t us);
+};
+
+// Вимірює час від створення до кінця блоку
+class ProfileScope {
+public:
+  ProfileScope(uint8_t section) : _startUs(micros()), _section(section) {}
+  ~ProfileScope() { Profiler::record(_section, micros() - _startUs); }
+
+private:
+  uint32_t _startUs;
+  uint8_t _section;
+};
+
+  #define PROFILE_BEGIN() Profiler::begin()
+  #define PROFILE_POLL() Profiler::poll()
+  #define PROFILE_SCOPE(section) ProfileScope profileScope(section)
+  #define PROFILE_INTERVAL(section) Profiler::markInterval(section)
+#else
+  #define PROFILE_BEGIN() ((void)0)
+  #define PROFILE_POLL() ((void)0)
+  #define PROFILE_SCOPE(section) ((void)0)
+  #define PROFILE_INTERVAL(section) ((void)0)
+#endif
+
+#endif
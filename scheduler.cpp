@@ -0,0 +1,84 @@
+#include "scheduler.h"
+
+Scheduler::Scheduler() : _taskCount(0) {
+}
+
+int8_t Scheduler::addTask(TaskFunction function, uint16_t periodMs, uint8_t priority, uint16_t budgetUs) {
+  if (_taskCount >= SCHEDULER_MAX_TASKS) {
+    return -1;
+  }
+  Task& task = _tasks[_taskCount];
+  task.function = function;
+  task.periodUs = periodMs * 1000UL;
+  task.releaseUs = micros();
+  task.budgetUs = budgetUs;
+  task.priority = priority;
+  task.stats = TaskStats();
+  return _taskCount++;
+}
+
+void Scheduler::start() {
+  uint32_t now = micros();
+  for (uint8_t i = 0; i < _taskCount; i++) {
+    _tasks[i].releaseUs = now;
+  }
+}
+
+void Scheduler::resetStats() {
+  for (uint8_t i = 0; i < _taskCount; i++) {
+    _tasks[i].stats = TaskStats();
+  }
+}
+
+void Scheduler::saturatingIncrement(uint16_t& counter) {
+  if (counter != 0xFFFF) {
+    counter++;
+  }
+}
+
+bool Scheduler::run() {
+  // Вибираємо задачу: найвищий пріоритет, потім найбільше запізнення
+  uint32_t now = micros();
+  Task* selected = nullptr;
+  uint32_t selectedLateness = 0;
+  for (uint8_t i = 0; i < _taskCount; i++) {
+    Task& task = _tasks[i];
+    uint32_t lateness = now - task.releaseUs;
+    if ((int32_t)lateness < 0) {
+      continue;  // Такт ще не настав
+    }
+    if (!selected || task.priority < selected->priority ||
+        (task.priority == selected->priority && lateness > selectedLateness)) {
+      selected = &task;
+      selectedLateness = lateness;
+    }
+  }
+  if (!selected) {
+    return false;
+  }
+
+  Task& task = *selected;
+  TaskStats& stats = task.stats;
+  task.function();
+  uint32_t duration = micros() - now;
+
+  saturatingIncrement(stats.runs);
+  if (duration > task.budgetUs) {
+    saturatingIncrement(stats.overruns);
+  }
+  if (duration > stats.maxDurationUs) {
+    stats.maxDurationUs = (duration > 0xFFFF) ? 0xFFFF : duration;
+  }
+  if (selectedLateness > stats.maxLatenessUs) {
+    stats.maxLatenessUs = (selectedLateness > 0xFFFF) ? 0xFFFF : selectedLateness;
+  }
+
+  // Наступний такт - через період від поточного; якщо вже пропущено цілі такти,
+  // вони не наздоганяються серією запусків, а рахуються як пропущені
+  task.releaseUs += task.periodUs;
+  while ((int32_t)(now - task.releaseUs) >= (int32_t)task.periodUs) {
+    task.releaseUs += task.periodUs;
+    saturatingIncrement(stats.missed);
+  }
+  return true;
+}
@@ -0,0 +1,50 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+typedef void (*TaskFunction)();
+
+// Статистика задачі (час у мікросекундах)
+struct TaskStats {
+  uint16_t runs;          // Кількість запусків (насичується на 0xFFFF)
+  uint16_t overruns;      // Запуски, довші за бюджет
+  uint16_t missed;        // Пропущені такти (задача не встигла запуститись до наступного)
+  uint16_t maxDurationUs; // Найдовший запуск
+  uint16_t maxLatenessUs; // Найбільше запізнення старту відносно такту (джитер)
+};
+
+// Кооперативний планувальник з фіксованим тактом: кожна задача має період, пріоритет
+// (0 - найвищий) і бюджет часу. run() за один виклик запускає одну задачу - найпріоритетнішу
+// з тих, чий такт настав (при рівному пріоритеті - ту, що чекає довше), тому задача з вищим
+// пріоритетом чекає не довше за один запуск іншої задачі. Такти відлічуються від попереднього
+// такту, а не від фактичного запуску, тому запізнення не накопичується.
+// Задачі не витісняються: довгу роботу задача має ділити на частини сама.
+class Scheduler {
+public:
+  Scheduler();
+  int8_t addTask(TaskFunction function, uint16_t periodMs, uint8_t priority, uint16_t budgetUs);  // Номер задачі; -1 - немає місця
+  void start();  // Перші такти всіх задач - від поточного моменту
+  bool run();  // Запускає одну задачу, якщо її такт настав; false - запускати нічого
+  const TaskStats& getStats(uint8_t task) const { return _tasks[task].stats; }
+  uint8_t getTaskCount() const { return _taskCount; }
+  void resetStats();
+
+private:
+  struct Task {
+    TaskFunction function;
+    uint32_t periodUs;
+    uint32_t releaseUs;  // Момент поточного такту
+    uint16_t budgetUs;
+    uint8_t priority;
+    TaskStats stats;
+  };
+
+  Task _tasks[SCHEDULER_MAX_TASKS];
+  uint8_t _taskCount;
+
+  static void saturatingIncrement(uint16_t& counter);
+};
+
+#endif
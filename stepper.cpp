@@ -1,9 +1,34 @@
 #include "stepper.h"
+#include "fast_pin.h"
+
+Stepper* Stepper::_instance = nullptr;
+
+#if defined(__AVR__)
+// Timer1 в режимі CTC з дільником 8: один тік = 0.5 мкс при 16 МГц
+#define STEPPER_TIMER_CLOCK_BITS (_BV(CS11))
+
+ISR(TIMER1_COMPA_vect) {
+  Stepper::timerIsr();
+}
+#endif
 
 Stepper::Stepper(uint8_t stepPin, uint8_t dirPin, uint8_t enablePin)
-  : _stepPin(stepPin), _dirPin(dirPin), _enablePin(enablePin), _position(0), 
-    _remaining(0), _lastStepTime(0), _currentStepDelay(STEP_DELAY_ACCEL_US), _currentDir(0), 
-    _directionInvert(false), _distanceToTarget(0), _enabled(true) {
+  : _stepPin(stepPin), _dirPin(dirPin), _enablePin(enablePin), _enabled(true), _position(0), 
+    _remaining(0), _pending(0), _lastStepTime(0), _stepInterval(0), _currentDir(0), 
+    _directionInvert(false), _timerRunning(false),
+#if defined(__AVR__)
+    _planner(F_CPU / 8UL) {
+#else
+    _planner(1000000UL) {  // Опитувальний режим рахує інтервали в мікросекундах
+#endif
+  _instance = this;
+  _planner.configure(STEPPER_MAX_SPEED_SPS, STEPPER_ACCEL_SPS2);
+}
+
+void Stepper::setMotionLimits(uint16_t maxSpeedSps, uint16_t accelSps2) {
+  noInterrupts();
+  _planner.configure(maxSpeedSps, accelSps2);
+  interrupts();
 }
 
 void Stepper::begin() {
@@ -15,12 +40,45 @@ void Stepper::begin() {
   // ENABLE активний низьким рівнем (LOW = утримується, HIGH = знято з утримання)
   digitalWrite(_enablePin, LOW);  // Початково утримується
   _enabled = true;
+  
+#if defined(__AVR__)
+  // Timer1: режим CTC (скидання по OCR1A), тактування вимкнене до першого move()
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12);
+  TCNT1 = 0;
+  OCR1A = 0xFFFF;
+  TIMSK1 |= _BV(OCIE1A);
+  _timerRunning = false;
+  interrupts();
+#endif
 }
 
 void Stepper::setEnabled(bool enabled) {
   _enabled = enabled;
   // ENABLE активний низьким рівнем: LOW = утримується, HIGH = знято з утримання
-  digitalWrite(_enablePin, enabled ? LOW : HIGH);
+  FastPin<ENABLE_PIN>::write(!enabled);
+}
+
+int32_t Stepper::getPosition() const {
+  noInterrupts();
+  int32_t position = _position;
+  interrupts();
+  return position;
+}
+
+uint16_t Stepper::getStepInterval() const {
+  noInterrupts();
+  uint16_t interval = _stepInterval;
+  interrupts();
+  return interval;
+}
+
+int32_t Stepper::getRemaining() const {
+  noInterrupts();
+  int32_t remaining = _remaining + _pending;
+  interrupts();
+  return remaining;
 }
 
 void Stepper::setPosition(int32_t position) {
@@ -31,19 +89,19 @@ void Stepper::setPosition(int32_t position) {
   while (position >= STEPS_360) {
     position -= STEPS_360;
   }
+  noInterrupts();
+  stopTimer();
   _position = position;
   _remaining = 0;
-  _currentStepDelay = STEP_DELAY_ACCEL_US;  // Скидаємо затримку до початкової
+  _pending = 0;
+  _planner.reset();  // Наступний рух починається з розгону
+  interrupts();
 }
 
 void Stepper::setDirectionInvert(bool invert) {
   _directionInvert = invert;
 }
 
-void Stepper::setDistanceToTarget(int32_t steps) {
-  _distanceToTarget = abs(steps);
-}
-
 int8_t Stepper::getPhysicalDirection(int32_t steps) {
   // Визначаємо логічний напрямок
   int8_t logicalDir = (steps > 0) ? 1 : -1;
@@ -57,52 +115,106 @@ int8_t Stepper::getPhysicalDirection(int32_t steps) {
 }
 
 void Stepper::update() {
+#if !defined(__AVR__)
+  // Резервний режим без апаратного таймера: кроки формуються опитуванням з loop()
   if (_remaining == 0) {
-    _currentStepDelay = STEP_DELAY_ACCEL_US;  // Скидаємо затримку при зупинці
+    _planner.reset();  // Скидаємо профіль при зупинці
     return;
   }
   
-  // Оновлюємо затримку для прискорення/заспілення
-  updateStepDelay();
-  
   unsigned long now = micros();
   
   // Перевіряємо, чи минуло достатньо часу для наступного кроку
-  if (now - _lastStepTime >= _currentStepDelay) {
+  if (_planner.isStopped() || now - _lastStepTime >= _stepInterval) {
     doStep();
+    takePending();
     _lastStepTime = now;
+    if (_remaining != 0) {
+      _stepInterval = _planner.nextInterval(abs(_remaining));
+    }
   }
+#endif
+  // На AVR кроки формує переривання Timer1 - тут нічого робити не потрібно
 }
 
 void Stepper::move(int32_t steps) {
   if (steps == 0) return;
-  _remaining += steps;
-  _currentStepDelay = STEP_DELAY_ACCEL_US;  // Починаємо з початкової затримки (прискорення)
-  if (_lastStepTime == 0) {
-    _lastStepTime = micros();
+  noInterrupts();
+  int32_t target = _remaining + _pending + steps;
+  int32_t brake = _planner.getRampSteps();
+  if (_remaining != 0 && brake > 1) {
+    // Двигун на ходу: до швидкості старту (перший інтервал рампи) він зупиняється за brake - 1 кроків.
+    // Якщо ціль ближча або позаду, спершу гальмуємо в поточному напрямку, а решту виконуємо після розвороту
+    brake--;
+    if (_remaining < 0) brake = -brake;
+    if (_remaining > 0 ? target < brake : target > brake) {
+      _remaining = brake;
+      _pending = target - brake;
+    } else {
+      _remaining = target;  // Поточна швидкість зберігається - планувальник сам перерахує гальмування
+      _pending = 0;
+    }
+  } else {
+    _remaining = target;
+    _pending = 0;
+  }
+  if (_remaining != 0 && !_timerRunning) {
+    startTimer();
   }
+  interrupts();
 }
 
-void Stepper::updateStepDelay() {
-  // Перевіряємо, чи потрібно заспілення
-  int32_t remainingAbs = abs(_remaining);
+void Stepper::startTimer() {
+#if defined(__AVR__)
+  // Перший крок - одразу, далі інтервал перезавантажується в перериванні
+  TCNT1 = 0;
+  OCR1A = 1;
+  TCCR1B = _BV(WGM12) | STEPPER_TIMER_CLOCK_BITS;
+#endif
+  _timerRunning = true;
+}
+
+void Stepper::stopTimer() {
+#if defined(__AVR__)
+  TCCR1B = _BV(WGM12);  // Вимикаємо тактування, режим CTC залишається
+#endif
+  _timerRunning = false;
+}
+
+void Stepper::timerIsr() {
+  if (_instance) {
+    _instance->handleTimer();
+  }
+}
+
+void Stepper::handleTimer() {
+  if (_remaining == 0) {
+    stopTimer();
+    _planner.reset();  // Скидаємо профіль при зупинці
+    return;
+  }
   
-  if (_distanceToTarget > 0 && remainingAbs <= DECEL_START_STEPS) {
-    // Заспілення: збільшуємо затримку при наближенні до цілі
-    // Лінійне збільшення затримки від мінімуму до максимуму
-    // Використовуємо цілочисельну арифметику
-    unsigned long delayRange = STEP_DELAY_MAX_US - STEP_DELAY_MIN_US;
-    unsigned long decelFactor = (remainingAbs * 1000) / DECEL_START_STEPS;  // 0-1000
-    if (decelFactor > 1000) decelFactor = 1000;
-    _currentStepDelay = STEP_DELAY_MIN_US + (delayRange * (1000 - decelFactor)) / 1000;
-  } else if (_currentStepDelay > STEP_DELAY_MIN_US) {
-    // Прискорення: зменшуємо затримку до мінімуму
-    _currentStepDelay -= 10;  // Поступове зменшення
-    if (_currentStepDelay < STEP_DELAY_MIN_US) {
-      _currentStepDelay = STEP_DELAY_MIN_US;
-    }
-  } else {
-    _currentStepDelay = STEP_DELAY_MIN_US;  // Максимальна швидкість
+  doStep();
+  takePending();
+  
+  if (_remaining == 0) {
+    stopTimer();
+    _planner.reset();
+    return;
+  }
+  
+  // Інтервал до наступного кроку береться з профілю руху
+  _stepInterval = _planner.nextInterval(abs(_remaining));
+#if defined(__AVR__)
+  OCR1A = _stepInterval - 1;
+#endif
+}
+
+void Stepper::takePending() {
+  if (_remaining == 0 && _pending != 0) {
+    _remaining = _pending;
+    _pending = 0;
+    _planner.reset();  // Новий напрямок починається з розгону
   }
 }
 
@@ -112,18 +224,17 @@ void Stepper::doStep() {
   
   // Встановлюємо напрямок (тільки якщо змінився)
   if (_currentDir != newDir) {
-    digitalWrite(_dirPin, newDir > 0 ? HIGH : LOW);
+    FastPin<DIR_PIN>::write(newDir > 0);
     _currentDir = newDir;
     // Невелика затримка для стабілізації напрямку
-    unsigned long dirSetTime = micros();
-    while (micros() - dirSetTime < 2) {} // ~2 мкс
+    // (delayMicroseconds рахує такти і коректно працює в перериванні, на відміну від micros())
+    delayMicroseconds(2);  // ~2 мкс
   }
   
-  // Формуємо імпульс STEP
-  digitalWrite(_stepPin, HIGH);
-  unsigned long pulseStart = micros();
-  while (micros() - pulseStart < STEP_PULSE_US) {} // чекаємо 4 мкс
-  digitalWrite(_stepPin, LOW);
+  // Формуємо імпульс STEP (запис прямо в регістр порту)
+  FastPin<STEP_PIN>::high();
+  delayMicroseconds(STEP_PULSE_US);  // чекаємо 4 мкс
+  FastPin<STEP_PIN>::low();
   
   // Оновлюємо позицію (логічно, без інверсії)
   if (_remaining > 0) {
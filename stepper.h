@@ -3,42 +3,51 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "motion_planner.h"
 
+// Піни STEP/DIR/ENABLE перемикаються через FastPin (fast_pin.h) з номерами з config.h;
+// аргументи конструктора використовуються для початкового налаштування пінів
 class Stepper {
 public:
   Stepper(uint8_t stepPin, uint8_t dirPin, uint8_t enablePin);
   void begin();
-  void update();  // Неблокуюче оновлення
-  void move(int32_t steps);  // Додає кроки до черги
+  void update();  // Неблокуюче оновлення (на AVR кроки формує Timer1, тут лише резервний опитувальний режим)
+  void move(int32_t steps);  // Додає кроки до черги (розворот на ходу - через гальмування до зупинки)
   void setPosition(int32_t position);  // Встановлює поточну позицію
   void setDirectionInvert(bool invert);  // Інвертує напрямок руху
+  void setMotionLimits(uint16_t maxSpeedSps, uint16_t accelSps2);  // Профіль швидкості (викликати, коли двигун стоїть)
   void setEnabled(bool enabled);  // Встановлює утримання двигуна (true = утримується, false = знято з утримання)
   bool isEnabled() const { return _enabled; }  // Повертає стан утримання
-  int32_t getPosition() const { return _position; }
-  int32_t getRemaining() const { return _remaining; }
+  int32_t getPosition() const;  // Атомарне читання (позиція змінюється в перериванні)
+  int32_t getRemaining() const;  // Атомарне читання (залишок змінюється в перериванні), разом з кроками після розвороту
   bool isDirectionInverted() const { return _directionInvert; }
-  void setDistanceToTarget(int32_t steps);  // Встановлює відстань до цілі для заспілення
+  uint16_t getStepInterval() const;  // Останній інтервал між кроками (тіки планувальника)
+  
+  static void timerIsr();  // Викликається з ISR(TIMER1_COMPA_vect)
   
 private:
   uint8_t _stepPin;
   uint8_t _dirPin;
   uint8_t _enablePin;
   bool _enabled;  // Стан утримання (true = утримується, false = знято)
-  int32_t _position;
-  int32_t _remaining;
-  unsigned long _lastStepTime;
-  unsigned long _currentStepDelay;  // Поточна затримка між кроками
+  volatile int32_t _position;
+  volatile int32_t _remaining;
+  volatile int32_t _pending;  // Кроки після розвороту: виконуються, коли двигун загальмує до зупинки
+  unsigned long _lastStepTime;  // Використовується тільки в опитувальному режимі (не AVR)
+  volatile uint16_t _stepInterval;  // Інтервал до наступного кроку (тіки; на AVR - копія OCR1A + 1)
   int8_t _currentDir;
-  bool _directionInvert;  // Інверсія напрямку
-  int32_t _distanceToTarget;  // Відстань до цілі для заспілення
-  static const unsigned long STEP_DELAY_MIN_US = 400;  // Мінімальна затримка (максимальна швидкість)
-  static const unsigned long STEP_DELAY_MAX_US = 2000;  // Максимальна затримка (мінімальна швидкість)
-  static const unsigned long STEP_DELAY_ACCEL_US = 1500;  // Початкова затримка при старті
-  static const int32_t DECEL_START_STEPS = 160;  // Почати заспілення за ~18 градусів (160 кроків при 16 микростепах)
+  volatile bool _directionInvert;  // Інверсія напрямку
+  volatile bool _timerRunning;  // Timer1 генерує кроки
+  MotionPlanner _planner;  // Профіль швидкості (розгін/гальмування)
+  
+  static Stepper* _instance;
   
   void doStep();
+  void takePending();  // Після зупинки перед розворотом переходить до кроків у новому напрямку
   int8_t getPhysicalDirection(int32_t steps);  // Отримує фізичний напрямок з урахуванням інверсії
-  void updateStepDelay();  // Оновлює затримку для прискорення/заспілення
+  void handleTimer();  // Один крок та перезавантаження інтервалу (контекст переривання)
+  void startTimer();  // Запускає Timer1 (викликається при вимкнених перериваннях)
+  void stopTimer();  // Зупиняє Timer1 (викликається при вимкнених перериваннях)
 };
 
 #endif
@@ -0,0 +1,125 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Мінімальна заміна Arduino API для збирання прошивки на ПК (тести).
+// Час віртуальний: його просуває тільки тест (hal::advanceUs) і delay()/delayMicroseconds()
+// (а також micros() та interrupts(), поки модель TWI передає, - так цикли очікування шини доходять до кінця).
+// Стан пінів, АЦП, EEPROM і дисплея - у hal.cpp, керування ними з тестів - через hal.h.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+// Збирання на ПК: модулі з регістрами без заміни на Arduino-рівні (TWI) беруть модель з hal.cpp
+#define ARDUINO_HOST
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+
+#define DEC 10
+#define HEX 16
+#define F_CPU 16000000UL
+
+// PROGMEM на ПК - звичайна пам'ять
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
+#define pgm_read_word(p) (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+#define pgm_read_ptr(p) (*(void* const*)(p))
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(PSTR(s)))
+
+#define _BV(bit) (1U << (bit))
+#ifndef abs
+  #define abs(x) ((x) > 0 ? (x) : -(x))
+#endif
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+#ifndef min
+  #define min(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef max
+  #define max(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define digitalPinToInterrupt(pin) ((pin) == 2 ? 0 : ((pin) == 3 ? 1 : -1))
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void noInterrupts();
+void interrupts();
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode);
+
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t value) = 0;
+  size_t write(const char* text) {
+    size_t n = 0;
+    while (*text) {
+      n += write((uint8_t)*text++);
+    }
+    return n;
+  }
+  size_t print(const char* text) { return write(text); }
+  size_t print(const __FlashStringHelper* text) { return write(reinterpret_cast<const char*>(text)); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC) {
+    char text[24];
+    snprintf(text, sizeof(text), base == HEX ? "%lx" : "%ld", value);
+    return write(text);
+  }
+  size_t print(unsigned long value, int base = DEC) {
+    char text[24];
+    snprintf(text, sizeof(text), base == HEX ? "%lx" : "%lu", value);
+    return write(text);
+  }
+  size_t println() { return write("\r\n"); }
+  template <class T> size_t println(T value) { return print(value) + println(); }
+  template <class T> size_t println(T value, int base) { return print(value, base) + println(); }
+};
+
+// Serial: виведене відкидається, команди не надходять
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  int available() { return 0; }
+  int read() { return -1; }
+  virtual size_t write(uint8_t value) { (void)value; return 1; }
+  using Print::write;
+  operator bool() { return true; }
+};
+extern HardwareSerial Serial;
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef HOST_EEPROM_H
+#define HOST_EEPROM_H
+
+#include <Arduino.h>
+
+// EEPROM на 1 КБ (як у ATmega328P); після hal::reset() стерта (0xFF)
+class EEPROMClass {
+public:
+  static const uint16_t SIZE = 1024;
+
+  uint8_t read(int address) { return _data[address]; }
+  void write(int address, uint8_t value) {
+    _data[address] = value;
+    _writes++;
+  }
+  void update(int address, uint8_t value) {
+    if (_data[address] != value) {
+      write(address, value);
+    }
+  }
+  uint16_t length() { return SIZE; }
+  template <class T> T& get(int address, T& value) {
+    memcpy(&value, _data + address, sizeof(T));
+    return value;
+  }
+  template <class T> const T& put(int address, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    for (size_t i = 0; i < sizeof(T); i++) {
+      update(address + i, bytes[i]);
+    }
+    return value;
+  }
+
+  void erase() {
+    memset(_data, 0xFF, sizeof(_data));
+    _writes = 0;
+  }
+  uint32_t writeCount() const { return _writes; }  // Записаних байтів від erase()
+
+private:
+  uint8_t _data[SIZE];
+  uint32_t _writes;
+};
+extern EEPROMClass EEPROM;
+
+#endif
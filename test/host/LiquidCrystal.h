@@ -0,0 +1,14 @@
+#ifndef HOST_LIQUID_CRYSTAL_H
+#define HOST_LIQUID_CRYSTAL_H
+
+#include <Arduino.h>
+#include "LiquidCrystal_I2C.h"
+
+// 4-бітний режим (LCD_MODE 0) - та сама модель дисплея
+class LiquidCrystal : public LiquidCrystal_I2C {
+public:
+  LiquidCrystal(uint8_t rs, uint8_t enable, uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7)
+    : LiquidCrystal_I2C(0, 20, 4) {}
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef HOST_LIQUID_CRYSTAL_I2C_H
+#define HOST_LIQUID_CRYSTAL_I2C_H
+
+#include <Arduino.h>
+
+// Модель HD44780: DDRAM з адресацією рядків як у LCD2004 (текст за кінцем рядка
+// потрапляє туди ж, куди на справжньому дисплеї). Вміст читається через hal::lcdRow()
+class LiquidCrystal_I2C : public Print {
+public:
+  LiquidCrystal_I2C(uint8_t address, uint8_t cols, uint8_t rows);
+  void begin(uint8_t cols, uint8_t rows);
+  void init() {}
+  void clear();
+  void home() { setCursor(0, 0); }
+  void setCursor(uint8_t col, uint8_t row);
+  void createChar(uint8_t location, uint8_t charmap[]) { (void)location; (void)charmap; }
+  void backlight() {}
+  void noBacklight() {}
+  virtual size_t write(uint8_t value);
+  using Print::write;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+// Шина I2C з одним модулем PCF8574: читання повертає останній записаний байт порту
+class TwoWire {
+public:
+  void begin() {}
+  void setClock(uint32_t hz) { _clockHz = hz; }
+  void beginTransmission(uint8_t address) { (void)address; }
+  uint8_t endTransmission(bool stop = true) { (void)stop; return 0; }
+  size_t write(uint8_t value) {
+    _port = value;
+    return 1;
+  }
+  uint8_t requestFrom(uint8_t address, uint8_t count) {
+    (void)address;
+    return count;
+  }
+  int available() { return 1; }
+  int read() { return _port; }
+  uint32_t getClock() const { return _clockHz; }
+
+private:
+  uint8_t _port;
+  uint32_t _clockHz;
+};
+extern TwoWire Wire;
+
+#endif
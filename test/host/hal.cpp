@@ -0,0 +1,490 @@
+#include "hal.h"
+#include <EEPROM.h>
+#include <Wire.h>
+#include <LiquidCrystal_I2C.h>
+#include <twi.h>
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+TwoWire Wire;
+
+namespace {
+
+const uint8_t PIN_COUNT = 80;
+const uint8_t LCD_COLS = 20;
+const uint8_t LCD_ROWS = 4;
+const uint8_t LCD_ROW_OFFSETS[LCD_ROWS] = { 0x00, 0x40, 0x14, 0x54 };
+
+unsigned long nowUs;
+bool inputs[PIN_COUNT];
+bool outputs[PIN_COUNT];
+uint16_t analogValues[PIN_COUNT];
+hal::AnalogSource analogSource;
+void (*interruptHandlers[2])();
+
+uint8_t stepPin = 0xFF;
+uint8_t dirPin = 0xFF;
+int32_t steps;
+uint32_t pulses;
+
+char ddram[0x80];
+uint8_t ddramAddress;
+uint32_t lcdWriteCount;
+uint32_t lcdCursorCount;
+char rowText[LCD_COLS + 1];
+
+// HD44780 за PCF8574 (LcdI2cAsync): півбайт забирається по спаду E
+const uint8_t PCF_RS = 0x01;
+const uint8_t PCF_EN = 0x04;
+uint8_t pcfPort;
+bool lcd4Bit;  // Після ввімкнення - 8-бітний режим, поки не прийде Function Set з DL = 0
+bool lcdHighNibble;  // Старший півбайт уже прийнято
+uint8_t lcdNibble;
+bool lcdCgram;  // Дані йдуть у CGRAM (після Set CGRAM Address)
+
+// TWI: поточний крок обміну завершується в twiDoneUs
+enum TwiStep { TWI_STEP_NONE, TWI_STEP_START, TWI_STEP_BYTE, TWI_STEP_STOP };
+enum TwiPhase { TWI_IDLE, TWI_ADDRESS, TWI_TRANSMIT, TWI_RECEIVE };
+const uint16_t TWI_STREAM_SIZE = 4096;
+
+uint8_t twiControlReg;
+uint8_t twiDataReg;
+uint8_t twiStatusReg;
+uint8_t twiBitRateReg;
+uint8_t twiStep;
+uint8_t twiPhase;
+unsigned long twiDoneUs;
+void (*twiHandler)();  // Як вектор переривання: reset() його не скидає (глобальні об'єкти скетча створюються до тестів)
+bool twiResponding;
+bool twiStuck;
+uint32_t twiMaxHz;
+uint8_t twiStream[TWI_STREAM_SIZE];
+uint16_t twiStreamCount;
+uint16_t twiStartCount;
+
+void fireInterrupt(uint8_t pin) {
+  int8_t interrupt = digitalPinToInterrupt(pin);
+  if (interrupt >= 0 && interruptHandlers[interrupt]) {
+    interruptHandlers[interrupt]();
+  }
+}
+
+void ddramClear() {
+  memset(ddram, ' ', sizeof(ddram));
+  ddramAddress = 0;
+}
+
+void ddramSetCursor(uint8_t address) {
+  ddramAddress = address & 0x7F;
+  lcdCursorCount++;
+}
+
+void ddramWrite(uint8_t value) {
+  ddram[ddramAddress] = (char)value;
+  lcdWriteCount++;
+  // Двурядкова адресація HD44780: 0x00-0x27 і 0x40-0x67, після кінця - на початок іншої половини
+  ddramAddress++;
+  if (ddramAddress == 0x28) {
+    ddramAddress = 0x40;
+  } else if (ddramAddress == 0x68) {
+    ddramAddress = 0x00;
+  }
+}
+
+void lcdCommand(uint8_t value) {
+  if (value & 0x80) {
+    ddramSetCursor(value);
+    lcdCgram = false;
+  } else if (value & 0x40) {
+    lcdCgram = true;
+  } else if (value & 0x20) {
+    lcd4Bit = !(value & 0x10);
+    lcdHighNibble = false;
+  } else if (value & 0x1C) {
+    // Зсув, режим дисплея і введення на вміст DDRAM не впливають
+  } else if (value & 0x02) {
+    ddramAddress = 0;  // Курсор на початок
+    lcdCgram = false;
+  } else if (value & 0x01) {
+    ddramClear();
+    lcdCgram = false;
+  }
+}
+
+void pcfWrite(uint8_t value) {
+  bool strobe = (pcfPort & PCF_EN) && !(value & PCF_EN);
+  uint8_t latched = pcfPort;
+  pcfPort = value;
+  if (!strobe) {
+    return;
+  }
+  uint8_t nibble = latched >> 4;
+  bool data = latched & PCF_RS;
+  if (!lcd4Bit) {
+    // D0-D3 не підключені: кожен півбайт - окрема команда
+    if (!data) {
+      lcdCommand(nibble << 4);
+    }
+    return;
+  }
+  if (!lcdHighNibble) {
+    lcdNibble = nibble;
+    lcdHighNibble = true;
+    return;
+  }
+  lcdHighNibble = false;
+  uint8_t byte = (lcdNibble << 4) | nibble;
+  if (!data) {
+    lcdCommand(byte);
+  } else if (!lcdCgram) {
+    ddramWrite(byte);
+  }
+}
+
+uint32_t twiHz() {
+  return F_CPU / (16 + 2 * (uint32_t)twiBitRateReg);
+}
+
+// Час передачі з округленням угору (на 400 кГц біт - 2.5 мкс)
+unsigned long twiBitsUs(uint8_t bits) {
+  uint32_t hz = twiHz();
+  return ((uint32_t)bits * 1000000UL + hz - 1) / hz;
+}
+
+void twiComplete() {
+  uint8_t step = twiStep;
+  twiStep = TWI_STEP_NONE;
+  switch (step) {
+    case TWI_STEP_START:
+      twiStatusReg = (twiPhase == TWI_IDLE) ? TW_START : TW_REP_START;
+      twiPhase = TWI_ADDRESS;
+      twiStartCount++;
+      break;
+
+    case TWI_STEP_BYTE:
+      if (twiPhase == TWI_ADDRESS) {
+        bool read = (twiDataReg & TW_READ) != 0;
+        if (twiResponding && twiHz() <= twiMaxHz) {
+          twiStatusReg = read ? TW_MR_SLA_ACK : TW_MT_SLA_ACK;
+          twiPhase = read ? TWI_RECEIVE : TWI_TRANSMIT;
+        } else {
+          twiStatusReg = read ? TW_MR_SLA_NACK : TW_MT_SLA_NACK;
+        }
+      } else if (twiPhase == TWI_TRANSMIT) {
+        pcfWrite(twiDataReg);
+        if (twiStreamCount < TWI_STREAM_SIZE) {
+          twiStream[twiStreamCount++] = twiDataReg;
+        }
+        twiStatusReg = TW_MT_DATA_ACK;
+      } else {
+        twiDataReg = pcfPort;
+        twiStatusReg = (twiControlReg & _BV(TWEA)) ? TW_MR_DATA_ACK : TW_MR_DATA_NACK;
+      }
+      break;
+
+    default:  // TWI_STEP_STOP - без TWINT
+      twiControlReg &= ~_BV(TWSTO);
+      twiPhase = TWI_IDLE;
+      return;
+  }
+  twiControlReg |= _BV(TWINT);
+  if ((twiControlReg & _BV(TWIE)) && twiHandler) {
+    twiHandler();
+  }
+}
+
+// Просуває віртуальний час, завершуючи кроки TWI, що встигають до нього
+void runUntil(unsigned long targetUs) {
+  while (twiStep != TWI_STEP_NONE && !twiStuck && (long)(twiDoneUs - targetUs) <= 0) {
+    if ((long)(twiDoneUs - nowUs) > 0) {
+      nowUs = twiDoneUs;
+    }
+    twiComplete();
+  }
+  nowUs = targetUs;
+}
+
+// Поки триває крок обміну TWI, кожне опитування часу чи стану драйвера (interrupts() після
+// атомарного читання) - мікросекунда очікування: цикл, що чекає на шину, доходить до завершення
+// передачі або до свого тайм-ауту
+void waitForBus() {
+  if (twiStep != TWI_STEP_NONE) {
+    runUntil(nowUs + 1);
+  }
+}
+
+}
+
+namespace hal {
+
+void reset() {
+  nowUs = 0;
+  for (uint8_t pin = 0; pin < PIN_COUNT; pin++) {
+    inputs[pin] = true;
+    outputs[pin] = false;
+    analogValues[pin] = 0;
+  }
+  analogSource = nullptr;
+  interruptHandlers[0] = nullptr;
+  interruptHandlers[1] = nullptr;
+  stepPin = 0xFF;
+  dirPin = 0xFF;
+  steps = 0;
+  pulses = 0;
+  ddramClear();
+  lcdWriteCount = 0;
+  lcdCursorCount = 0;
+  twiControlReg = 0;
+  twiDataReg = 0xFF;
+  twiStatusReg = TW_NO_INFO;
+  twiBitRateReg = 0;
+  twiStep = TWI_STEP_NONE;
+  twiPhase = TWI_IDLE;
+  twiResponding = true;
+  twiStuck = false;
+  twiMaxHz = 400000;
+  pcfPort = 0xFF;
+  lcd4Bit = false;
+  lcdHighNibble = false;
+  lcdCgram = false;
+  twiStreamCount = 0;
+  twiStartCount = 0;
+  EEPROM.erase();
+}
+
+void advanceUs(unsigned long us) {
+  runUntil(nowUs + us);
+}
+
+void setInput(uint8_t pin, bool level) {
+  if (inputs[pin] == level) {
+    return;
+  }
+  inputs[pin] = level;
+  fireInterrupt(pin);
+}
+
+void setInputs(uint8_t pin1, bool level1, uint8_t pin2, bool level2) {
+  bool changed1 = inputs[pin1] != level1;
+  bool changed2 = inputs[pin2] != level2;
+  inputs[pin1] = level1;
+  inputs[pin2] = level2;
+  if (changed1) {
+    fireInterrupt(pin1);
+  }
+  if (changed2) {
+    fireInterrupt(pin2);
+  }
+}
+
+bool getOutput(uint8_t pin) {
+  return outputs[pin];
+}
+
+void setAnalogSource(AnalogSource source) {
+  analogSource = source;
+}
+
+void setAnalog(uint8_t pin, uint16_t value) {
+  analogValues[pin] = value;
+}
+
+void traceStepper(uint8_t step, uint8_t dir) {
+  stepPin = step;
+  dirPin = dir;
+  steps = 0;
+  pulses = 0;
+}
+
+int32_t stepperSteps() {
+  return steps;
+}
+
+uint32_t stepperPulses() {
+  return pulses;
+}
+
+const char* lcdRow(uint8_t row) {
+  for (uint8_t col = 0; col < LCD_COLS; col++) {
+    char c = ddram[LCD_ROW_OFFSETS[row] + col];
+    rowText[col] = ((uint8_t)c < 8) ? '^' : c;
+  }
+  rowText[LCD_COLS] = '\0';
+  return rowText;
+}
+
+uint32_t lcdWrites() {
+  return lcdWriteCount;
+}
+
+uint32_t lcdCursorMoves() {
+  return lcdCursorCount;
+}
+
+uint16_t twiBytes() {
+  return twiStreamCount;
+}
+
+uint8_t twiByte(uint16_t index) {
+  return twiStream[index];
+}
+
+uint16_t twiTransactions() {
+  return twiStartCount;
+}
+
+uint32_t twiClockHz() {
+  return twiHz();
+}
+
+void twiSetResponding(bool responding) {
+  twiResponding = responding;
+}
+
+void twiSetStuck(bool stuck) {
+  twiStuck = stuck;
+}
+
+void twiSetMaxClock(uint32_t hz) {
+  twiMaxHz = hz;
+}
+
+}
+
+/* ================== ARDUINO API ================== */
+void pinMode(uint8_t pin, uint8_t mode) {
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  bool level = value != LOW;
+  if (pin == stepPin && level && !outputs[pin]) {
+    pulses++;
+    steps += outputs[dirPin] ? 1 : -1;
+  }
+  outputs[pin] = level;
+}
+
+int digitalRead(uint8_t pin) {
+  return inputs[pin] ? HIGH : LOW;
+}
+
+int analogRead(uint8_t pin) {
+  return analogSource ? analogSource(pin) : analogValues[pin];
+}
+
+unsigned long millis() {
+  return nowUs / 1000;
+}
+
+unsigned long micros() {
+  waitForBus();
+  return nowUs;
+}
+
+void delay(unsigned long ms) {
+  runUntil(nowUs + ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us) {
+  runUntil(nowUs + us);
+}
+
+void noInterrupts() {
+}
+
+void interrupts() {
+  waitForBus();
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(), int mode) {
+  (void)mode;
+  if (interrupt < 2) {
+    interruptHandlers[interrupt] = handler;
+  }
+}
+
+/* ================== ДИСПЛЕЙ ================== */
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t address, uint8_t cols, uint8_t rows) {
+  (void)address;
+  (void)cols;
+  (void)rows;
+}
+
+void LiquidCrystal_I2C::begin(uint8_t cols, uint8_t rows) {
+  (void)cols;
+  (void)rows;
+  clear();
+}
+
+void LiquidCrystal_I2C::clear() {
+  ddramClear();
+}
+
+void LiquidCrystal_I2C::setCursor(uint8_t col, uint8_t row) {
+  if (row >= LCD_ROWS) {
+    row = LCD_ROWS - 1;
+  }
+  ddramSetCursor(LCD_ROW_OFFSETS[row] + col);
+}
+
+size_t LiquidCrystal_I2C::write(uint8_t value) {
+  ddramWrite(value);
+  return 1;
+}
+
+/* ================== TWI ================== */
+uint8_t twiStatus() {
+  return twiStatusReg;
+}
+
+uint8_t twiControl() {
+  return twiControlReg;
+}
+
+void twiSetControl(uint8_t value) {
+  if (!(value & _BV(TWEN))) {
+    // Вимкнення TWI обриває обмін, лінії відпускаються
+    twiControlReg = value;
+    twiStep = TWI_STEP_NONE;
+    twiPhase = TWI_IDLE;
+    return;
+  }
+  if (!(value & _BV(TWINT))) {
+    twiControlReg = value | (twiControlReg & _BV(TWINT));
+    return;
+  }
+  // Запис одиниці в TWINT скидає прапорець і запускає наступний крок
+  twiControlReg = value & ~_BV(TWINT);
+  if (value & _BV(TWSTA)) {
+    twiStep = TWI_STEP_START;
+    twiDoneUs = nowUs + twiBitsUs(1);
+  } else if (value & _BV(TWSTO)) {
+    twiStep = TWI_STEP_STOP;
+    twiDoneUs = nowUs + twiBitsUs(1);
+  } else {
+    twiStep = TWI_STEP_BYTE;
+    twiDoneUs = nowUs + twiBitsUs(9);  // 8 біт і ACK
+  }
+}
+
+uint8_t twiData() {
+  return twiDataReg;
+}
+
+void twiSetData(uint8_t value) {
+  twiDataReg = value;
+}
+
+void twiSetBitRate(uint8_t value) {
+  twiBitRateReg = value;
+}
+
+void twiSetPrescaler(uint8_t value) {
+  (void)value;  // Модель рахує частоту тільки для дільника 1
+}
+
+void twiAttachInterrupt(void (*handler)()) {
+  twiHandler = handler;
+}
@@ -0,0 +1,46 @@
+#ifndef HOST_HAL_H
+#define HOST_HAL_H
+
+#include <Arduino.h>
+
+// Керування віртуальним залізом з тестів
+namespace hal {
+
+void reset();  // Час 0, усі входи HIGH (кнопки відпущено), EEPROM стерта, дисплей порожній
+
+// Віртуальний час
+void advanceUs(unsigned long us);
+
+// Входи: зміна рівня на піні з attachInterrupt() викликає обробник (як CHANGE)
+void setInput(uint8_t pin, bool level);
+void setInputs(uint8_t pin1, bool level1, uint8_t pin2, bool level2);  // Обидва рівні змінюються до запуску обробників (пропущений фронт)
+bool getOutput(uint8_t pin);  // Останній рівень, записаний digitalWrite()
+
+// АЦП: значення для analogRead() дає функція тесту (наприклад, кут моделі столу)
+typedef uint16_t (*AnalogSource)(uint8_t pin);
+void setAnalogSource(AnalogSource source);
+void setAnalog(uint8_t pin, uint16_t value);  // Стале значення, якщо функцію не задано
+
+// Кроковий двигун: фронти STEP рахуються в напрямку, заданому рівнем DIR
+void traceStepper(uint8_t stepPin, uint8_t dirPin);
+int32_t stepperSteps();  // Сума кроків (DIR = HIGH - вперед)
+uint32_t stepperPulses();  // Усі імпульси STEP
+
+// Дисплей: вміст рядка (кастомні символи CGRAM показуються як '^'). З LcdI2cAsync HD44780 отримує
+// команди і дані через модель TWI - що відправлено в чергу, з'являється тут, коли минув час передачі
+const char* lcdRow(uint8_t row);
+uint32_t lcdWrites();  // Записані символи
+uint32_t lcdCursorMoves();  // Команди setCursor()
+
+// Шина TWI (LcdI2cAsync): байти, записані в порт PCF8574, по порядку
+uint16_t twiBytes();
+uint8_t twiByte(uint16_t index);
+uint16_t twiTransactions();  // Умови START, включно з повторними
+uint32_t twiClockHz();  // Частота за TWBR
+void twiSetResponding(bool responding);  // false - модуль не відповідає ACK на свою адресу
+void twiSetStuck(bool stuck);  // Шина зависла: жоден крок обміну не завершується
+void twiSetMaxClock(uint32_t hz);  // Вище цієї частоти модуль не відповідає на адресу (після reset() - 400 кГц)
+
+}
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef HOST_TWI_H
+#define HOST_TWI_H
+
+#include <Arduino.h>
+
+// Модель апаратного TWI замість регістрів AVR (TWCR, TWDR, TWSR, TWBR) з одним модулем PCF8574.
+// Запис у керуючий регістр з TWINT запускає крок обміну; він завершується через час передачі
+// на заданій частоті (9 біт на байт), після чого встановлюється TWINT і, якщо дозволено TWIE,
+// викликається обробник переривання. Керування моделлю і записаний потік байтів - через hal.h
+
+// Біти TWCR
+#define TWIE 0
+#define TWEN 2
+#define TWWC 3
+#define TWSTO 4
+#define TWSTA 5
+#define TWEA 6
+#define TWINT 7
+
+// Коди стану (як у <util/twi.h>)
+#define TW_START 0x08
+#define TW_REP_START 0x10
+#define TW_MT_SLA_ACK 0x18
+#define TW_MT_SLA_NACK 0x20
+#define TW_MT_DATA_ACK 0x28
+#define TW_MT_DATA_NACK 0x30
+#define TW_MT_ARB_LOST 0x38
+#define TW_MR_SLA_ACK 0x40
+#define TW_MR_SLA_NACK 0x48
+#define TW_MR_DATA_ACK 0x50
+#define TW_MR_DATA_NACK 0x58
+#define TW_NO_INFO 0xF8
+#define TW_WRITE 0
+#define TW_READ 1
+
+uint8_t twiStatus();
+uint8_t twiControl();
+void twiSetControl(uint8_t value);
+uint8_t twiData();
+void twiSetData(uint8_t value);
+void twiSetBitRate(uint8_t value);
+void twiSetPrescaler(uint8_t value);
+void twiAttachInterrupt(void (*handler)());  // Замість ISR(TWI_vect)
+
+#endif
@@ -0,0 +1,3 @@
+// Скетч як звичайна одиниця трансляції (Arduino IDE додає Arduino.h сама)
+#include <Arduino.h>
+#include "../Turntable_P3032.ino"
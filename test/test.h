@@ -0,0 +1,52 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <stdio.h>
+#include <string.h>
+
+// Мінімальний набір для тестів на ПК: TEST(name) реєструє тест, CHECK* - перевірки.
+// Невдала перевірка друкує файл, рядок і значення, тест продовжується;
+// код виходу test_main - кількість тестів з помилками
+struct TestCase {
+  const char* name;
+  void (*function)();
+  TestCase* next;
+  TestCase(const char* testName, void (*testFunction)());
+};
+
+extern int testFailures;  // Невдалі перевірки поточного тесту
+
+#define TEST(name) \
+  static void name(); \
+  static TestCase name##_case(#name, name); \
+  static void name()
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      printf("  %s:%d: CHECK(%s)\n", __FILE__, __LINE__, #condition); \
+      testFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+  do { \
+    long long e_ = (long long)(expected); \
+    long long a_ = (long long)(actual); \
+    if (e_ != a_) { \
+      printf("  %s:%d: %s == %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+      testFailures++; \
+    } \
+  } while (0)
+
+#define CHECK_STRING(expected, actual) \
+  do { \
+    const char* e_ = (expected); \
+    const char* a_ = (actual); \
+    if (strcmp(e_, a_) != 0) { \
+      printf("  %s:%d: %s == \"%s\", expected \"%s\"\n", __FILE__, __LINE__, #actual, a_, e_); \
+      testFailures++; \
+    } \
+  } while (0)
+
+#endif
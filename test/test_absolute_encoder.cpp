@@ -0,0 +1,202 @@
+#include "test.h"
+#include "host/hal.h"
+#include <math.h>
+#include "absolute_encoder.h"
+
+// Повна шкала зразка після децимації - ADC_MAX << ABS_ENC_OVERSAMPLE_BITS
+static const uint16_t SAMPLE_MAX = 1023 << ABS_ENC_OVERSAMPLE_BITS;
+static const uint8_t OVERSAMPLE_COUNT = 1 << (2 * ABS_ENC_OVERSAMPLE_BITS);
+
+static uint16_t cdegOf(uint16_t sample) {
+  return (uint16_t)(((uint32_t)sample * (((36000UL << 12) + SAMPLE_MAX / 2) / SAMPLE_MAX) + 2048) >> 12);
+}
+
+// АЦП на межі двох кодів: перетворення по черзі дають 512 і 513
+static uint16_t alternatingSource(uint8_t) {
+  static uint8_t call = 0;
+  return (call++ & 1) ? 513 : 512;
+}
+
+TEST(angle_follows_adc_code) {
+  AbsoluteEncoder encoder(A0);
+  hal::setAnalog(A0, 0);
+  encoder.begin();
+  CHECK_EQUAL(0, encoder.readAngleCdeg());
+
+  hal::setAnalog(A0, 256);
+  for (uint8_t i = 0; i < 5; i++) {
+    encoder.readAngleCdeg();
+  }
+  CHECK_EQUAL(cdegOf(256 << ABS_ENC_OVERSAMPLE_BITS), encoder.readAngleCdeg());
+  CHECK_EQUAL(90, encoder.readAngleInt());
+}
+
+TEST(full_scale_displays_as_zero) {
+  // Повна шкала - той самий кут, що й 0°
+  AbsoluteEncoder encoder(A0);
+  hal::setAnalog(A0, 1023);
+  encoder.begin();
+  CHECK_EQUAL(0, encoder.readAngleCdeg());
+  CHECK_EQUAL(0, encoder.readDisplayAngleCdeg());
+  CHECK_EQUAL(0, encoder.readAngleInt());
+}
+
+TEST(isr_decimation_adds_resolution) {
+  // 4^N перетворень через ISR дають один зразок з N додатковими бітами:
+  // середнє 512 і 513 потрапляє між кутами сусідніх 10-бітних кодів
+  AbsoluteEncoder encoder(A0);
+  hal::setAnalogSource(alternatingSource);
+  encoder.begin();
+  for (uint16_t i = 0; i < OVERSAMPLE_COUNT * 3; i++) {
+    AbsoluteEncoder::adcIsr();
+  }
+  uint16_t angle = encoder.readRawAngleCdeg();
+  CHECK_EQUAL(cdegOf((512 << ABS_ENC_OVERSAMPLE_BITS) + (1 << ABS_ENC_OVERSAMPLE_BITS) / 2), angle);
+  CHECK(angle > cdegOf(512 << ABS_ENC_OVERSAMPLE_BITS));
+  CHECK(angle < cdegOf(513 << ABS_ENC_OVERSAMPLE_BITS));
+}
+
+// Фільтр-медіана з 5: результат 512, тільки коли 512 у трьох зразках
+// (опитування в readRawAngleCdeg() на ПК додає один зразок)
+static uint16_t angleAfterConversions(uint16_t conversions) {
+  AbsoluteEncoder encoder(A0);
+  hal::setAnalog(A0, 0);
+  encoder.begin();
+  hal::setAnalog(A0, 512);
+  for (uint16_t i = 0; i < conversions; i++) {
+    AbsoluteEncoder::adcIsr();
+  }
+  return encoder.readRawAngleCdeg();
+}
+
+TEST(sample_only_after_full_oversample_block) {
+  CHECK_EQUAL(0, angleAfterConversions(OVERSAMPLE_COUNT * 2 - 1));
+  CHECK_EQUAL(cdegOf(512 << ABS_ENC_OVERSAMPLE_BITS), angleAfterConversions(OVERSAMPLE_COUNT * 2));
+}
+
+// Обнулення з loop(): кожен виклик updateZero() - один прохід; на ПК кожен прохід збору додає зразок
+static uint16_t runZero(AbsoluteEncoder& encoder, unsigned long stepMs) {
+  uint16_t calls = 0;
+  encoder.startZero();
+  while (encoder.updateZero(millis()) && calls < 1000) {
+    calls++;
+    hal::advanceUs(stepMs * 1000UL);
+  }
+  return calls;
+}
+
+TEST(zero_is_non_blocking_and_sets_current_angle) {
+  AbsoluteEncoder encoder(A0);
+  hal::setAnalog(A0, 512);
+  encoder.begin();
+  CHECK(encoder.readAngleCdeg() > 17900);
+
+  encoder.startZero();
+  CHECK(encoder.isZeroing());
+  unsigned long start = millis();
+  CHECK(encoder.updateZero(millis()));  // Пауза: повертається одразу
+  CHECK_EQUAL(start, millis());
+  CHECK_EQUAL(0, encoder.getZeroProgress());
+
+  // До кінця обнулення кут рахується від старого нуля
+  hal::advanceUs(60000);
+  CHECK(encoder.updateZero(millis()));
+  for (uint8_t i = 0; i < 64; i++) {
+    CHECK(encoder.updateZero(millis()));
+  }
+  CHECK_EQUAL(50, encoder.getZeroProgress());
+  CHECK(encoder.readAngleCdeg() > 17900);
+
+  while (encoder.updateZero(millis())) {
+  }
+  CHECK(!encoder.isZeroing());
+  CHECK_EQUAL(0, encoder.readAngleCdeg());
+
+  hal::setAnalog(A0, 768);  // +90°
+  for (uint8_t i = 0; i < 5; i++) {
+    encoder.readAngleCdeg();
+  }
+  CHECK_EQUAL(cdegOf(768 << ABS_ENC_OVERSAMPLE_BITS) - cdegOf(512 << ABS_ENC_OVERSAMPLE_BITS), encoder.readAngleCdeg());
+}
+
+TEST(zero_settle_and_sample_count) {
+  AbsoluteEncoder encoder(A0);
+  hal::setAnalog(A0, 300);
+  encoder.begin();
+  // Пауза 50 мс кроками по 1 мс, потім один прохід запуску збору і 128 зразків
+  uint16_t calls = runZero(encoder, 1);
+  CHECK(calls >= 50 + 128);
+  CHECK(calls <= 52 + 128);
+  CHECK_EQUAL(0, encoder.readAngleCdeg());
+}
+
+// Шум навколо 0°: АЦП по черзі дає 1023 (-0.35°), 0 і 1
+static uint16_t noiseAroundZero(uint8_t) {
+  static uint8_t call = 0;
+  static const uint16_t codes[] = { 1023, 0, 1 };
+  return codes[call++ % 3];
+}
+
+TEST(zero_averages_across_wrap) {
+  // Середнє зразків по обидва боки 0° - біля 0°, а не 180°
+  AbsoluteEncoder encoder(A0);
+  hal::setAnalogSource(noiseAroundZero);
+  encoder.begin();
+  runZero(encoder, 1);
+  hal::setAnalogSource(nullptr);
+  hal::setAnalog(A0, 0);
+  for (uint8_t i = 0; i < 5; i++) {
+    encoder.readAngleCdeg();
+  }
+  uint16_t angle = encoder.readAngleCdeg();
+  CHECK(angle < 100 || angle > 35900);
+}
+
+// Еталон з плаваючою комою: кут коду АЦП (повна шкала 1023 - це 360°, тобто знову 0°)
+// і кусково-лінійна поправка за тією самою таблицею, що й у прошивці
+static double referenceCdeg(uint16_t code, const int16_t* table) {
+  double raw = code * 36000.0 / 1023.0;
+  if (table) {
+    double segment = 36000.0 / ABS_ENC_CAL_POINTS;
+    uint8_t index = (uint8_t)(raw / segment);
+    if (index >= ABS_ENC_CAL_POINTS) index = ABS_ENC_CAL_POINTS - 1;
+    double fraction = (raw - index * segment) / segment;
+    raw += table[index] + (table[(index + 1) % ABS_ENC_CAL_POINTS] - table[index]) * fraction;
+  }
+  return fmod(raw + 36000.0, 36000.0);
+}
+
+// Найбільша різниця по колу між readAngleCdeg() і еталоном на всіх 1024 кодах
+static double maxErrorAllCodes(const int16_t* table) {
+  AbsoluteEncoder encoder(A0);
+  hal::setAnalog(A0, 0);
+  encoder.begin();
+  if (table) {
+    encoder.setCalibration(table);
+  }
+  double worst = 0;
+  for (uint16_t code = 0; code <= 1023; code++) {
+    hal::setAnalog(A0, code);
+    for (uint8_t i = 0; i < 4; i++) {
+      encoder.readAngleCdeg();  // Медіана з 5 заповнюється новим кодом
+    }
+    double error = fabs(encoder.readAngleCdeg() - referenceCdeg(code, table));
+    if (error > 18000) error = 36000 - error;
+    if (error > worst) worst = error;
+  }
+  return worst;
+}
+
+TEST(all_codes_match_float_reference) {
+  // Множник << 12 з округленням: не більше пів сотої градуса плюс похибка множника
+  CHECK(maxErrorAllCodes(nullptr) < 0.75);
+}
+
+TEST(all_codes_match_float_reference_with_calibration) {
+  // Поправки до ±3° з перепадами різного знаку між вузлами;
+  // інтерполяція в цілих додає ще не більше однієї сотої
+  static const int16_t table[ABS_ENC_CAL_POINTS] = {
+    0, 120, 250, 300, 180, -40, -220, -300, -260, -90, 60, 210, 280, 150, -30, -120
+  };
+  CHECK(maxErrorAllCodes(table) < 2.0);
+}
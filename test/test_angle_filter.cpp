@@ -0,0 +1,169 @@
+#include "test.h"
+#include "angle_filter.h"
+
+// Фільтр вибирається при компіляції, тому Makefile збирає цей файл тричі
+// (-DABS_ENC_FILTER=ABS_ENC_FILTER_MEAN / _MEDIAN / _EMA): спільні тести - для кожного варіанта,
+// решта - тільки для свого
+
+static const uint16_t RANGE = 36000;
+
+// Обертання в тесті стеження і найбільше відставання: EMA відстає на крок / alpha,
+// тому крок пропорційний alpha; фільтри з вікном відстають на половину вікна
+#if ABS_ENC_FILTER == ABS_ENC_FILTER_EMA
+static const uint16_t ROTATION_STEP = 4 * ABS_ENC_FILTER_ALPHA;
+static const int32_t TRACKING_LAG = 4L * 256 + ROTATION_STEP;
+#else
+static const uint16_t ROTATION_STEP = 250;
+static const int32_t TRACKING_LAG = 250 * 16;
+#endif
+// Зразків до повного збігу з ціллю на відстані до півкола (EMA з alpha = 1 - найповільніший)
+static const uint16_t SETTLE_SAMPLES = 6000;
+
+static uint16_t pushRepeated(AngleFilter& filter, uint16_t value, uint16_t count) {
+  uint16_t output = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    output = filter.push(value);
+  }
+  return output;
+}
+
+// Відстань по колу
+static int32_t circularDistance(uint16_t a, uint16_t b) {
+  int32_t diff = (int32_t)a - b;
+  if (diff > RANGE / 2) diff -= RANGE;
+  if (diff < -(int32_t)(RANGE / 2)) diff += RANGE;
+  return diff < 0 ? -diff : diff;
+}
+
+TEST(steady_input_passes_through) {
+  AngleFilter filter(RANGE);
+  filter.reset(12345);
+  CHECK_EQUAL(12345, filter.push(12345));
+  CHECK_EQUAL(12345, pushRepeated(filter, 12345, 20));
+}
+
+TEST(converges_to_step_change) {
+  AngleFilter filter(RANGE);
+  filter.reset(1000);
+  CHECK_EQUAL(20000, pushRepeated(filter, 20000, SETTLE_SAMPLES));
+}
+
+TEST(noise_around_zero_stays_near_zero) {
+  // Зразки по обидва боки 0°: без розгортання середнє дало б ~180°
+  AngleFilter filter(RANGE);
+  filter.reset(0);
+  for (uint8_t i = 0; i < 50; i++) {
+    uint16_t output = filter.push((i & 1) ? 35950 : 50);
+    CHECK(circularDistance(output, 0) <= 50);
+    CHECK(output < RANGE);
+  }
+}
+
+TEST(crossing_zero_takes_short_way) {
+  AngleFilter filter(RANGE);
+  filter.reset(35900);
+  for (uint16_t i = 0; i < SETTLE_SAMPLES; i++) {
+    uint16_t output = filter.push(100);
+    CHECK(circularDistance(output, 0) <= 100);  // Не проходить через 180°
+  }
+  CHECK_EQUAL(100, filter.push(100));
+}
+
+TEST(continuous_rotation_tracks_angle) {
+  // Кілька повних обертів: вихід завжди в межах кола і відстає не більше ніж на TRACKING_LAG
+  AngleFilter filter(RANGE);
+  filter.reset(0);
+  uint16_t angle = 0;
+  for (uint16_t i = 0; i < 3 * RANGE / ROTATION_STEP; i++) {
+    angle = (angle + ROTATION_STEP) % RANGE;
+    uint16_t output = filter.push(angle);
+    CHECK(output < RANGE);
+    CHECK(circularDistance(output, angle) <= TRACKING_LAG);
+  }
+}
+
+TEST(converges_to_same_angle_from_both_sides) {
+  // Підхід до 0° знизу (з 359°) і згори дає той самий кут - округлення не зсуває його через 0°
+  AngleFilter filter(RANGE);
+  filter.reset(35900);
+  CHECK_EQUAL(0, pushRepeated(filter, 0, SETTLE_SAMPLES));
+  filter.reset(100);
+  CHECK_EQUAL(0, pushRepeated(filter, 0, SETTLE_SAMPLES));
+  filter.reset(9900);
+  CHECK_EQUAL(10000, pushRepeated(filter, 10000, SETTLE_SAMPLES));
+  filter.reset(10100);
+  CHECK_EQUAL(10000, pushRepeated(filter, 10000, SETTLE_SAMPLES));
+}
+
+#if ABS_ENC_FILTER == ABS_ENC_FILTER_MEAN
+
+TEST(mean_averages_window) {
+  AngleFilter filter(RANGE);
+  filter.reset(0);
+  uint16_t output = 0;
+  for (uint8_t i = 0; i < ABS_ENC_FILTER_WINDOW / 2; i++) {
+    output = filter.push(800);
+  }
+  CHECK_EQUAL(400, output);  // Половина вікна - 800, половина - 0
+  CHECK_EQUAL(800, pushRepeated(filter, 800, ABS_ENC_FILTER_WINDOW / 2));
+}
+
+TEST(mean_rounds_symmetrically) {
+  // Три чверті вікна на +1 і на -1 сотій: середнє ±0.75 округлюється до ±1, а не зрізається до 0
+  AngleFilter filter(RANGE);
+  filter.reset(0);
+  CHECK_EQUAL(1, pushRepeated(filter, 1, ABS_ENC_FILTER_WINDOW * 3 / 4));
+  filter.reset(0);
+  CHECK_EQUAL(35999, pushRepeated(filter, 35999, ABS_ENC_FILTER_WINDOW * 3 / 4));
+}
+
+TEST(mean_across_zero) {
+  AngleFilter filter(RANGE);
+  filter.reset(35900);
+  // Половина вікна - 359°, половина - 1°: середнє 0°, а не 180°
+  CHECK_EQUAL(0, pushRepeated(filter, 100, ABS_ENC_FILTER_WINDOW / 2));
+}
+
+#elif ABS_ENC_FILTER == ABS_ENC_FILTER_MEDIAN
+
+TEST(median_rejects_single_outlier) {
+  AngleFilter filter(RANGE);
+  filter.reset(9000);
+  CHECK_EQUAL(9000, filter.push(27000));
+  CHECK_EQUAL(9000, filter.push(9000));
+  CHECK_EQUAL(9000, filter.push(0));
+}
+
+TEST(median_across_zero) {
+  AngleFilter filter(RANGE);
+  filter.reset(0);
+  filter.push(35990);
+  filter.push(10);
+  filter.push(35980);
+  filter.push(20);
+  CHECK_EQUAL(0, filter.push(0));
+  // Викид навпроти групи біля 0° не розділяє її на 359° і 1°
+  CHECK_EQUAL(10, filter.push(18000));
+  // Два викиди з п'яти ще відкидаються
+  CHECK_EQUAL(20, filter.push(18000));
+}
+
+#elif ABS_ENC_FILTER == ABS_ENC_FILTER_EMA
+
+TEST(ema_moves_alpha_of_difference) {
+  AngleFilter filter(RANGE);
+  filter.reset(0);
+  CHECK_EQUAL((9000L * ABS_ENC_FILTER_ALPHA + 128) / 256, filter.push(9000));
+  // Різниця більша за півколо - крок у протилежний бік
+  filter.reset(0);
+  CHECK_EQUAL((36000L * 256 - (36000 - 25600L) * ABS_ENC_FILTER_ALPHA + 128) / 256, filter.push(25600));
+}
+
+TEST(ema_across_zero) {
+  AngleFilter filter(RANGE);
+  filter.reset(35900);
+  // Різниця 200 найкоротшим шляхом, а не -35800
+  CHECK_EQUAL((35900L * 256 + 200L * ABS_ENC_FILTER_ALPHA + 128) / 256 % RANGE, filter.push(100));
+}
+
+#endif
@@ -0,0 +1,411 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "display.h"
+#include "menu.h"
+
+// Тіньовий буфер: екрани малюються в DisplayBuffer, а flush() відправляє на дисплей
+// тільки символи, що відрізняються від уже показаних. Дисплей підключено через LcdI2cAsync
+// і модель TWI: відправлене з'являється на HD44780, коли минув час передачі на шині
+
+static void flushAll(Display& display) {
+  for (uint8_t i = 0; i < 200; i++) {
+    display.flush();
+    hal::advanceUs(TASK_UI_PERIOD_MS * 1000UL);
+  }
+}
+
+TEST(buffer_stamps_only_real_changes) {
+  DisplayBuffer buffer;
+  buffer.setSize(20, 4);
+  buffer.setCursor(0, 1);
+  buffer.print("abc");
+  uint16_t stamp = buffer.rowStamp(1);
+  CHECK(stamp != 0);
+  CHECK_EQUAL(0, buffer.rowStamp(0));
+
+  buffer.setCursor(0, 1);
+  buffer.print("abc");  // Той самий текст - рядок не змінився
+  CHECK_EQUAL(stamp, buffer.rowStamp(1));
+  buffer.setCursor(1, 1);
+  buffer.print('x');
+  CHECK(buffer.rowStamp(1) != stamp);
+  CHECK_EQUAL('x', buffer.at(1, 1));
+}
+
+TEST(buffer_clips_to_screen) {
+  DisplayBuffer buffer;
+  buffer.setSize(16, 2);
+  buffer.setCursor(14, 0);
+  buffer.print("wrap");
+  CHECK_EQUAL('w', buffer.at(14, 0));
+  CHECK_EQUAL('r', buffer.at(15, 0));
+  CHECK_EQUAL(' ', buffer.at(0, 1));  // Не переноситься в наступний рядок
+  buffer.setCursor(0, 2);
+  buffer.print("hidden");
+  CHECK_EQUAL(0, buffer.rowStamp(2));
+
+  buffer.setCursor(10, 0);
+  buffer.clearToEndOfRow();
+  CHECK_EQUAL(' ', buffer.at(15, 0));
+}
+
+TEST(first_frame_sends_only_non_blank_cells) {
+  Display display(LCD_I2C_ADDRESS, 20, 4);
+  display.begin();
+  uint32_t writes = hal::lcdWrites();
+  display.showSplashScreen(0, 90, false, true);
+  flushAll(display);
+  CHECK_STRING("Motor:Hold ON       ", hal::lcdRow(0));
+  CHECK_STRING("Target:  90^        ", hal::lcdRow(2));
+  CHECK_STRING("Menu:Ok Btn:Start   ", hal::lcdRow(3));
+
+  // Після begin() дисплей порожній - пробіли не відправляються
+  uint32_t nonBlank = 0;
+  for (uint8_t row = 0; row < 4; row++) {
+    for (const char* c = hal::lcdRow(row); *c; c++) {
+      if (*c != ' ') nonBlank++;
+    }
+  }
+  CHECK_EQUAL(nonBlank, hal::lcdWrites() - writes);
+}
+
+TEST(changed_value_sends_only_changed_cells) {
+  Display display(LCD_I2C_ADDRESS, 20, 4);
+  display.begin();
+  display.showSplashScreen(0, 90, false, true);
+  flushAll(display);
+
+  uint32_t writes = hal::lcdWrites();
+  uint32_t moves = hal::lcdCursorMoves();
+  display.showSplashScreen(0, 95, false, true);
+  flushAll(display);
+  CHECK_STRING("Target:  95^        ", hal::lcdRow(2));
+  CHECK_EQUAL(1, hal::lcdWrites() - writes);  // Тільки '0' -> '5'
+  CHECK_EQUAL(1, hal::lcdCursorMoves() - moves);
+
+  // Без змін на дисплей нічого не відправляється
+  writes = hal::lcdWrites();
+  moves = hal::lcdCursorMoves();
+  display.showSplashScreen(0, 95, false, true);
+  flushAll(display);
+  CHECK_EQUAL(writes, hal::lcdWrites());
+  CHECK_EQUAL(moves, hal::lcdCursorMoves());
+}
+
+TEST(rewritten_row_sends_only_differing_cells) {
+  // Рядок переписується повністю, але на дисплей іде лише те, що відрізняється
+  Display display(LCD_I2C_ADDRESS, 20, 4);
+  display.begin();
+  display.showSplashScreen(0, 90, true, true);
+  flushAll(display);
+
+  uint32_t writes = hal::lcdWrites();
+  display.showSplashScreen(0, 90, false, true);
+  flushAll(display);
+  CHECK_STRING("Menu:Ok Btn:Start   ", hal::lcdRow(3));
+  // "Status: RUNNING" -> "Menu:Ok Btn:Start": відрізняються не всі 17 позицій
+  CHECK(hal::lcdWrites() - writes < 17);
+  CHECK(hal::lcdWrites() - writes > 0);
+}
+
+// Копія рядків дисплея для порівняння кадрів
+struct Screen {
+  char rows[4][21];
+};
+
+static void captureScreen(Screen& screen) {
+  for (uint8_t row = 0; row < 4; row++) {
+    strncpy(screen.rows[row], hal::lcdRow(row), 20);
+    screen.rows[row][20] = '\0';
+  }
+}
+
+static bool screenEquals(const Screen& screen) {
+  for (uint8_t row = 0; row < 4; row++) {
+    if (strcmp(screen.rows[row], hal::lcdRow(row)) != 0) return false;
+  }
+  return true;
+}
+
+// Скільки клітинок дисплея показують символ, який є тільки в кадрі frame
+static uint8_t cellsOnlyFrom(const Screen& frame, const Screen& other1, const Screen& other2) {
+  uint8_t cells = 0;
+  for (uint8_t row = 0; row < 4; row++) {
+    const char* shown = hal::lcdRow(row);
+    for (uint8_t col = 0; col < 20; col++) {
+      char c = frame.rows[row][col];
+      if (shown[col] == c && c != other1.rows[row][col] && c != other2.rows[row][col]) cells++;
+    }
+  }
+  return cells;
+}
+
+// Кожна клітинка дисплея - з одного з кадрів
+static bool screenMadeOf(const Screen& a, const Screen& b, const Screen& c) {
+  for (uint8_t row = 0; row < 4; row++) {
+    const char* shown = hal::lcdRow(row);
+    for (uint8_t col = 0; col < 20; col++) {
+      if (shown[col] != a.rows[row][col] && shown[col] != b.rows[row][col] && shown[col] != c.rows[row][col]) return false;
+    }
+  }
+  return true;
+}
+
+static uint32_t lcdBytes() {
+  return hal::lcdWrites() + hal::lcdCursorMoves();
+}
+
+// Один прохід flush() і повна передача черги: повертає кількість байтів, що дійшли до дисплея
+static uint32_t flushPass(Display& display) {
+  uint32_t bytes = lcdBytes();
+  display.flush();
+  hal::advanceUs(10000);
+  return lcdBytes() - bytes;
+}
+
+TEST(flush_pass_stays_within_budget) {
+  Display display(LCD_I2C_ADDRESS, 20, 4);
+  display.begin();
+  display.showSplashScreen(0, 90, false, true);
+
+  uint32_t total = 0;
+  uint16_t passes = 0;
+  for (uint16_t i = 0; i < 200; i++) {
+    uint32_t bytes = flushPass(display);
+    CHECK(bytes <= DISPLAY_FLUSH_BUDGET_BYTES);
+    if (bytes != 0) passes++;
+    total += bytes;
+  }
+  CHECK_STRING("Menu:Ok Btn:Start   ", hal::lcdRow(3));
+  // Кадр з кількох рядків не вміщується в один прохід - розбивається на кілька
+  CHECK(passes >= total / DISPLAY_FLUSH_BUDGET_BYTES);
+  CHECK(passes > 1);
+}
+
+TEST(frame_drawn_mid_send_waits_for_previous_snapshot) {
+  Display display(LCD_I2C_ADDRESS, 20, 4);
+  display.begin();
+  display.showSplashScreen(0, 90, false, true);
+  flushAll(display);
+  Screen frameA;
+  captureScreen(frameA);
+
+  // Кадр B змінює два рядки; рядки 2-3 лишаються з кадру A
+  Screen frameB = frameA;
+  strcpy(frameB.rows[0], "Moving to target    ");
+  strcpy(frameB.rows[1], "Angle: 123.4        ");
+  display.showMessage(F("Moving to target    "), F("Angle: 123.4        "));
+  for (uint8_t i = 0; i < 3; i++) {
+    CHECK(flushPass(display) <= DISPLAY_FLUSH_BUDGET_BYTES);
+    CHECK(screenMadeOf(frameA, frameB, frameB));
+  }
+  CHECK(cellsOnlyFrom(frameA, frameB, frameB) > 0);  // B ще відправляється
+
+  // Кадр C малюється посеред відправки B
+  Screen frameC = frameA;
+  strcpy(frameC.rows[0], "Calibration done    ");
+  strcpy(frameC.rows[1], "Saved to EEPROM     ");
+  display.showMessage(F("Calibration done    "), F("Saved to EEPROM     "));
+
+  uint16_t passes = 0;
+  while (!screenEquals(frameC) && passes < 200) {
+    CHECK(flushPass(display) <= DISPLAY_FLUSH_BUDGET_BYTES);
+    passes++;
+    CHECK(screenMadeOf(frameA, frameB, frameC));
+    // Жоден прохід не лишає на дисплеї одночасно залишки A і вже відправлені символи C:
+    // знімок C береться тільки після того, як B повністю на дисплеї
+    CHECK(cellsOnlyFrom(frameA, frameB, frameC) == 0 || cellsOnlyFrom(frameC, frameA, frameB) == 0);
+  }
+  CHECK(passes > 1);
+  CHECK(screenEquals(frameC));
+}
+
+// Частота шини і бенчмарк на моделі TWI: байт у PCF8574 - 9 біт на частоті шини, символ - 6 байтів
+
+TEST(fast_mode_selected_when_module_passes_probe) {
+  Display display(LCD_I2C_ADDRESS, 20, 4);
+  display.begin();
+  CHECK_EQUAL(LCD_I2C_FAST_CLOCK_HZ, display.getBusClock());
+  CHECK_EQUAL(LCD_I2C_FAST_CLOCK_HZ, hal::twiClockHz());
+}
+
+TEST(bus_clock_falls_back_when_module_fails_fast_mode) {
+  hal::twiSetMaxClock(100000);
+  Display display(LCD_I2C_ADDRESS, 20, 4);
+  display.begin();
+  CHECK_EQUAL(LCD_I2C_CLOCK_HZ, display.getBusClock());
+  CHECK_EQUAL(LCD_I2C_CLOCK_HZ, hal::twiClockHz());
+  // Невдала перевірка не зачіпає дисплей
+  display.showSplashScreen(0, 90, false, true);
+  flushAll(display);
+  CHECK_STRING("Menu:Ok Btn:Start   ", hal::lcdRow(3));
+}
+
+static uint32_t shownNumber(uint8_t row, const char* label) {
+  const char* text = hal::lcdRow(row);
+  const char* at = strstr(text, label);
+  return at ? strtoul(at + strlen(label), nullptr, 10) : 0;
+}
+
+struct BenchmarkResult {
+  uint32_t fullUs;
+  uint32_t cellUs;
+  uint32_t clearUs;
+  uint32_t charsPerSecond;
+  uint32_t clockKhz;
+};
+
+static BenchmarkResult runBenchmarkAt(uint32_t maxClockHz) {
+  hal::reset();
+  hal::twiSetMaxClock(maxClockHz);
+  Display display(LCD_I2C_ADDRESS, 20, 4);
+  display.begin();
+  display.runBenchmark();
+  BenchmarkResult result;
+  result.fullUs = shownNumber(0, "Full:");
+  result.cellUs = shownNumber(1, "Cell:");
+  result.clearUs = shownNumber(1, "Clr:");
+  result.charsPerSecond = shownNumber(2, "");
+  result.clockKhz = shownNumber(3, "I2C:");
+  return result;
+}
+
+// Найкоротша передача за моделлю шини: START, адреса і байти по 9 біт (час кроку округлюється угору)
+static uint32_t busUs(uint32_t bytes, uint32_t clockHz) {
+  uint32_t bitUs = (1000000UL + clockHz - 1) / clockHz;
+  uint32_t byteUs = (9000000UL + clockHz - 1) / clockHz;
+  return bitUs + byteUs * (bytes + 1);
+}
+
+// Значення в межах [мінімум за моделлю шини, +10%]
+static bool withinModel(uint32_t measured, uint32_t minimum) {
+  return measured >= minimum && measured <= minimum + minimum / 10;
+}
+
+TEST(benchmark_follows_bus_timing_model) {
+  // Повне перемалювання: 80 символів і 4 команди курсора по 6 байтів;
+  // один символ - команда курсора і символ; clear() - команда і 2 мс очікування
+  const uint32_t fullBytes = (80 + 4) * LcdI2cAsync::QUEUE_BYTES_PER_SEND;
+  const uint32_t cellBytes = 2 * LcdI2cAsync::QUEUE_BYTES_PER_SEND;
+  const uint32_t clearBytes = LcdI2cAsync::QUEUE_BYTES_PER_SEND;
+
+  BenchmarkResult slow = runBenchmarkAt(LCD_I2C_CLOCK_HZ);
+  CHECK_EQUAL(100, slow.clockKhz);
+  CHECK(withinModel(slow.fullUs, busUs(fullBytes, LCD_I2C_CLOCK_HZ)));
+  CHECK(withinModel(slow.cellUs, busUs(cellBytes, LCD_I2C_CLOCK_HZ)));
+  CHECK(withinModel(slow.clearUs, 2000 + busUs(clearBytes, LCD_I2C_CLOCK_HZ)));
+  CHECK(slow.charsPerSecond > 1600 && slow.charsPerSecond < 1900);
+
+  BenchmarkResult fast = runBenchmarkAt(LCD_I2C_FAST_CLOCK_HZ);
+  CHECK_EQUAL(400, fast.clockKhz);
+  CHECK(withinModel(fast.fullUs, busUs(fullBytes, LCD_I2C_FAST_CLOCK_HZ)));
+  CHECK(withinModel(fast.cellUs, busUs(cellBytes, LCD_I2C_FAST_CLOCK_HZ)));
+  CHECK(withinModel(fast.clearUs, 2000 + busUs(clearBytes, LCD_I2C_FAST_CLOCK_HZ)));
+  CHECK(fast.charsPerSecond > 3 * slow.charsPerSecond);
+}
+
+// Екран змінюється на кожному проході (як кут під час руху). Прохід flush() лише ставить байти
+// в чергу в межах вільного місця і не чекає на шину - ні на 100 кГц, де шина не встигає за бюджетом
+// DISPLAY_FLUSH_BUDGET_BYTES (24 байти за ~2.2 мс при періоді задачі 2 мс), ні на 400 кГц
+static void checkPassBudget(uint32_t maxClockHz) {
+  hal::twiSetMaxClock(maxClockHz);
+  Display display(LCD_I2C_ADDRESS, 20, 4);
+  display.begin();
+  CHECK_EQUAL(maxClockHz, display.getBusClock());
+  unsigned long byteUs = 9 * 1000000UL / display.getBusClock();
+
+  unsigned long worstUs = 0;
+  for (uint16_t pass = 0; pass < 500; pass++) {
+    display.showSplashScreen((uint16_t)((pass * 737UL) % 36000), pass % 360, true, true);
+    unsigned long start = micros();
+    display.flush();
+    unsigned long passUs = micros() - start;
+    if (passUs > worstUs) {
+      worstUs = passUs;
+    }
+    hal::advanceUs(TASK_UI_PERIOD_MS * 1000UL);
+  }
+  if (worstUs >= byteUs) {
+    printf("  %lu Hz: flush() took %lu us\n", (unsigned long)maxClockHz, worstUs);
+  }
+  CHECK(worstUs < byteUs);
+  CHECK(worstUs <= TASK_UI_BUDGET_US);
+
+  // Коли вміст перестає змінюватись, дисплей доганяє буфер
+  display.showSplashScreen(4500, 45, false, true);
+  flushAll(display);
+  CHECK_STRING("Target:  45^        ", hal::lcdRow(2));
+}
+
+TEST(flush_pass_never_waits_for_bus_at_100_khz) {
+  checkPassBudget(LCD_I2C_CLOCK_HZ);
+}
+
+TEST(flush_pass_never_waits_for_bus_at_400_khz) {
+  checkPassBudget(LCD_I2C_FAST_CLOCK_HZ);
+}
+
+// Один перехід меню: повертає байти, що дійшли до дисплея (символи і команди курсора).
+// Їх не більше, ніж клітинок, що змінились, плюс одна команда курсора на кожен відрізок змін
+static uint32_t showMenuTransition(Display& display, Menu& menu) {
+  Screen before;
+  captureScreen(before);
+  uint32_t writes = hal::lcdWrites();
+  uint32_t moves = hal::lcdCursorMoves();
+  display.showMenu(menu.getCurrentNode(), menu.getCurrentItem(), menu.getCurrentValue(), menu.getDigitMode());
+  flushAll(display);
+
+  uint32_t changed = 0;
+  uint32_t runs = 0;
+  for (uint8_t row = 0; row < 4; row++) {
+    const char* shown = hal::lcdRow(row);
+    bool inRun = false;
+    for (uint8_t col = 0; col < 20; col++) {
+      bool differs = shown[col] != before.rows[row][col];
+      if (differs) changed++;
+      if (differs && !inRun) runs++;
+      inRun = differs;
+    }
+  }
+  CHECK_EQUAL(changed, hal::lcdWrites() - writes);
+  CHECK(hal::lcdCursorMoves() - moves <= runs);
+  return (hal::lcdWrites() - writes) + (hal::lcdCursorMoves() - moves);
+}
+
+TEST(menu_transition_sends_only_changed_cells) {
+  Display display(LCD_I2C_ADDRESS, 20, 4);
+  display.begin();
+  Menu menu;
+  display.showSplashScreen(0, 90, false, true);
+  flushAll(display);
+
+  menu.handleSplashMenu(true, false);  // Сплеш -> головне меню: змінюється весь екран
+  uint32_t bytes = showMenuTransition(display, menu);
+  CHECK_STRING("Main Menu           ", hal::lcdRow(0));
+  CHECK(bytes > 0);
+
+  // Наступний пункт: переміщується лише маркер - дві клітинки, дві команди курсора
+  menu.updateNavigation(1, false);
+  CHECK_EQUAL(4, showMenuTransition(display, menu));
+  menu.updateNavigation(-1, false);
+  CHECK_EQUAL(4, showMenuTransition(display, menu));
+
+  // Той самий стан - нічого не відправляється
+  CHECK_EQUAL(0, showMenuTransition(display, menu));
+
+  // Вхід у вузли і повернення: кожна клітинка заголовка і пунктів - один раз
+  menu.updateNavigation(1, false);
+  showMenuTransition(display, menu);
+  menu.updateNavigation(0, true);  // Settings
+  CHECK(showMenuTransition(display, menu) > 0);
+  menu.updateNavigation(0, true);  // Вибір підтверджено - повернення на сплеш-екран
+  CHECK(menu.getCurrentNode() == nullptr);
+  menu.handleSplashMenu(true, false);
+  showMenuTransition(display, menu);
+  menu.updateNavigation(-1, false);  // Останній пункт - Save Position
+  showMenuTransition(display, menu);
+  menu.updateNavigation(0, true);
+  CHECK(showMenuTransition(display, menu) > 0);
+  CHECK_STRING("Save Position       ", hal::lcdRow(1));
+}
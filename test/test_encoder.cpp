@@ -0,0 +1,142 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "encoder.h"
+
+// Послідовності фронтів енкодера меню: кожна зміна піна викликає обробник, як CHANGE на INT0/INT1.
+// Стан (A << 1) | B, положення фіксації - обидва HIGH; вперед: 11 -> 10 -> 00 -> 01 -> 11.
+// Час обробника (такти AVR) на ПК не вимірюється - тільки лічба
+static_assert(ENCODER_STEPS_PER_DETENT == 4, "sequences below are for 4 transitions per detent");
+
+static void forward() {
+  hal::setInput(ENC_B, LOW);
+  hal::setInput(ENC_A, LOW);
+  hal::setInput(ENC_B, HIGH);
+  hal::setInput(ENC_A, HIGH);
+}
+
+static void backward() {
+  hal::setInput(ENC_A, LOW);
+  hal::setInput(ENC_B, LOW);
+  hal::setInput(ENC_A, HIGH);
+  hal::setInput(ENC_B, HIGH);
+}
+
+TEST(counts_detents_in_both_directions) {
+  Encoder encoder(ENC_A, ENC_B);
+  encoder.begin();
+  forward();
+  forward();
+  forward();
+  CHECK_EQUAL(3, encoder.getDelta());
+  CHECK_EQUAL(3, encoder.read());
+  CHECK_EQUAL(0, encoder.read());
+
+  backward();
+  backward();
+  CHECK_EQUAL(-2, encoder.read());
+}
+
+TEST(no_count_between_detents) {
+  Encoder encoder(ENC_A, ENC_B);
+  encoder.begin();
+  hal::setInput(ENC_B, LOW);
+  hal::setInput(ENC_A, LOW);
+  hal::setInput(ENC_B, HIGH);
+  CHECK_EQUAL(0, encoder.getDelta());  // Ще не в положенні фіксації
+  hal::setInput(ENC_A, HIGH);
+  CHECK_EQUAL(1, encoder.getDelta());
+}
+
+TEST(contact_bounce_cancels_out) {
+  Encoder encoder(ENC_A, ENC_B);
+  encoder.begin();
+  // Брязкіт у положенні фіксації
+  for (uint8_t i = 0; i < 5; i++) {
+    hal::setInput(ENC_B, LOW);
+    hal::setInput(ENC_B, HIGH);
+  }
+  CHECK_EQUAL(0, encoder.getDelta());
+
+  // Брязкіт посередині клацання
+  hal::setInput(ENC_B, LOW);
+  hal::setInput(ENC_A, LOW);
+  hal::setInput(ENC_A, HIGH);
+  hal::setInput(ENC_A, LOW);
+  hal::setInput(ENC_B, HIGH);
+  hal::setInput(ENC_B, LOW);
+  hal::setInput(ENC_B, HIGH);
+  hal::setInput(ENC_A, HIGH);
+  CHECK_EQUAL(1, encoder.read());
+}
+
+TEST(half_turn_and_back_is_not_a_detent) {
+  Encoder encoder(ENC_A, ENC_B);
+  encoder.begin();
+  hal::setInput(ENC_B, LOW);
+  hal::setInput(ENC_A, LOW);
+  hal::setInput(ENC_A, HIGH);
+  hal::setInput(ENC_B, HIGH);
+  CHECK_EQUAL(0, encoder.getDelta());
+}
+
+TEST(illegal_transition_is_rejected) {
+  // Обробник бачить, що змінились обидва сигнали: перехід не рахується,
+  // і лишається 2 переходи з 4 - клацання не зараховується
+  Encoder encoder(ENC_A, ENC_B);
+  encoder.begin();
+  hal::setInput(ENC_B, LOW);
+  hal::setInputs(ENC_A, LOW, ENC_B, HIGH);
+  hal::setInput(ENC_A, HIGH);
+  CHECK_EQUAL(0, encoder.getDelta());
+
+  // Наступне клацання рахується як звичайно
+  forward();
+  CHECK_EQUAL(1, encoder.getDelta());
+}
+
+TEST(three_of_four_transitions_count) {
+  // Ручка зупинилась між клацаннями до begin(): до положення фіксації лишається 3 переходи
+  hal::setInput(ENC_B, LOW);
+  Encoder encoder(ENC_A, ENC_B);
+  encoder.begin();
+  hal::setInput(ENC_A, LOW);
+  hal::setInput(ENC_B, HIGH);
+  hal::setInput(ENC_A, HIGH);
+  CHECK_EQUAL(1, encoder.getDelta());
+}
+
+TEST(speed_from_interval_between_detents) {
+  Encoder encoder(ENC_A, ENC_B);
+  encoder.begin();
+  hal::advanceUs(1000000);
+  forward();
+  CHECK_EQUAL(0, encoder.getSpeed());  // Перше клацання після паузи - швидкість невідома
+
+  hal::advanceUs(100000);
+  forward();
+  CHECK_EQUAL(10, encoder.getSpeed());
+  hal::advanceUs(50000);
+  forward();
+  CHECK_EQUAL(13, encoder.getSpeed());  // Середнє інтервалів 100 і 50 мс
+
+  // Зупинка: після ENCODER_SPEED_TIMEOUT_MS без клацань - 0
+  hal::advanceUs(ENCODER_SPEED_TIMEOUT_MS * 1000UL + 1000);
+  CHECK_EQUAL(0, encoder.getSpeed());
+}
+
+TEST(speed_resets_on_direction_change) {
+  Encoder encoder(ENC_A, ENC_B);
+  encoder.begin();
+  for (uint8_t i = 0; i < 3; i++) {
+    hal::advanceUs(20000);
+    forward();
+  }
+  CHECK_EQUAL(50, encoder.getSpeed());
+  hal::advanceUs(20000);
+  backward();
+  CHECK_EQUAL(0, encoder.getSpeed());
+  hal::advanceUs(20000);
+  backward();
+  CHECK_EQUAL(50, encoder.getSpeed());
+}
@@ -0,0 +1,139 @@
+#include "test.h"
+#include "hal.h"
+#include <math.h>
+#include "config.h"
+#include "stepper.h"
+#include "absolute_encoder.h"
+#include "encoder_calibration.h"
+
+// Нелінійний датчик: АЦП дає справжній кут (за кроками двигуна) плюс гладке спотворення
+// з першою і другою гармонікою до ~4°. Після калібрування похибка має лишитись на рівні
+// квантування АЦП і похибки кусково-лінійної інтерполяції між 16 вузлами.
+// Опитування на ПК читає АЦП без передискретизації, тому молодший розряд - ~35 сотих градуса
+
+static const unsigned long LOOP_US = 50;
+static const int32_t ADC_LSB_CDEG = 36000L / 1023;
+static int32_t truthCdeg = -1;  // Кут для перевірки після калібрування; -1 - кут за кроками двигуна
+
+static int32_t distortionCdeg(int32_t cdeg) {
+  double theta = cdeg * M_PI / 18000.0;
+  return (int32_t)lround(300.0 * sin(theta) + 100.0 * sin(2.0 * theta + 0.5));
+}
+
+static uint16_t distortedAdc(uint8_t) {
+  int32_t cdeg = truthCdeg;
+  if (cdeg < 0) {
+    int32_t steps = hal::stepperSteps() % STEPS_360;
+    cdeg = (steps < 0 ? steps + STEPS_360 : steps) * 36000L / STEPS_360;
+  }
+  int32_t measured = (cdeg + distortionCdeg(cdeg) + 36000) % 36000;
+  return (uint16_t)((measured * 1023L + 18000) / 36000);
+}
+
+static int32_t wrapDiff(int32_t diff) {
+  while (diff > 18000) diff -= 36000;
+  while (diff < -18000) diff += 36000;
+  return diff;
+}
+
+static uint16_t readSettled(AbsoluteEncoder& encoder) {
+  for (uint8_t i = 0; i < 5; i++) {
+    encoder.readAngleCdeg();  // Заповнюємо вікно фільтра новим кутом
+  }
+  return encoder.readAngleCdeg();
+}
+
+// Розкид похибки по колу (постійна складова знімається обнуленням)
+static int32_t errorSpread(AbsoluteEncoder& encoder) {
+  int32_t minError = 36000;
+  int32_t maxError = -36000;
+  for (truthCdeg = 0; truthCdeg < 36000; truthCdeg += 500) {
+    int32_t error = wrapDiff((int32_t)readSettled(encoder) - truthCdeg);
+    if (error < minError) minError = error;
+    if (error > maxError) maxError = error;
+  }
+  truthCdeg = -1;
+  return maxError - minError;
+}
+
+TEST(calibration_table_corrects_nonlinear_sensor) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  AbsoluteEncoder encoder(ABS_ENC_PIN);
+  EncoderCalibration calibration(stepper, encoder);
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+  hal::setAnalogSource(distortedAdc);
+  stepper.begin();
+  encoder.begin();
+
+  int32_t uncalibrated = errorSpread(encoder);
+  CHECK(uncalibrated > 600);
+
+  calibration.start();
+  unsigned long limit = millis() + ABS_ENC_CAL_POINTS * (ABS_ENC_CAL_SETTLE_MS + 1000UL);
+  while (calibration.isActive() && (long)(limit - millis()) > 0) {
+    stepper.update();
+    calibration.update(millis());
+    hal::advanceUs(LOOP_US);
+  }
+  CHECK(calibration.isDone());
+  CHECK_EQUAL(ABS_ENC_CAL_POINTS, calibration.getProgress());
+  while (stepper.getRemaining() != 0) {
+    stepper.update();
+    hal::advanceUs(LOOP_US);
+  }
+  CHECK_EQUAL(STEPS_360, hal::stepperSteps());  // Стіл повернувся у вихідне положення
+
+  encoder.setCalibration(calibration.getTable());
+  CHECK(encoder.isCalibrated());
+  int32_t calibrated = errorSpread(encoder);
+  // Квантування і в точках калібрування, і при читанні - до двох розрядів, плюс інтерполяція
+  CHECK(calibrated <= 2 * ADC_LSB_CDEG + 10);
+}
+
+TEST(linear_sensor_gives_near_zero_table) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  AbsoluteEncoder encoder(ABS_ENC_PIN);
+  EncoderCalibration calibration(stepper, encoder);
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+  hal::setAnalogSource([](uint8_t) -> uint16_t {
+    int32_t steps = hal::stepperSteps() % STEPS_360;
+    return (uint16_t)((steps * 1023L + STEPS_360 / 2) / STEPS_360);
+  });
+  stepper.begin();
+  encoder.begin();
+
+  calibration.start();
+  while (calibration.isActive()) {
+    stepper.update();
+    calibration.update(millis());
+    hal::advanceUs(LOOP_US);
+  }
+  for (uint8_t i = 0; i < ABS_ENC_CAL_POINTS; i++) {
+    CHECK(abs(calibration.getTable()[i]) <= ADC_LSB_CDEG / 2 + 1);  // Пів молодшого розряду АЦП
+  }
+}
+
+TEST(table_follows_encoder_full_scale) {
+  // Шкала енкодера 180°: оберт столу - це 0-17999 сотих, вузли через 18000 / ABS_ENC_CAL_POINTS
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  AbsoluteEncoder encoder(ABS_ENC_PIN, 5.0, 180.0);
+  EncoderCalibration calibration(stepper, encoder);
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+  hal::setAnalogSource([](uint8_t) -> uint16_t {
+    int32_t steps = hal::stepperSteps() % STEPS_360;
+    return (uint16_t)((steps * 1023L + STEPS_360 / 2) / STEPS_360);
+  });
+  stepper.begin();
+  encoder.begin();
+  CHECK_EQUAL(18000, encoder.getMaxAngleCdeg());
+
+  calibration.start();
+  while (calibration.isActive()) {
+    stepper.update();
+    calibration.update(millis());
+    hal::advanceUs(LOOP_US);
+  }
+  for (uint8_t i = 0; i < ABS_ENC_CAL_POINTS; i++) {
+    CHECK(abs(calibration.getTable()[i]) <= ADC_LSB_CDEG / 4 + 1);  // Пів розряду при вдвічі меншій шкалі
+  }
+}
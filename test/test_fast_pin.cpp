@@ -0,0 +1,71 @@
+#include "test.h"
+#include <Arduino.h>
+
+// Таблиці пін -> порт/біт з fast_pin.h для Nano і Mega проти розкладки pins_arduino.h ядра Arduino.
+// На ПК регістрів портів немає, тому перевіряються тільки constexpr-таблиці:
+// заголовок підключається двічі, у двох просторах імен, з макросом відповідного контролера.
+// SREG і cli() потрібні лише для компіляції шаблону FastPin (він тут не інстанціюється)
+static uint8_t SREG;
+static void cli() {}
+
+namespace nano {
+#define __AVR_ATmega328P__
+#include "fast_pin.h"
+#undef __AVR_ATmega328P__
+}
+
+#undef FAST_PIN_H
+#undef FAST_PIN_AVAILABLE
+#undef FAST_PIN_PORTS
+#undef FAST_PIN_BITS
+#undef FAST_PIN_COUNT
+
+namespace mega {
+#define __AVR_ATmega2560__
+#include "fast_pin.h"
+#undef __AVR_ATmega2560__
+}
+
+struct PinMapping {
+  char port;
+  uint8_t bit;
+};
+
+// variants/standard/pins_arduino.h
+static const PinMapping NANO_PINS[] = {
+  { 'D', 0 }, { 'D', 1 }, { 'D', 2 }, { 'D', 3 }, { 'D', 4 }, { 'D', 5 }, { 'D', 6 }, { 'D', 7 },
+  { 'B', 0 }, { 'B', 1 }, { 'B', 2 }, { 'B', 3 }, { 'B', 4 }, { 'B', 5 },
+  { 'C', 0 }, { 'C', 1 }, { 'C', 2 }, { 'C', 3 }, { 'C', 4 }, { 'C', 5 }
+};
+
+// variants/mega/pins_arduino.h
+static const PinMapping MEGA_PINS[] = {
+  { 'E', 0 }, { 'E', 1 }, { 'E', 4 }, { 'E', 5 }, { 'G', 5 }, { 'E', 3 }, { 'H', 3 }, { 'H', 4 },  // D0-D7
+  { 'H', 5 }, { 'H', 6 }, { 'B', 4 }, { 'B', 5 }, { 'B', 6 }, { 'B', 7 }, { 'J', 1 }, { 'J', 0 },  // D8-D15
+  { 'H', 1 }, { 'H', 0 }, { 'D', 3 }, { 'D', 2 }, { 'D', 1 }, { 'D', 0 },                          // D16-D21
+  { 'A', 0 }, { 'A', 1 }, { 'A', 2 }, { 'A', 3 }, { 'A', 4 }, { 'A', 5 }, { 'A', 6 }, { 'A', 7 },  // D22-D29
+  { 'C', 7 }, { 'C', 6 }, { 'C', 5 }, { 'C', 4 }, { 'C', 3 }, { 'C', 2 }, { 'C', 1 }, { 'C', 0 },  // D30-D37
+  { 'D', 7 }, { 'G', 2 }, { 'G', 1 }, { 'G', 0 },                                                  // D38-D41
+  { 'L', 7 }, { 'L', 6 }, { 'L', 5 }, { 'L', 4 }, { 'L', 3 }, { 'L', 2 }, { 'L', 1 }, { 'L', 0 },  // D42-D49
+  { 'B', 3 }, { 'B', 2 }, { 'B', 1 }, { 'B', 0 },                                                  // D50-D53
+  { 'F', 0 }, { 'F', 1 }, { 'F', 2 }, { 'F', 3 }, { 'F', 4 }, { 'F', 5 }, { 'F', 6 }, { 'F', 7 },  // A0-A7
+  { 'K', 0 }, { 'K', 1 }, { 'K', 2 }, { 'K', 3 }, { 'K', 4 }, { 'K', 5 }, { 'K', 6 }, { 'K', 7 }   // A8-A15
+};
+
+TEST(nano_pin_table_matches_core) {
+  CHECK_EQUAL(sizeof(NANO_PINS) / sizeof(NANO_PINS[0]), 20);
+  for (uint8_t pin = 0; pin < 20; pin++) {
+    CHECK_EQUAL(NANO_PINS[pin].port, nano::fastPinPort(pin));
+    CHECK_EQUAL(1 << NANO_PINS[pin].bit, nano::fastPinMask(pin));
+  }
+  CHECK_EQUAL(0, nano::fastPinPort(20));  // За межами таблиці
+}
+
+TEST(mega_pin_table_matches_core) {
+  CHECK_EQUAL(sizeof(MEGA_PINS) / sizeof(MEGA_PINS[0]), 70);
+  for (uint8_t pin = 0; pin < 70; pin++) {
+    CHECK_EQUAL(MEGA_PINS[pin].port, mega::fastPinPort(pin));
+    CHECK_EQUAL(1 << MEGA_PINS[pin].bit, mega::fastPinMask(pin));
+  }
+  CHECK_EQUAL(0, mega::fastPinPort(70));
+}
@@ -0,0 +1,53 @@
+#include "test.h"
+#include "format.h"
+
+static const char* format(uint16_t value, uint8_t decimals) {
+  static char buffer[8];
+  formatFixed(buffer, value, decimals);
+  return buffer;
+}
+
+TEST(format_examples) {
+  CHECK_STRING("123.45", format(12345, 2));
+  CHECK_STRING("0.05", format(5, 2));
+  CHECK_STRING("0.00", format(0, 2));
+  CHECK_STRING("359.99", format(35999, 2));
+  CHECK_STRING("655.35", format(65535, 2));
+  CHECK_STRING("0.0007", format(7, 4));
+  CHECK_STRING("6.5535", format(65535, 4));
+}
+
+TEST(format_without_decimals) {
+  CHECK_STRING("0", format(0, 0));
+  CHECK_STRING("7", format(7, 0));
+  CHECK_STRING("65535", format(65535, 0));
+}
+
+TEST(format_returns_length) {
+  char buffer[8];
+  CHECK_EQUAL(6, formatFixed(buffer, 12345, 2));
+  CHECK_EQUAL(4, formatFixed(buffer, 5, 2));
+  CHECK_EQUAL(1, formatFixed(buffer, 0, 0));
+}
+
+TEST(format_matches_printf) {
+  // Усі значення з 0-3 знаками після коми - як printf("%u.%0*u")
+  char expected[16];
+  static const uint16_t divisors[] = { 1, 10, 100, 1000 };
+  for (uint8_t decimals = 0; decimals <= 3; decimals++) {
+    uint16_t divisor = divisors[decimals];
+    uint32_t value = 0;
+    do {
+      if (decimals == 0) {
+        snprintf(expected, sizeof(expected), "%u", (unsigned)value);
+      } else {
+        snprintf(expected, sizeof(expected), "%u.%0*u", (unsigned)(value / divisor), decimals, (unsigned)(value % divisor));
+      }
+      if (strcmp(expected, format(value, decimals)) != 0) {
+        CHECK_STRING(expected, format(value, decimals));
+        break;
+      }
+      value++;
+    } while (value <= 0xFFFF);
+  }
+}
@@ -0,0 +1,197 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "input_scanner.h"
+
+// Такт сканера викликається напряму (InputScanner::tickIsr, як переривання Timer0 COMPB): один виклик = 1 мс.
+// Зразок debounce - кожен INPUT_DEBOUNCE_SAMPLE_MS-й такт, стан змінюється після 4 однакових зразків
+
+static void ticks(uint32_t count) {
+  for (uint32_t i = 0; i < count; i++) {
+    InputScanner::tickIsr();
+  }
+}
+
+static bool nextEvent(InputScanner& scanner, uint8_t button, uint8_t type, InputEvent& event) {
+  if (!scanner.read(event)) {
+    return false;
+  }
+  return event.button == button && event.type == type;
+}
+
+TEST(press_after_four_equal_samples) {
+  InputScanner scanner;
+  scanner.begin();
+  InputEvent event;
+  hal::setInput(ENC_BTN, LOW);
+  ticks(3 * INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(!scanner.read(event));
+  CHECK(!scanner.isHeld(INPUT_ENCODER_BUTTON));
+
+  ticks(INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(nextEvent(scanner, INPUT_ENCODER_BUTTON, INPUT_EVENT_PRESS, event));
+  CHECK(scanner.isHeld(INPUT_ENCODER_BUTTON));
+  CHECK(!scanner.read(event));
+
+  hal::setInput(ENC_BTN, HIGH);
+  ticks(4 * INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(nextEvent(scanner, INPUT_ENCODER_BUTTON, INPUT_EVENT_RELEASE, event));
+  CHECK_EQUAL(4 * INPUT_DEBOUNCE_SAMPLE_MS - 1, event.duration);
+  CHECK(!scanner.isHeld(INPUT_ENCODER_BUTTON));
+}
+
+TEST(bounce_is_filtered) {
+  // Рівень змінюється між кожними двома-трьома зразками - чотирьох однакових підряд немає
+  InputScanner scanner;
+  scanner.begin();
+  InputEvent event;
+  for (uint8_t i = 0; i < 30; i++) {
+    hal::setInput(START_STOP_BUTTON_PIN, (i % 3) == 0);
+    ticks(INPUT_DEBOUNCE_SAMPLE_MS);
+  }
+  CHECK(!scanner.read(event));
+  CHECK(!scanner.isHeld(INPUT_START_STOP));
+}
+
+TEST(buttons_debounce_independently) {
+  InputScanner scanner;
+  scanner.begin();
+  InputEvent event;
+  hal::setInput(DIGIT_MODE_BUTTON_PIN, LOW);
+  ticks(2 * INPUT_DEBOUNCE_SAMPLE_MS);
+  hal::setInput(START_STOP_BUTTON_PIN, LOW);
+  ticks(2 * INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(nextEvent(scanner, INPUT_DIGIT_MODE, INPUT_EVENT_PRESS, event));
+  CHECK(!scanner.read(event));
+  ticks(2 * INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(nextEvent(scanner, INPUT_START_STOP, INPUT_EVENT_PRESS, event));
+}
+
+TEST(long_press_once) {
+  InputScanner scanner;
+  scanner.begin();
+  InputEvent event;
+  hal::setInput(ENC_BTN, LOW);
+  ticks(4 * INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(nextEvent(scanner, INPUT_ENCODER_BUTTON, INPUT_EVENT_PRESS, event));
+
+  ticks(LONG_PRESS_THRESHOLD_MS - 1);
+  CHECK(!scanner.read(event));
+  ticks(1);
+  CHECK(nextEvent(scanner, INPUT_ENCODER_BUTTON, INPUT_EVENT_LONG, event));
+  CHECK_EQUAL(LONG_PRESS_THRESHOLD_MS, event.duration);
+  ticks(3000);
+  CHECK(!scanner.read(event));
+
+  hal::setInput(ENC_BTN, HIGH);
+  ticks(4 * INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(nextEvent(scanner, INPUT_ENCODER_BUTTON, INPUT_EVENT_RELEASE, event));
+  CHECK(event.duration > LONG_PRESS_THRESHOLD_MS + 3000);
+}
+
+TEST(long_press_can_be_disabled) {
+  InputScanner scanner;
+  scanner.setLongPressMs(INPUT_ENCODER_BUTTON, 0);
+  scanner.begin();
+  InputEvent event;
+  hal::setInput(ENC_BTN, LOW);
+  ticks(4 * INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(nextEvent(scanner, INPUT_ENCODER_BUTTON, INPUT_EVENT_PRESS, event));
+  ticks(LONG_PRESS_THRESHOLD_MS * 2);
+  CHECK(!scanner.read(event));
+}
+
+TEST(repeat_after_delay_then_interval) {
+  InputScanner scanner;
+  scanner.begin();
+  InputEvent event;
+  hal::setInput(STEP_FINE_ADJUST_BUTTON_PIN, LOW);
+  ticks(4 * INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(nextEvent(scanner, INPUT_STEP_FINE, INPUT_EVENT_PRESS, event));
+
+  ticks(STEP_BUTTON_LONG_PRESS_MS - 1);
+  CHECK(!scanner.read(event));
+  ticks(1);
+  CHECK(nextEvent(scanner, INPUT_STEP_FINE, INPUT_EVENT_REPEAT, event));
+  CHECK_EQUAL(STEP_BUTTON_LONG_PRESS_MS, event.duration);
+
+  ticks(STEP_BUTTON_REPEAT_DELAY_MS * 3);
+  for (uint8_t i = 1; i <= 3; i++) {
+    CHECK(nextEvent(scanner, INPUT_STEP_FINE, INPUT_EVENT_REPEAT, event));
+    CHECK_EQUAL(STEP_BUTTON_LONG_PRESS_MS + i * STEP_BUTTON_REPEAT_DELAY_MS, event.duration);
+  }
+  CHECK(!scanner.read(event));
+}
+
+TEST(repeat_continues_after_hold_time_saturates) {
+  InputScanner scanner;
+  scanner.begin();
+  InputEvent event;
+  hal::setInput(STEP_FINE_ADJUST_BUTTON_PIN, LOW);
+  ticks(4 * INPUT_DEBOUNCE_SAMPLE_MS);
+  scanner.clearEvents();
+
+  // Понад 65 с утримання: кожні 100 мс - автоповтор, тривалість насичується
+  uint32_t repeats = 0;
+  for (uint32_t ms = 0; ms < 70000; ms += STEP_BUTTON_REPEAT_DELAY_MS) {
+    ticks(STEP_BUTTON_REPEAT_DELAY_MS);
+    while (scanner.read(event)) {
+      repeats++;
+    }
+  }
+  CHECK_EQUAL((70000 - STEP_BUTTON_LONG_PRESS_MS) / STEP_BUTTON_REPEAT_DELAY_MS + 1, repeats);
+  CHECK_EQUAL(INPUT_EVENT_REPEAT, event.type);
+  CHECK_EQUAL(0xFFFE, event.duration);
+}
+
+TEST(button_held_at_boot_gives_no_press) {
+  hal::setInput(ENC_BTN, LOW);
+  InputScanner scanner;
+  scanner.begin();
+  InputEvent event;
+  CHECK(scanner.isHeld(INPUT_ENCODER_BUTTON));
+  ticks(LONG_PRESS_THRESHOLD_MS * 2);
+  CHECK(!scanner.read(event));  // Ні PRESS, ні LONG
+
+  // Відпускання не виглядає як коротке натискання
+  hal::setInput(ENC_BTN, HIGH);
+  ticks(4 * INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(nextEvent(scanner, INPUT_ENCODER_BUTTON, INPUT_EVENT_RELEASE, event));
+  CHECK(event.duration >= LONG_PRESS_THRESHOLD_MS);
+
+  // Наступне натискання - звичайне
+  hal::setInput(ENC_BTN, LOW);
+  ticks(4 * INPUT_DEBOUNCE_SAMPLE_MS);
+  CHECK(nextEvent(scanner, INPUT_ENCODER_BUTTON, INPUT_EVENT_PRESS, event));
+}
+
+TEST(queue_overflow_drops_new_events) {
+  InputScanner scanner;
+  scanner.begin();
+  InputEvent event;
+  // 10 натискань і відпускань = 20 подій, у черзі місце для 15
+  for (uint8_t i = 0; i < 10; i++) {
+    hal::setInput(DIGIT_MODE_BUTTON_PIN, LOW);
+    ticks(4 * INPUT_DEBOUNCE_SAMPLE_MS);
+    hal::setInput(DIGIT_MODE_BUTTON_PIN, HIGH);
+    ticks(4 * INPUT_DEBOUNCE_SAMPLE_MS);
+  }
+  CHECK_EQUAL(5, scanner.getOverflowCount());
+  uint8_t count = 0;
+  while (scanner.read(event)) {
+    CHECK_EQUAL((count & 1) ? INPUT_EVENT_RELEASE : INPUT_EVENT_PRESS, event.type);
+    count++;
+  }
+  CHECK_EQUAL(15, count);
+}
+
+TEST(polling_update_catches_up_ticks) {
+  // Поза AVR такти виконує update() за millis()
+  InputScanner scanner;
+  scanner.begin();
+  InputEvent event;
+  hal::setInput(ENC_BTN, LOW);
+  hal::advanceUs(4 * INPUT_DEBOUNCE_SAMPLE_MS * 1000UL);
+  scanner.update();
+  CHECK(nextEvent(scanner, INPUT_ENCODER_BUTTON, INPUT_EVENT_PRESS, event));
+}
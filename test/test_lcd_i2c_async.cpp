@@ -0,0 +1,206 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "lcd_i2c_async.h"
+
+// Драйвер на моделі TWI (host/twi.h): потік байтів у порт PCF8574 має збігатися з тим,
+// що відправляє блокуюча LiquidCrystal_I2C, - на кожен півбайт дані, дані + E, дані без E
+
+static const uint8_t PIN_RS = 0x01;
+static const uint8_t PIN_EN = 0x04;
+static const uint8_t PIN_BACKLIGHT = 0x08;
+
+// Очікуваний потік: як у LiquidCrystal_I2C::write4bits() з pulseEnable()
+static uint8_t expected[256];
+static uint16_t expectedCount = 0;
+
+static void expectByte(uint8_t value) {
+  expected[expectedCount++] = value;
+}
+
+static void expectNibble(uint8_t nibble) {
+  expectByte(nibble | PIN_BACKLIGHT);
+  expectByte(nibble | PIN_EN | PIN_BACKLIGHT);
+  expectByte(nibble | PIN_BACKLIGHT);
+}
+
+static void expectSend(uint8_t value, uint8_t mode) {
+  expectNibble((value & 0xF0) | mode);
+  expectNibble(((value << 4) & 0xF0) | mode);
+}
+
+static void checkStream(uint16_t from) {
+  CHECK_EQUAL(expectedCount, hal::twiBytes() - from);
+  for (uint16_t i = 0; i < expectedCount && from + i < hal::twiBytes(); i++) {
+    if (hal::twiByte(from + i) != expected[i]) {
+      printf("  byte %u: 0x%02X, expected 0x%02X\n", i, hal::twiByte(from + i), expected[i]);
+      CHECK(false);
+      return;
+    }
+  }
+}
+
+// Час від start до завершення передачі (черга порожня, STOP відправлено)
+static unsigned long drain(LcdI2cAsync& lcd, unsigned long start) {
+  for (uint16_t i = 0; i < 20000 && !lcd.isIdle(); i++) {
+    hal::advanceUs(1);
+  }
+  unsigned long elapsed = micros() - start;
+  hal::advanceUs(100);
+  return elapsed;
+}
+
+TEST(begin_sends_library_init_sequence) {
+  LcdI2cAsync lcd(LCD_I2C_ADDRESS, 20, 4);
+  lcd.begin(20, 4);
+  CHECK(lcd.isReady());
+  CHECK_EQUAL(0, lcd.getErrorCount());
+  CHECK_EQUAL(LCD_I2C_CLOCK_HZ, hal::twiClockHz());
+
+  expectedCount = 0;
+  expectByte(PIN_BACKLIGHT);
+  expectNibble(0x30);
+  expectNibble(0x30);
+  expectNibble(0x30);
+  expectNibble(0x20);
+  expectSend(0x28, 0);  // 4 біти, 2 рядки
+  expectSend(0x0C, 0);
+  expectSend(0x01, 0);
+  expectSend(0x06, 0);
+  expectSend(0x02, 0);
+  checkStream(0);
+}
+
+TEST(text_run_matches_library_stream_in_one_transfer) {
+  LcdI2cAsync lcd(LCD_I2C_ADDRESS, 20, 4);
+  lcd.begin(20, 4);
+  uint16_t from = hal::twiBytes();
+  uint16_t transactions = hal::twiTransactions();
+
+  lcd.setCursor(3, 1);
+  lcd.print("Hi!");
+  // Виклики лише ставлять байти в чергу: нічого ще не відправлено
+  CHECK_EQUAL(from, hal::twiBytes());
+  CHECK_EQUAL(4 * LcdI2cAsync::QUEUE_BYTES_PER_SEND, lcd.getQueueDepth());
+  drain(lcd, micros());
+
+  expectedCount = 0;
+  expectSend(0x80 | (0x40 + 3), 0);
+  expectSend('H', PIN_RS);
+  expectSend('i', PIN_RS);
+  expectSend('!', PIN_RS);
+  checkStream(from);
+  // Уся серія - одна транзакція: адреса модуля відправляється один раз
+  CHECK_EQUAL(transactions + 1, hal::twiTransactions());
+}
+
+TEST(queue_depth_and_throughput_follow_bus_clock) {
+  LcdI2cAsync lcd(LCD_I2C_ADDRESS, 20, 4);
+  lcd.begin(20, 4);
+  const uint8_t chars = 10;  // 60 байтів - вміщається в чергу без очікування
+
+  unsigned long start = micros();
+  lcd.print("0123456789");
+  CHECK_EQUAL(chars * LcdI2cAsync::QUEUE_BYTES_PER_SEND, lcd.getQueueDepth());
+  CHECK_EQUAL(3, lcd.getQueueFree());
+  // 100 кГц: START, адреса і 60 байтів по 9 біт - 5.5 мс, ~1800 символів за секунду
+  unsigned long slowUs = drain(lcd, start);
+  CHECK(slowUs >= 5500 && slowUs <= 5600);
+  CHECK_EQUAL(0, lcd.getQueueDepth());
+
+  lcd.setClock(LCD_I2C_FAST_CLOCK_HZ);
+  CHECK_EQUAL(LCD_I2C_FAST_CLOCK_HZ, hal::twiClockHz());
+  start = micros();
+  lcd.print("0123456789");
+  unsigned long fastUs = drain(lcd, start);
+  // 400 кГц - учетверо швидше (байт - 23 мкс з округленням), ~7000 символів за секунду
+  CHECK(fastUs >= 1400 && fastUs <= 1450);
+  CHECK(chars * 1000000UL / fastUs > 6900);
+}
+
+TEST(missing_module_requests_reinitialisation) {
+  LcdI2cAsync lcd(LCD_I2C_ADDRESS, 20, 4);
+  lcd.begin(20, 4);
+  hal::twiSetResponding(false);
+  lcd.print('x');
+  drain(lcd, micros());
+  CHECK_EQUAL(1, lcd.getErrorCount());
+  CHECK(!lcd.isReady());
+  CHECK_EQUAL(0, lcd.print('y'));  // Поки дисплей не ініціалізовано, дані відкидаються
+
+  hal::twiSetResponding(true);
+  uint16_t from = hal::twiBytes();
+  bool done = false;
+  for (uint16_t i = 0; i < 200 && !done; i++) {
+    done = lcd.update();
+    hal::advanceUs(1000);
+  }
+  CHECK(done);
+  CHECK(lcd.isReady());
+  CHECK_EQUAL(43, hal::twiBytes() - from);  // Повна ініціалізація, як у begin()
+}
+
+TEST(begin_returns_when_module_missing) {
+  hal::twiSetResponding(false);
+  LcdI2cAsync lcd(LCD_I2C_ADDRESS, 20, 4);
+  lcd.begin(20, 4);
+  CHECK(!lcd.isReady());
+  CHECK_EQUAL(1, lcd.getErrorCount());
+  CHECK(!lcd.probe());
+}
+
+TEST(hung_bus_times_out_instead_of_blocking) {
+  LcdI2cAsync lcd(LCD_I2C_ADDRESS, 20, 4);
+  lcd.begin(20, 4);
+
+  // Очікування спорожнення черги (clear) обмежене IDLE_TIMEOUT_US
+  hal::twiSetStuck(true);
+  unsigned long start = micros();
+  lcd.clear();
+  unsigned long elapsed = micros() - start;
+  CHECK(elapsed > 10000 && elapsed < 15000);
+  CHECK_EQUAL(1, lcd.getErrorCount());
+  CHECK(!lcd.isReady());
+  CHECK(lcd.isIdle());
+  CHECK_EQUAL(0, lcd.getQueueDepth());
+}
+
+TEST(hung_stop_times_out) {
+  LcdI2cAsync lcd(LCD_I2C_ADDRESS, 20, 4);
+  lcd.begin(20, 4);
+  lcd.print('a');
+  // Останній байт відправлено, STOP ще формується - і шина зависає
+  for (uint16_t i = 0; i < 1000 && !lcd.isIdle(); i++) {
+    hal::advanceUs(1);
+  }
+  hal::twiSetStuck(true);
+
+  unsigned long start = micros();
+  lcd.print('b');
+  unsigned long elapsed = micros() - start;
+  CHECK(elapsed > 1000 && elapsed < 1500);
+  CHECK_EQUAL(1, lcd.getErrorCount());
+  CHECK(!lcd.isReady());
+
+  // Після звільнення шини дисплей ініціалізується заново
+  hal::twiSetStuck(false);
+  bool done = false;
+  for (uint16_t i = 0; i < 200 && !done; i++) {
+    done = lcd.update();
+    hal::advanceUs(1000);
+  }
+  CHECK(done);
+}
+
+TEST(full_queue_wait_times_out) {
+  LcdI2cAsync lcd(LCD_I2C_ADDRESS, 20, 4);
+  lcd.begin(20, 4);
+  hal::twiSetStuck(true);
+  // 11 символів - 66 байтів, більше за чергу: запис чекає на місце, але не довше BUS_TIMEOUT_US
+  unsigned long start = micros();
+  lcd.print("0123456789A");
+  unsigned long elapsed = micros() - start;
+  CHECK(elapsed > 1000 && elapsed < 1500);
+  CHECK_EQUAL(1, lcd.getErrorCount());
+  CHECK(!lcd.isReady());
+}
@@ -0,0 +1,34 @@
+#include "test.h"
+#include "hal.h"
+
+static TestCase* firstCase = nullptr;
+static TestCase* lastCase = nullptr;
+int testFailures = 0;
+
+TestCase::TestCase(const char* testName, void (*testFunction)())
+  : name(testName), function(testFunction), next(nullptr) {
+  // Порядок запуску - як у файлі
+  if (lastCase) {
+    lastCase->next = this;
+  } else {
+    firstCase = this;
+  }
+  lastCase = this;
+}
+
+int main() {
+  int failed = 0;
+  int total = 0;
+  for (TestCase* test = firstCase; test; test = test->next) {
+    hal::reset();
+    testFailures = 0;
+    test->function();
+    total++;
+    if (testFailures) {
+      printf("FAIL %s\n", test->name);
+      failed++;
+    }
+  }
+  printf("%d/%d passed\n", total - failed, total);
+  return failed;
+}
@@ -0,0 +1,396 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "memory.h"
+
+// Журнал налаштувань у EEPROM: слоти по 64 байти з адреси 64, запис - версія, довжина TLV,
+// порядковий номер, поля TLV, CRC16. Поза AVR фоновий запис - один байт за update()
+
+static const uint16_t JOURNAL_ADDRESS = 64;
+static const uint8_t SLOT_SIZE = 64;
+static const uint8_t SLOT_COUNT = (EEPROMClass::SIZE - JOURNAL_ADDRESS) / SLOT_SIZE;
+
+static Settings saveAndFlush(int32_t position) {
+  Memory memory(MIN_POS, MAX_POS);
+  Settings settings;
+  memory.loadSettings(settings);
+  settings.position = position;
+  memory.saveSettings(settings);
+  memory.flush();
+  return settings;
+}
+
+static int32_t loadPosition() {
+  Memory memory(MIN_POS, MAX_POS);
+  Settings settings;
+  memory.loadSettings(settings);
+  return settings.position;
+}
+
+static uint8_t usedSlots() {
+  uint8_t used = 0;
+  for (uint8_t slot = 0; slot < SLOT_COUNT; slot++) {
+    if (EEPROM.read(JOURNAL_ADDRESS + slot * SLOT_SIZE) != 0xFF) {
+      used++;
+    }
+  }
+  return used;
+}
+
+TEST(settings_survive_reload) {
+  Memory memory(MIN_POS, MAX_POS);
+  Settings settings;
+  memory.loadSettings(settings);
+  CHECK_EQUAL(0, settings.position);
+  settings.position = 1234;
+  settings.direction = 1;
+  settings.stepperZero = 55;
+  memory.saveSettings(settings);
+  memory.flush();
+  CHECK(memory.isPersisted());
+
+  Memory restored(MIN_POS, MAX_POS);
+  Settings loaded;
+  restored.loadSettings(loaded);
+  CHECK_EQUAL(1234, loaded.position);
+  CHECK_EQUAL(1, loaded.direction);
+  CHECK_EQUAL(55, loaded.stepperZero);
+}
+
+TEST(save_is_written_in_background) {
+  Memory memory(MIN_POS, MAX_POS);
+  Settings settings;
+  memory.loadSettings(settings);
+  settings.position = 800;
+  memory.saveSettings(settings);
+  CHECK_EQUAL(0, EEPROM.writeCount());  // saveSettings() тільки кешує
+  CHECK(!memory.isPersisted());
+
+  uint16_t passes = 0;
+  uint32_t writes = 0;
+  while (!memory.isPersisted() && passes < 100) {
+    memory.update();
+    CHECK(EEPROM.writeCount() - writes <= 1);  // Не більше байта за прохід
+    writes = EEPROM.writeCount();
+    passes++;
+  }
+  CHECK(memory.isPersisted());
+  CHECK_EQUAL(800, loadPosition());
+}
+
+TEST(saves_before_write_coalesce) {
+  Memory memory(MIN_POS, MAX_POS);
+  Settings settings;
+  memory.loadSettings(settings);
+  for (int32_t position = 1; position <= 10; position++) {
+    settings.position = position;
+    memory.saveSettings(settings);
+  }
+  memory.flush();
+  CHECK_EQUAL(1, usedSlots());
+  CHECK_EQUAL(10, loadPosition());
+}
+
+TEST(unchanged_settings_are_not_written) {
+  saveAndFlush(100);
+  uint32_t writes = EEPROM.writeCount();
+  saveAndFlush(100);
+  CHECK_EQUAL(writes, EEPROM.writeCount());
+  CHECK_EQUAL(1, usedSlots());
+}
+
+TEST(records_rotate_through_slots) {
+  // Кожне збереження - у наступний слот по колу: знос розподіляється на всі слоти
+  for (uint8_t i = 1; i <= SLOT_COUNT; i++) {
+    saveAndFlush(i * 10);
+    CHECK_EQUAL(i, usedSlots());
+    CHECK_EQUAL(i * 10, loadPosition());
+  }
+  // Далі - знову з першого слота, найновіший запис знаходиться за порядковим номером
+  saveAndFlush(2000);
+  CHECK_EQUAL(2000, loadPosition());
+  saveAndFlush(2100);
+  CHECK_EQUAL(2100, loadPosition());
+}
+
+TEST(corrupted_newest_record_falls_back) {
+  saveAndFlush(100);
+  saveAndFlush(200);
+  saveAndFlush(300);  // Слот 2
+  uint16_t newest = JOURNAL_ADDRESS + 2 * SLOT_SIZE;
+  EEPROM.write(newest + 6, EEPROM.read(newest + 6) ^ 0x01);  // Байт позиції в TLV
+  CHECK_EQUAL(200, loadPosition());
+
+  // Наступне збереження йде після останнього правильного запису
+  saveAndFlush(400);
+  CHECK_EQUAL(400, loadPosition());
+}
+
+TEST(interrupted_write_keeps_previous_record) {
+  saveAndFlush(100);
+  Memory memory(MIN_POS, MAX_POS);
+  Settings settings;
+  memory.loadSettings(settings);
+  settings.position = 3000;
+  memory.saveSettings(settings);
+  for (uint8_t i = 0; i < 6; i++) {
+    memory.update();  // Живлення зникає посеред запису
+  }
+  CHECK(!memory.isPersisted());
+  CHECK_EQUAL(100, loadPosition());
+}
+
+/* ================== ФОРМАТ ЗАПИСУ (TLV, CRC16) ================== */
+
+TEST(crc16_ccitt_check_value) {
+  // Контрольне значення CRC-16/CCITT-FALSE (поліном 0x1021, початкове 0xFFFF)
+  const char* check = "123456789";
+  CHECK_EQUAL(0x29B1, Memory::calculateCrc((const uint8_t*)check, 9));
+  CHECK_EQUAL(0xFFFF, Memory::calculateCrc((const uint8_t*)check, 0));
+}
+
+TEST(record_holds_only_state_and_overridden_fields) {
+  // Стан - завжди (позиція 4 + напрямок 1 + нуль 4 байти, кожне поле з тегом і розміром),
+  // параметри - тільки з бітом overridden
+  Memory memory(MIN_POS, MAX_POS);
+  Settings settings;
+  memory.loadSettings(settings);
+  settings.position = 1;
+  settings.maxSpeedSps = 1234;  // Без біта - не записується
+  memory.saveSettings(settings);
+  memory.flush();
+  CHECK_EQUAL(2, EEPROM.read(JOURNAL_ADDRESS));  // Версія запису
+  CHECK_EQUAL(15, EEPROM.read(JOURNAL_ADDRESS + 1));
+
+  Memory restored(MIN_POS, MAX_POS);
+  Settings loaded;
+  restored.loadSettings(loaded);
+  CHECK_EQUAL(STEPPER_MAX_SPEED_SPS, loaded.maxSpeedSps);
+  CHECK_EQUAL(0, loaded.overridden);
+}
+
+TEST(overridden_fields_round_trip) {
+  Memory memory(MIN_POS, MAX_POS);
+  Settings settings;
+  memory.loadSettings(settings);
+  settings.maxSpeedSps = 1234;
+  settings.kpPercent = 55;
+  settings.longPressMs = 1500;
+  settings.overridden = SETTING_MAX_SPEED | SETTING_KP | SETTING_LONG_PRESS;
+  memory.saveSettings(settings);
+  memory.flush();
+  CHECK_EQUAL(15 + 4 + 3 + 4, EEPROM.read(JOURNAL_ADDRESS + 1));
+
+  Memory restored(MIN_POS, MAX_POS);
+  Settings loaded;
+  restored.loadSettings(loaded);
+  CHECK_EQUAL(1234, loaded.maxSpeedSps);
+  CHECK_EQUAL(55, loaded.kpPercent);
+  CHECK_EQUAL(1500, loaded.longPressMs);
+  CHECK_EQUAL(SETTING_MAX_SPEED | SETTING_KP | SETTING_LONG_PRESS, loaded.overridden);
+  CHECK_EQUAL(STEPPER_ACCEL_SPS2, loaded.accelSps2);  // Не записаний - з config.h
+}
+
+TEST(set_marks_changed_parameter_overridden) {
+  // Зміна з меню або Serial: значення і біт overridden разом, тому воно потрапляє в запис
+  Settings settings;
+  CHECK(settings.set(SETTING_TAG_MAX_SPEED, STEPPER_MAX_SPEED_SPS));  // Те саме значення - біт не потрібен
+  CHECK_EQUAL(0, settings.overridden);
+  CHECK(settings.set(SETTING_TAG_MAX_SPEED, 3000));
+  CHECK_EQUAL(3000, settings.maxSpeedSps);
+  CHECK(settings.set(SETTING_TAG_DEBOUNCE, 2));
+  CHECK_EQUAL(2, settings.debounceSampleMs);
+  CHECK_EQUAL(SETTING_MAX_SPEED | SETTING_DEBOUNCE, settings.overridden);
+  CHECK_EQUAL(3000, settings.get(SETTING_TAG_MAX_SPEED));
+
+  // Стан, невідомий тег і значення поза діапазоном не приймаються
+  CHECK(!settings.set(SETTING_TAG_POSITION, 5));
+  CHECK(!settings.set(0x7F, 5));
+  CHECK(!settings.set(SETTING_TAG_MAX_SPEED, 0));
+  CHECK(!settings.set(SETTING_TAG_FILTER_WINDOW, ABS_ENC_FILTER_WINDOW + 1));
+  CHECK(!settings.set(SETTING_TAG_FILTER_ALPHA, 257));
+  CHECK_EQUAL(3000, settings.maxSpeedSps);
+  CHECK_EQUAL(SETTING_MAX_SPEED | SETTING_DEBOUNCE, settings.overridden);
+}
+
+TEST(all_parameters_fit_one_record) {
+  // Кожен параметр змінено через set(): запис з усіма полями вміщається в слот і читається назад
+  Memory memory(MIN_POS, MAX_POS);
+  Settings settings;
+  memory.loadSettings(settings);
+  CHECK(settings.set(SETTING_TAG_MAX_SPEED, 3000));
+  CHECK(settings.set(SETTING_TAG_ACCEL, 8000));
+  CHECK(settings.set(SETTING_TAG_TOLERANCE, 30));
+  CHECK(settings.set(SETTING_TAG_KP, 70));
+  CHECK(settings.set(SETTING_TAG_KI, 10));
+  CHECK(settings.set(SETTING_TAG_MAX_CORRECTION, 100));
+  CHECK(settings.set(SETTING_TAG_ENCODER_ACCEL, 5));
+  CHECK(settings.set(SETTING_TAG_LONG_PRESS, 1200));
+  CHECK(settings.set(SETTING_TAG_LCD_UPDATE, 150));
+  CHECK(settings.set(SETTING_TAG_DEBOUNCE, 3));
+  CHECK(settings.set(SETTING_TAG_FILTER_WINDOW, 4));
+  CHECK(settings.set(SETTING_TAG_FILTER_ALPHA, 100));
+  CHECK_EQUAL(0x0FFF, settings.overridden);
+  memory.saveSettings(settings);
+  memory.flush();
+  CHECK_EQUAL(SLOT_SIZE - 4 - 2, EEPROM.read(JOURNAL_ADDRESS + 1));  // 58 байтів TLV - увесь слот
+
+  Memory restored(MIN_POS, MAX_POS);
+  Settings loaded;
+  restored.loadSettings(loaded);
+  CHECK_EQUAL(0x0FFF, loaded.overridden);
+  CHECK_EQUAL(3000, loaded.maxSpeedSps);
+  CHECK_EQUAL(150, loaded.lcdUpdateMs);
+  CHECK_EQUAL(3, loaded.debounceSampleMs);
+  CHECK_EQUAL(4, loaded.filterWindow);
+  CHECK_EQUAL(100, loaded.filterAlpha);
+}
+
+// Запис v2 у слот 0, зібраний вручну (як його записала б інша версія прошивки)
+static void writeRecord(const uint8_t* tlv, uint8_t length, uint16_t sequence) {
+  uint8_t record[SLOT_SIZE];
+  record[0] = 2;
+  record[1] = length;
+  memcpy(record + 2, &sequence, sizeof(sequence));
+  memcpy(record + 4, tlv, length);
+  uint16_t crc = Memory::calculateCrc(record, 4 + length);
+  memcpy(record + 4 + length, &crc, sizeof(crc));
+  for (uint8_t i = 0; i < 4 + length + 2; i++) {
+    EEPROM.write(JOURNAL_ADDRESS + i, record[i]);
+  }
+}
+
+TEST(unknown_and_resized_tags_are_skipped) {
+  // Запис новішої прошивки: невідомий тег 0x7F і тег 0x10 іншого розміру пропускаються
+  const uint8_t tlv[] = {
+    0x7F, 3, 0xAA, 0xBB, 0xCC,
+    0x01, 4, 0x20, 0x03, 0x00, 0x00,  // Позиція 800
+    0x10, 1, 0x05,
+    0x21, 1, 70                       // KP 70%
+  };
+  writeRecord(tlv, sizeof(tlv), 1);
+  Memory memory(MIN_POS, MAX_POS);
+  Settings loaded;
+  memory.loadSettings(loaded);
+  CHECK_EQUAL(800, loaded.position);
+  CHECK_EQUAL(70, loaded.kpPercent);
+  CHECK_EQUAL(STEPPER_MAX_SPEED_SPS, loaded.maxSpeedSps);
+  CHECK_EQUAL(SETTING_KP, loaded.overridden);
+}
+
+TEST(zero_parameters_fall_back_to_config) {
+  const uint8_t tlv[] = {
+    0x10, 2, 0x00, 0x00,  // Швидкість 0 - пошкоджене значення
+    0x31, 2, 0x00, 0x00,  // Довге натискання 0
+    0x40, 1, ABS_ENC_FILTER_WINDOW + 1  // Вікно більше за буфер фільтра
+  };
+  writeRecord(tlv, sizeof(tlv), 1);
+  Memory memory(MIN_POS, MAX_POS);
+  Settings loaded;
+  memory.loadSettings(loaded);
+  CHECK_EQUAL(STEPPER_MAX_SPEED_SPS, loaded.maxSpeedSps);
+  CHECK_EQUAL(LONG_PRESS_THRESHOLD_MS, loaded.longPressMs);
+  CHECK_EQUAL(ABS_ENC_FILTER_WINDOW, loaded.filterWindow);
+  CHECK_EQUAL(0, loaded.overridden);
+}
+
+TEST(old_layout_is_migrated) {
+  // Старий формат: SettingsData за адресою 0 з XOR-сумою, журналу ще немає
+  SettingsData old;
+  old.position = 1600;
+  old.direction = 1;
+  old.stepperZero = 32;
+  old.checksum = 0;
+  const uint8_t* bytes = (const uint8_t*)&old.position;
+  for (uint8_t i = 0; i < 4; i++) old.checksum ^= bytes[i];
+  old.checksum ^= old.direction;
+  bytes = (const uint8_t*)&old.stepperZero;
+  for (uint8_t i = 0; i < 4; i++) old.checksum ^= bytes[i];
+  EEPROM.put(0, old);
+
+  Memory memory(MIN_POS, MAX_POS);
+  Settings loaded;
+  memory.loadSettings(loaded);
+  CHECK_EQUAL(1600, loaded.position);
+  CHECK_EQUAL(1, loaded.direction);
+  CHECK_EQUAL(32, loaded.stepperZero);
+
+  // Перше збереження переносить налаштування в журнал
+  loaded.position = 1700;
+  memory.saveSettings(loaded);
+  memory.flush();
+  CHECK_EQUAL(2, EEPROM.read(JOURNAL_ADDRESS));
+  Memory restored(MIN_POS, MAX_POS);
+  restored.loadSettings(loaded);
+  CHECK_EQUAL(1700, loaded.position);
+  CHECK_EQUAL(1, loaded.direction);
+}
+
+TEST(blank_eeprom_gives_defaults) {
+  Memory memory(MIN_POS, MAX_POS);
+  Settings loaded;
+  memory.loadSettings(loaded);
+  CHECK_EQUAL(0, loaded.position);
+  CHECK_EQUAL(0, loaded.direction);
+  CHECK_EQUAL(STEPPER_MAX_SPEED_SPS, loaded.maxSpeedSps);
+}
+
+// Таблиця калібрування з адреси 16: маркер, кількість, таблиця, CRC16 (кількість + таблиця)
+static const uint16_t CALIBRATION_ADDRESS = 16;
+
+TEST(calibration_round_trip_with_crc) {
+  int16_t table[ABS_ENC_CAL_POINTS];
+  for (uint8_t i = 0; i < ABS_ENC_CAL_POINTS; i++) {
+    table[i] = (int16_t)(i * 37 - 300);
+  }
+  Memory memory(MIN_POS, MAX_POS);
+  memory.saveCalibration(table, ABS_ENC_CAL_POINTS);
+
+  int16_t loaded[ABS_ENC_CAL_POINTS];
+  CHECK(memory.loadCalibration(loaded, ABS_ENC_CAL_POINTS));
+  for (uint8_t i = 0; i < ABS_ENC_CAL_POINTS; i++) {
+    CHECK_EQUAL(table[i], loaded[i]);
+  }
+  uint16_t crcAddress = CALIBRATION_ADDRESS + 2 + ABS_ENC_CAL_POINTS * 2;
+  uint8_t block[1 + ABS_ENC_CAL_POINTS * 2];
+  block[0] = ABS_ENC_CAL_POINTS;
+  memcpy(block + 1, table, sizeof(table));
+  uint16_t crc = Memory::calculateCrc(block, sizeof(block));
+  CHECK_EQUAL(crc & 0xFF, EEPROM.read(crcAddress));
+  CHECK_EQUAL(crc >> 8, EEPROM.read(crcAddress + 1));
+  CHECK(!memory.loadCalibration(loaded, ABS_ENC_CAL_POINTS - 1));  // Інша кількість точок
+}
+
+TEST(calibration_detects_swapped_bytes) {
+  // XOR-сума не помічала переставлених байтів; CRC16 помічає
+  int16_t table[ABS_ENC_CAL_POINTS] = { 0 };
+  table[0] = 0x0102;
+  table[1] = 0x0304;
+  Memory memory(MIN_POS, MAX_POS);
+  memory.saveCalibration(table, ABS_ENC_CAL_POINTS);
+  EEPROM.write(CALIBRATION_ADDRESS + 2, 0x03);
+  EEPROM.write(CALIBRATION_ADDRESS + 4, 0x02);
+  int16_t loaded[ABS_ENC_CAL_POINTS];
+  CHECK(!memory.loadCalibration(loaded, ABS_ENC_CAL_POINTS));
+}
+
+TEST(calibration_reads_old_xor_block) {
+  // Таблиця, збережена попередньою прошивкою (маркер 0xCA, XOR байтів таблиці), лишається чинною
+  int16_t table[ABS_ENC_CAL_POINTS];
+  uint8_t sum = 0;
+  for (uint8_t i = 0; i < ABS_ENC_CAL_POINTS; i++) {
+    table[i] = (int16_t)(250 - i * 31);
+    EEPROM.put(CALIBRATION_ADDRESS + 2 + i * 2, table[i]);
+    sum ^= (uint8_t)table[i] ^ (uint8_t)(table[i] >> 8);
+  }
+  EEPROM.write(CALIBRATION_ADDRESS + 2 + ABS_ENC_CAL_POINTS * 2, sum);
+  EEPROM.write(CALIBRATION_ADDRESS + 1, ABS_ENC_CAL_POINTS);
+  EEPROM.write(CALIBRATION_ADDRESS, 0xCA);
+
+  Memory memory(MIN_POS, MAX_POS);
+  int16_t loaded[ABS_ENC_CAL_POINTS];
+  CHECK(memory.loadCalibration(loaded, ABS_ENC_CAL_POINTS));
+  CHECK_EQUAL(table[5], loaded[5]);
+  EEPROM.write(CALIBRATION_ADDRESS + 2, EEPROM.read(CALIBRATION_ADDRESS + 2) ^ 1);
+  CHECK(!memory.loadCalibration(loaded, ABS_ENC_CAL_POINTS));
+}
@@ -0,0 +1,311 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "menu.h"
+#include "encoder.h"
+#include "memory.h"
+
+// Встановлення кута з прискоренням: крок одиниць залежить від швидкості енкодера (клацань/с)
+
+static void enterSetAngle(Menu& menu, uint16_t angle) {
+  menu.setTargetAngle(angle);
+  menu.handleSplashMenu(true, false);  // Головне меню
+  menu.updateNavigation(0, true);  // Перший пункт - Set Angle
+  CHECK(menu.isEditingAngle());
+}
+
+TEST(slow_rotation_steps_by_one) {
+  Menu menu;
+  enterSetAngle(menu, 100);
+  menu.updateNavigation(1, false, 0);
+  CHECK_EQUAL(101, menu.getTargetAngle());
+  menu.updateNavigation(-3, false, ENCODER_ACCEL_SLOW_DPS);
+  CHECK_EQUAL(98, menu.getTargetAngle());
+}
+
+TEST(fast_rotation_multiplies_step) {
+  Menu menu;
+  enterSetAngle(menu, 100);
+  menu.updateNavigation(1, false, ENCODER_ACCEL_FAST_DPS);
+  CHECK_EQUAL(100 + ENCODER_ACCEL_MAX, menu.getTargetAngle());
+  menu.updateNavigation(1, false, 1000);
+  CHECK_EQUAL(100 + 2 * ENCODER_ACCEL_MAX, menu.getTargetAngle());
+
+  // Між SLOW і FAST множник зростає лінійно
+  uint16_t middle = (ENCODER_ACCEL_SLOW_DPS + ENCODER_ACCEL_FAST_DPS) / 2;
+  uint16_t before = menu.getTargetAngle();
+  menu.updateNavigation(1, false, middle);
+  CHECK_EQUAL(before + 1 + (ENCODER_ACCEL_MAX - 1) / 2, menu.getTargetAngle());
+}
+
+TEST(acceleration_wraps_around_circle) {
+  Menu menu;
+  enterSetAngle(menu, 355);
+  menu.updateNavigation(1, false, ENCODER_ACCEL_FAST_DPS);
+  CHECK_EQUAL((355 + ENCODER_ACCEL_MAX) % 360, menu.getTargetAngle());
+  menu.updateNavigation(-1, false, ENCODER_ACCEL_FAST_DPS);
+  CHECK_EQUAL(355, menu.getTargetAngle());
+}
+
+TEST(tens_and_hundreds_ignore_speed) {
+  Menu menu;
+  enterSetAngle(menu, 100);
+  menu.updateDigitMode(true);  // Десятки
+  menu.updateNavigation(1, false, 1000);
+  CHECK_EQUAL(110, menu.getTargetAngle());
+  menu.updateDigitMode(false);
+  menu.updateDigitMode(true);  // Сотні
+  menu.updateNavigation(1, false, 1000);
+  CHECK_EQUAL(210, menu.getTargetAngle());
+}
+
+TEST(acceleration_max_from_settings) {
+  Menu menu;
+  menu.setEncoderAccelerationMax(4);
+  enterSetAngle(menu, 0);
+  menu.updateNavigation(1, false, ENCODER_ACCEL_FAST_DPS);
+  CHECK_EQUAL(4, menu.getTargetAngle());
+}
+
+TEST(tuning_value_sets_override_bit) {
+  Settings settings;
+  Menu menu;
+  menu.setSettings(&settings);
+  menu.handleSplashMenu(true, false);
+  for (uint8_t i = 0; i < 2; i++) {
+    hal::advanceUs(200000UL);  // Список перемикається не частіше за раз на 150 мс
+    menu.updateNavigation(1, false);
+  }
+  menu.updateNavigation(0, true);  // Tuning
+  menu.updateNavigation(0, true);  // Max Speed
+  CHECK_EQUAL(STEPPER_MAX_SPEED_SPS, menu.getCurrentValue());
+
+  menu.updateNavigation(2, false, 0);
+  CHECK_EQUAL(STEPPER_MAX_SPEED_SPS + 100, settings.maxSpeedSps);
+  CHECK_EQUAL(SETTING_MAX_SPEED, settings.overridden);
+  CHECK(menu.shouldApplySettings());
+  CHECK(!menu.shouldSaveSettings());  // Зберігається при виході з меню
+
+  menu.updateNavigation(0, true);
+  CHECK(menu.getCurrentNode() == nullptr);
+  CHECK(menu.shouldSaveSettings());
+}
+
+/* ================== ДЕРЕВО МЕНЮ У FLASH ================== */
+// Обхід усього дерева від кореня: кожне поле читається через pgm_read_* (на ПК - звичайне читання),
+// кожен вузол досяжний рівно один раз, а Menu з батьківського списку входить саме у вузол з масиву
+// children (сусідні пункти - крок енкодера). Розміри рахуються як на AVR: вказівник - 2 байти
+
+static const uint8_t AVR_POINTER_SIZE = 2;
+static const uint8_t AVR_MENU_NODE_SIZE = 4 * sizeof(uint8_t) + 4 * AVR_POINTER_SIZE + sizeof(uint8_t)
+                                          + 3 * sizeof(uint16_t) + sizeof(uint8_t);
+
+struct TreeWalk {
+  const MenuNode* nodes[32];
+  uint8_t nodeCount;
+  uint8_t linkCount;  // Елементи масивів children і options
+  const char* texts[64];
+  uint8_t textCount;
+  uint16_t textBytes;  // Рядки з нулем у кінці, кожен масив - один раз
+  uint8_t path[8];  // Номери пунктів від кореня до поточного вузла
+  uint8_t depth;
+};
+
+static void countText(TreeWalk& walk, const char* text) {
+  if (!text) return;
+  for (uint8_t i = 0; i < walk.textCount; i++) {
+    if (walk.texts[i] == text) return;
+  }
+  walk.texts[walk.textCount++] = text;
+  walk.textBytes += strlen_P(text) + 1;
+}
+
+// Вхід у вузол за шляхом, як це робить користувач: сплеш -> головне меню -> клацання і кнопка
+static const MenuNode* enterPath(const uint8_t* path, uint8_t depth) {
+  Menu menu;
+  menu.handleSplashMenu(true, false);
+  for (uint8_t level = 0; level < depth; level++) {
+    for (uint8_t i = 0; i < path[level]; i++) {
+      hal::advanceUs(200000UL);  // Список перемикається не частіше за раз на 150 мс
+      menu.updateNavigation(1, false);
+    }
+    CHECK_EQUAL(path[level], menu.getCurrentItem());
+    menu.updateNavigation(0, true);
+  }
+  return menu.getCurrentNode();
+}
+
+static void walkNode(TreeWalk& walk, const MenuNode* node) {
+  for (uint8_t i = 0; i < walk.nodeCount; i++) {
+    CHECK(walk.nodes[i] != node);  // Дерево: жоден вузол не має двох батьків
+  }
+  walk.nodes[walk.nodeCount++] = node;
+  CHECK(enterPath(walk.path, walk.depth) == node);
+
+  MenuNode current;
+  readMenuNode(node, current);
+  CHECK_EQUAL(current.type, pgm_read_byte(&node->type));
+  CHECK_EQUAL(current.valueId, pgm_read_byte(&node->valueId));
+  CHECK_EQUAL(current.itemCount, pgm_read_byte(&node->itemCount));
+  CHECK(current.label == (const char*)pgm_read_ptr(&node->label));
+  CHECK(current.children == (const MenuNode* const*)pgm_read_ptr(&node->children));
+  CHECK(current.label != nullptr);
+  countText(walk, current.label);
+  countText(walk, current.title);
+
+  switch (current.type) {
+    case MENU_NODE_LIST:
+      CHECK(current.children != nullptr && current.options == nullptr);
+      CHECK(current.itemCount > 0);
+      walk.linkCount += current.itemCount;
+      for (uint8_t item = 0; item < current.itemCount; item++) {
+        const MenuNode* child = readMenuChild(current, item);
+        CHECK(child != nullptr);
+        if (!child) continue;
+        walk.path[walk.depth++] = item;
+        walkNode(walk, child);
+        walk.depth--;
+      }
+      break;
+    case MENU_NODE_VALUE:
+      CHECK(current.valueId != MENU_VALUE_NONE);
+      CHECK(current.minValue <= current.maxValue && current.step > 0);
+      CHECK(current.valueId != MENU_VALUE_SETTING || current.setting != 0);
+      break;
+    case MENU_NODE_CHOICE:
+      CHECK(current.valueId != MENU_VALUE_NONE && current.options != nullptr);
+      CHECK(current.itemCount > 0);
+      walk.linkCount += current.itemCount;
+      for (uint8_t option = 0; option < current.itemCount; option++) {
+        CHECK(readMenuOption(current, option) != nullptr);
+        countText(walk, readMenuOption(current, option));
+      }
+      break;
+    case MENU_NODE_CONFIRM:
+      CHECK(current.children == nullptr && current.options == nullptr);
+      break;
+    default:
+      CHECK(false);
+  }
+}
+
+TEST(menu_tree_walks_from_flash) {
+  Menu menu;
+  menu.handleSplashMenu(true, false);
+  TreeWalk walk;
+  memset(&walk, 0, sizeof(walk));
+  walkNode(walk, menu.getCurrentNode());
+
+  // Усе дерево - у flash: SRAM займає лише копія одного вузла на час обробки
+  uint16_t flashBytes = walk.nodeCount * AVR_MENU_NODE_SIZE + walk.linkCount * AVR_POINTER_SIZE + walk.textBytes;
+  // Зараз (медіанний фільтр, без пункту Filter): 8 вузлів по 20 байтів, 9 вказівників, 115 байтів рядків - 293 байти
+  if (flashBytes >= 512) {
+    printf("  %u nodes, %u links, %u text bytes: %u bytes flash\n",
+           walk.nodeCount, walk.linkCount, walk.textBytes, flashBytes);
+  }
+  CHECK_EQUAL(20, AVR_MENU_NODE_SIZE);
+  CHECK(walk.nodeCount >= 8);
+  CHECK(flashBytes < 512);
+}
+
+// Оператор з енкодером: клацання з заданим інтервалом, опитування кожні TASK_INPUT_PERIOD_MS, як у taskInput().
+// Поки до цілі далеко, енкодер крутять швидко, на останніх градусах - повільно, а проскочене
+// повертають назад. Кут змінюється на 1 градус, тому повне коло - 0 -> 359 вперед
+static_assert(ENCODER_STEPS_PER_DETENT == 4, "detent sequence below is for 4 transitions per detent");
+
+static const unsigned long DIAL_FAST_INTERVAL_MS = 25;   // 40 клацань/с - швидке прокручування пальцем
+static const unsigned long DIAL_SLOW_INTERVAL_MS = 300;  // ~3 клацання/с - точне доведення
+static const int16_t DIAL_SLOW_ZONE = 15;  // Градусів до цілі, з яких оператор крутить повільно
+
+static void detent(int8_t direction) {
+  if (direction > 0) {
+    hal::setInput(ENC_B, LOW);
+    hal::setInput(ENC_A, LOW);
+    hal::setInput(ENC_B, HIGH);
+    hal::setInput(ENC_A, HIGH);
+  } else {
+    hal::setInput(ENC_A, LOW);
+    hal::setInput(ENC_B, LOW);
+    hal::setInput(ENC_A, HIGH);
+    hal::setInput(ENC_B, HIGH);
+  }
+}
+
+struct DialResult {
+  uint16_t detents;
+  unsigned long ms;
+  bool reached;
+};
+
+// Прокручування вперед на distance градусів від поточного кута
+static DialResult dial(Menu& menu, Encoder& encoder, int16_t distance) {
+  DialResult result = {0, 0, false};
+  int16_t travelled = 0;  // Пройдено вперед з урахуванням переходу через 0
+  uint16_t angle = menu.getTargetAngle();
+  unsigned long start = millis();
+  unsigned long nextDetent = start;
+  while (result.detents < 400) {
+    if (travelled == distance && encoder.getDelta() == 0) {
+      result.reached = true;
+      break;
+    }
+    if (millis() >= nextDetent) {
+      int16_t remaining = distance - travelled;
+      detent(remaining > 0 ? 1 : -1);
+      result.detents++;
+      bool slow = remaining <= DIAL_SLOW_ZONE && remaining >= -DIAL_SLOW_ZONE;
+      nextDetent = millis() + (slow ? DIAL_SLOW_INTERVAL_MS : DIAL_FAST_INTERVAL_MS);
+    }
+    hal::advanceUs(TASK_INPUT_PERIOD_MS * 1000UL);
+    menu.updateNavigation(encoder.read(), false, encoder.getSpeed());
+    int16_t step = (int16_t)menu.getTargetAngle() - (int16_t)angle;
+    if (step > 180) step -= 360;
+    if (step < -180) step += 360;
+    travelled += step;
+    angle = menu.getTargetAngle();
+  }
+  result.ms = millis() - start;
+  return result;
+}
+
+TEST(full_circle_dialled_at_hand_speed) {
+  Encoder encoder(ENC_A, ENC_B);
+  encoder.begin();
+  Menu menu;
+  enterSetAngle(menu, 0);
+  hal::advanceUs(1000000);
+
+  // Без прискорення 0 -> 359 - це 359 клацань; з прискоренням - не більше 45 клацань і 2 с
+  DialResult result = dial(menu, encoder, 359);
+  if (!result.reached || result.detents > 45 || result.ms > 2000) {
+    printf("  0 -> 359: %u detents, %lu ms\n", result.detents, result.ms);
+  }
+  CHECK(result.reached);
+  CHECK_EQUAL(359, menu.getTargetAngle());
+  CHECK(result.detents <= 45);
+  CHECK(result.ms <= 2000);
+}
+
+TEST(any_angle_dialled_within_bound) {
+  // Від 0 до кожної цілі через 10 градусів: не більше 45 клацань і 3 с у найгіршому випадку
+  uint16_t worstDetents = 0;
+  unsigned long worstMs = 0;
+  for (uint16_t target = 10; target < 360; target += 10) {
+    hal::reset();
+    Encoder encoder(ENC_A, ENC_B);
+    encoder.begin();
+    Menu menu;
+    enterSetAngle(menu, 0);
+    hal::advanceUs(1000000);
+    DialResult result = dial(menu, encoder, target);
+    CHECK(result.reached);
+    CHECK_EQUAL(target, menu.getTargetAngle());
+    if (result.detents > worstDetents) worstDetents = result.detents;
+    if (result.ms > worstMs) worstMs = result.ms;
+  }
+  if (worstDetents > 45 || worstMs > 3000) {
+    printf("  worst: %u detents, %lu ms\n", worstDetents, worstMs);
+  }
+  CHECK(worstDetents <= 45);
+  CHECK(worstMs <= 3000);
+}
@@ -0,0 +1,116 @@
+#include "test.h"
+#include "motion_planner.h"
+
+// Профіль руху: інтервали між кроками для відстані steps, сумарний час і найкоротший інтервал
+
+struct Profile {
+  uint32_t totalTicks;
+  uint16_t first;
+  uint16_t last;
+  uint16_t shortest;
+  bool accelerationMonotonic;  // На розгоні інтервали не зростають
+  bool decelerationMonotonic;  // На гальмуванні інтервали не зменшуються
+};
+
+static Profile runProfile(MotionPlanner& planner, uint32_t steps) {
+  Profile profile = { 0, 0, 0, 0xFFFF, true, true };
+  planner.reset();
+  uint16_t previous = 0;
+  bool braking = false;
+  for (uint32_t left = steps; left > 0; left--) {
+    uint16_t interval = planner.nextInterval(left);
+    if (left == steps) {
+      profile.first = interval;
+    } else if (interval > previous) {
+      braking = true;
+    } else if (braking && interval < previous) {
+      profile.decelerationMonotonic = false;
+    }
+    if (!braking && previous != 0 && interval > previous) {
+      profile.accelerationMonotonic = false;
+    }
+    if (interval < profile.shortest) {
+      profile.shortest = interval;
+    }
+    profile.totalTicks += interval;
+    profile.last = interval;
+    previous = interval;
+  }
+  return profile;
+}
+
+TEST(first_interval_from_acceleration) {
+  // c0 = 0.676 * f * sqrt(2 / a): 10000 кроків/с² при 1 МГц - ~9560 мкс
+  MotionPlanner planner(1000000UL);
+  planner.configure(2500, 10000);
+  planner.reset();
+  uint16_t first = planner.nextInterval(1000);
+  CHECK(first > 9400 && first < 9700);
+}
+
+TEST(long_move_is_trapezoid) {
+  // 3200 кроків, 2500 кроків/с, 10000 кроків/с²: t = d / v + v / a = 1.53 с
+  MotionPlanner planner(1000000UL);
+  planner.configure(2500, 10000);
+  Profile profile = runProfile(planner, 3200);
+  CHECK_EQUAL(400, profile.shortest);  // Рівно максимальна швидкість
+  CHECK(profile.accelerationMonotonic);
+  CHECK(profile.decelerationMonotonic);
+  CHECK(profile.totalTicks > 1530000UL * 97 / 100 && profile.totalTicks < 1530000UL * 103 / 100);
+  CHECK(profile.last * 10 > profile.first * 7);  // Гальмування закінчується біля швидкості старту
+}
+
+TEST(short_move_is_triangle) {
+  // 100 кроків не вистачає для розгону до 2500: пік sqrt(a * d) = 1000 кроків/с, t = 2 * sqrt(d / a) = 0.2 с
+  MotionPlanner planner(1000000UL);
+  planner.configure(2500, 10000);
+  Profile profile = runProfile(planner, 100);
+  CHECK(profile.shortest > 900 && profile.shortest < 1100);
+  // Дискретна рампа з гальмуванням за кількістю інтервалів трохи коротша за неперервну
+  CHECK(profile.totalTicks > 200000UL * 85 / 100 && profile.totalTicks < 200000UL * 105 / 100);
+}
+
+TEST(ramp_length_matches_stopping_distance) {
+  // На крейсерській швидкості рампа - v² / (2a) = 312 кроків
+  MotionPlanner planner(1000000UL);
+  planner.configure(2500, 10000);
+  planner.reset();
+  for (uint16_t i = 0; i < 1000; i++) {
+    planner.nextInterval(5000);
+  }
+  CHECK(planner.getRampSteps() > 300 && planner.getRampSteps() < 325);
+}
+
+TEST(timer_ticks_scale_intervals) {
+  // Timer1 з дільником 8 (2 МГц): ті самі інтервали в тіках удвічі довші
+  MotionPlanner micro(1000000UL);
+  MotionPlanner timer(2000000UL);
+  micro.configure(2500, 10000);
+  timer.configure(2500, 10000);
+  Profile a = runProfile(micro, 800);
+  Profile b = runProfile(timer, 800);
+  CHECK_EQUAL(800, b.shortest);
+  CHECK(b.totalTicks > a.totalTicks * 2 - 800 && b.totalTicks < a.totalTicks * 2 + 800);
+}
+
+TEST(reset_restarts_from_standstill) {
+  MotionPlanner planner(1000000UL);
+  planner.configure(2500, 10000);
+  planner.reset();
+  uint16_t first = planner.nextInterval(1000);
+  for (uint8_t i = 0; i < 50; i++) {
+    planner.nextInterval(1000);
+  }
+  CHECK(!planner.isStopped());
+  planner.reset();
+  CHECK(planner.isStopped());
+  CHECK_EQUAL(first, planner.nextInterval(1000));
+}
+
+TEST(slow_limits_clamp_to_16_bit_interval) {
+  // 10 кроків/с при 2 МГц - 200000 тіків, обмежується регістром порівняння
+  MotionPlanner planner(2000000UL);
+  planner.configure(10, 1);
+  Profile profile = runProfile(planner, 10);
+  CHECK_EQUAL(0xFFFF, profile.shortest);
+}
@@ -0,0 +1,119 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "stepper.h"
+#include "position_controller.h"
+
+// Модель столу: справжній кут - за імпульсами STEP і рівнем DIR (hal::stepperSteps()) плюс проковзування,
+// енкодер повертає його з 10-бітним квантуванням. Інверсію напрямку в меню вибирають так, щоб логічні
+// кроки крутили стіл у бік зростання кута енкодера: при inverted = true механіка обертає стіл
+// проти фізичного напрямку двигуна. Цикл повторює taskMotion(): грубий рух за позицією двигуна,
+// далі корекції регулятора через setPosition(position - correction) + move(correction)
+
+static bool plantInverted = false;
+static int32_t plantSlipSteps = 0;  // Втрачені кроки: стіл відстав від лічильника двигуна
+static unsigned long nowMs = 0;
+static uint32_t seed = 1;
+
+static uint32_t nextRandom() {
+  seed = seed * 1103515245UL + 12345UL;
+  return seed >> 16;
+}
+
+static int32_t wrapCdeg(int32_t cdeg) {
+  while (cdeg > 18000) cdeg -= 36000;
+  while (cdeg < -18000) cdeg += 36000;
+  return cdeg;
+}
+
+static uint16_t encoderCdeg() {
+  int32_t steps = (plantInverted ? -hal::stepperSteps() : hal::stepperSteps()) + plantSlipSteps;
+  steps %= STEPS_360;
+  if (steps < 0) steps += STEPS_360;
+  uint32_t code = (uint32_t)steps * 1024UL / STEPS_360;  // 10-бітний АЦП
+  return (uint16_t)(code * 36000UL / 1024UL);
+}
+
+static void runMove(Stepper& stepper) {
+  while (stepper.getRemaining() != 0) {
+    Stepper::timerIsr();
+  }
+  Stepper::timerIsr();
+}
+
+// Одне позиціювання: повертає кількість корекцій або -1, якщо регулятор не збігся
+static int16_t positionTo(Stepper& stepper, PositionController& controller, uint16_t targetCdeg) {
+  controller.begin(targetCdeg);
+  int32_t stepsNeeded = (int32_t)targetCdeg * STEPS_360 / 36000L - stepper.getPosition();
+  if (stepsNeeded > STEPS_360 / 2) stepsNeeded -= STEPS_360;
+  if (stepsNeeded < -STEPS_360 / 2) stepsNeeded += STEPS_360;
+  stepper.move(stepsNeeded);
+  runMove(stepper);
+
+  int16_t corrections = 0;
+  for (uint16_t pass = 0; pass < 200; pass++) {
+    nowMs += TASK_MOTION_PERIOD_MS * 10;
+    int32_t correction = controller.update(encoderCdeg(), stepper.getRemaining() == 0, nowMs);
+    if (controller.isSettled()) {
+      return corrections;
+    }
+    if (controller.hasFailed()) {
+      return -1;
+    }
+    if (correction != 0) {
+      stepper.setPosition(stepper.getPosition() - correction);
+      stepper.move(correction);
+      runMove(stepper);
+      corrections++;
+    }
+  }
+  return -1;
+}
+
+static void simulate(bool inverted) {
+  plantInverted = inverted;
+  plantSlipSteps = 0;
+  nowMs = 0;
+  seed = inverted ? 2 : 1;
+
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  stepper.begin();
+  stepper.setDirectionInvert(inverted);
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+  PositionController controller;
+
+  for (uint8_t i = 0; i < 40; i++) {
+    uint16_t target = nextRandom() % 36000;
+    // Перед рухом стіл проковзує на випадкову величину до ±CLOSED_LOOP_MAX_CORRECTION_STEPS
+    plantSlipSteps += (int32_t)(nextRandom() % (2 * CLOSED_LOOP_MAX_CORRECTION_STEPS + 1)) - CLOSED_LOOP_MAX_CORRECTION_STEPS;
+
+    int16_t corrections = positionTo(stepper, controller, target);
+    int32_t error = wrapCdeg((int32_t)encoderCdeg() - target);
+    if (corrections < 0 || error < -CLOSED_LOOP_TOLERANCE_CDEG || error > CLOSED_LOOP_TOLERANCE_CDEG) {
+      printf("  target %u: corrections %d, error %ld cdeg\n", target, corrections, (long)error);
+    }
+    CHECK(corrections >= 0);
+    CHECK(corrections <= 4);
+    CHECK(error >= -CLOSED_LOOP_TOLERANCE_CDEG && error <= CLOSED_LOOP_TOLERANCE_CDEG);
+  }
+}
+
+TEST(random_targets_converge) {
+  simulate(false);
+}
+
+TEST(random_targets_converge_with_inverted_direction) {
+  simulate(true);
+}
+
+TEST(correction_sign_follows_error) {
+  PositionController controller;
+  controller.begin(9000);
+  // Двигун зупинився, енкодер показує менше за ціль - корекція вперед
+  CHECK_EQUAL(0, controller.update(8000, true, 0));
+  int32_t correction = controller.update(8000, true, CLOSED_LOOP_SETTLE_MS);
+  CHECK(correction > 0);
+  controller.begin(9000);
+  controller.update(10000, true, 0);
+  CHECK(controller.update(10000, true, CLOSED_LOOP_SETTLE_MS) < 0);
+}
@@ -0,0 +1,129 @@
+#include "test.h"
+#include "hal.h"
+#include "profiler.h"
+
+// Збирається з -DPROFILER_ENABLED=1 (див. Makefile): у прошивці профілювання за замовчуванням вимкнене.
+// Стан Profiler статичний, тому кожен тест починає з reset()
+
+// Звіт dump() у рядок
+class CapturePrint : public Print {
+public:
+  CapturePrint() : _length(0) { _text[0] = '\0'; }
+  virtual size_t write(uint8_t c) {
+    if (_length < sizeof(_text) - 1) {
+      _text[_length++] = (char)c;
+      _text[_length] = '\0';
+    }
+    return 1;
+  }
+  using Print::write;
+  const char* text() const { return _text; }
+  // Рядок звіту секції разом з рядком гістограми (до наступної секції)
+  const char* section(const char* name) {
+    static char lines[256];
+    char prefix[16];
+    snprintf(prefix, sizeof(prefix), "\n%s ", name);
+    const char* start = strstr(_text, prefix);
+    if (!start) {
+      return "";
+    }
+    start++;
+    const char* end = strstr(start, "\r\n");
+    if (end && strncmp(end + 2, "  ", 2) == 0) {
+      end = strstr(end + 2, "\r\n");
+    }
+    size_t length = end ? (size_t)(end - start) : strlen(start);
+    if (length >= sizeof(lines)) {
+      length = sizeof(lines) - 1;
+    }
+    memcpy(lines, start, length);
+    lines[length] = '\0';
+    return lines;
+  }
+
+private:
+  char _text[2048];
+  size_t _length;
+};
+
+TEST(dump_shows_stats_and_power_of_two_buckets) {
+  Profiler::reset();
+  Profiler::record(PROFILE_UI, 3);
+  Profiler::record(PROFILE_UI, 3);
+  Profiler::record(PROFILE_UI, 100);
+  Profiler::record(PROFILE_UI, 20000);
+  Profiler::record(PROFILE_UI, 0);
+
+  CapturePrint out;
+  Profiler::dump(out);
+  CHECK(strncmp(out.text(), "section n min mean max [us]\r\n", 29) == 0);
+  // n min mean max; кошики: 0 мкс, 2-3, 64-127, 16384 і більше
+  CHECK_STRING("ui 5 0 4021 20000\r\n  <1:1  <4:2  <128:1  >=16384:1", out.section("ui"));
+  CHECK_STRING("loop 0", out.section("loop"));
+}
+
+TEST(bucket_edges) {
+  static const uint32_t values[] = { 1, 2, 4, 8191, 8192, 16383, 16384, 1000000 };
+  static const char* const expected[] = {
+    "<2:1", "<4:1", "<8:1", "<8192:1", "<16384:1", "<16384:1", ">=16384:1", ">=16384:1"
+  };
+  for (uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+    Profiler::reset();
+    Profiler::record(PROFILE_MOTION, values[i]);
+    CapturePrint out;
+    Profiler::dump(out);
+    CHECK(strstr(out.section("motion"), expected[i]) != nullptr);
+  }
+}
+
+TEST(long_sample_saturates_in_stats) {
+  Profiler::reset();
+  Profiler::record(PROFILE_PERSIST, 100000);
+  CapturePrint out;
+  Profiler::dump(out);
+  CHECK_STRING("persist 1 65535 65535 65535\r\n  >=16384:1", out.section("persist"));
+}
+
+TEST(counters_halve_instead_of_overflowing) {
+  Profiler::reset();
+  // 256 зразків в одному кошику: при переповненні всі кошики діляться навпіл
+  for (uint16_t i = 0; i < 256; i++) {
+    Profiler::record(PROFILE_INPUT, 3);
+  }
+  Profiler::record(PROFILE_INPUT, 100);
+  CapturePrint out;
+  Profiler::dump(out);
+  CHECK_STRING("input 257 3 3 100\r\n  <4:128  <128:1", out.section("input"));
+
+  // Лічильник і сума діляться разом - середнє зберігається
+  Profiler::reset();
+  for (uint32_t i = 0; i < 0x10000UL; i++) {
+    Profiler::record(PROFILE_SENSING, (i & 1) ? 30 : 10);
+  }
+  CapturePrint out2;
+  Profiler::dump(out2);
+  CHECK(strncmp(out2.section("sensing"), "sensing 32768 10 20 30", 22) == 0);
+}
+
+TEST(interval_between_marks) {
+  Profiler::reset();
+  PROFILE_INTERVAL(PROFILE_STEPPER_GAP);  // Перша позначка - тільки початок відліку
+  hal::advanceUs(250);
+  PROFILE_INTERVAL(PROFILE_STEPPER_GAP);
+  hal::advanceUs(50);
+  PROFILE_INTERVAL(PROFILE_STEPPER_GAP);
+  CapturePrint out;
+  Profiler::dump(out);
+  CHECK_STRING("step gap 2 50 150 250\r\n  <64:1  <256:1", out.section("step gap"));
+}
+
+TEST(scope_measures_block) {
+  Profiler::reset();
+  {
+    PROFILE_SCOPE(PROFILE_LOOP);
+    hal::advanceUs(700);
+  }
+  CapturePrint out;
+  Profiler::dump(out);
+  CHECK_STRING("loop 1 700 700 700\r\n  <1024:1", out.section("loop"));
+}
@@ -0,0 +1,52 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "memory.h"
+
+// Калібрування енкодера (кнопка обнулення утримується при ввімкненні): поки воно триває,
+// решта loop() не виконується, але кроки поза AVR формує stepper.update() - стіл має обійти коло
+
+void setup();
+void loop();
+
+static const unsigned long LOOP_US = 50;
+
+static uint16_t tableAdc(uint8_t pin) {
+  int32_t steps = hal::stepperSteps() % STEPS_360;
+  if (steps < 0) {
+    steps += STEPS_360;
+  }
+  return (uint16_t)((steps * 1023L + STEPS_360 / 2) / STEPS_360);
+}
+
+static void runFor(unsigned long ms) {
+  unsigned long end = micros() + ms * 1000UL;
+  while ((long)(end - micros()) > 0) {
+    loop();
+    hal::advanceUs(LOOP_US);
+  }
+}
+
+TEST(calibration_sweeps_full_turn_and_saves_table) {
+  hal::setAnalogSource(tableAdc);
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+  hal::setInput(ENCODER_ZERO_BUTTON_PIN, LOW);
+  setup();
+  hal::setInput(ENCODER_ZERO_BUTTON_PIN, HIGH);
+
+  runFor(1000);
+  CHECK_STRING("Calibrating...      ", hal::lcdRow(0));
+  CHECK(hal::stepperPulses() > 0);
+
+  runFor(ABS_ENC_CAL_POINTS * (ABS_ENC_CAL_SETTLE_MS + 500UL));
+  CHECK_EQUAL(STEPS_360, hal::stepperSteps());
+  CHECK_STRING("Menu:Ok Btn:Start   ", hal::lcdRow(3));
+
+  // Лінійний енкодер - поправки не більші за похибку квантування АЦП (пів молодшого розряду, ~18 сотих градуса)
+  Memory restored(MIN_POS, MAX_POS);
+  int16_t table[ABS_ENC_CAL_POINTS];
+  CHECK(restored.loadCalibration(table, ABS_ENC_CAL_POINTS));
+  for (uint8_t i = 0; i < ABS_ENC_CAL_POINTS; i++) {
+    CHECK(abs(table[i]) <= 18);
+  }
+}
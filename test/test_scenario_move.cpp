@@ -0,0 +1,95 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "memory.h"
+
+// Повний цикл роботи: кут задається в меню, стіл доїжджає до нього, позиція зберігається в EEPROM.
+// Стіл - модель: кут рахується з імпульсів STEP/DIR, абсолютний енкодер показує його через АЦП
+
+void setup();
+void loop();
+
+static const unsigned long LOOP_US = 50;  // Тривалість одного проходу loop() у моделі
+
+static uint16_t tableAdc(uint8_t pin) {
+  // Кут столу з кроків двигуна -> показ АЦП (0-1023 на 0-360°)
+  int32_t steps = hal::stepperSteps() % STEPS_360;
+  if (steps < 0) {
+    steps += STEPS_360;
+  }
+  return (uint16_t)((steps * 1023L + STEPS_360 / 2) / STEPS_360);
+}
+
+static void runFor(unsigned long ms) {
+  unsigned long end = micros() + ms * 1000UL;
+  while ((long)(end - micros()) > 0) {
+    loop();
+    hal::advanceUs(LOOP_US);
+  }
+}
+
+static void click(uint8_t pin) {
+  hal::setInput(pin, LOW);
+  runFor(80);
+  hal::setInput(pin, HIGH);
+  runFor(400);  // Обробка, оновлення екрану (LCD_UPDATE_MS) і відправлення на дисплей частинами
+}
+
+// Клацання енкодера: 4 переходи коду Грея між положеннями фіксації (обидва сигнали HIGH)
+static void turnEncoder(int8_t detents) {
+  static const uint8_t FORWARD[4] = { 0x02, 0x00, 0x01, 0x03 };  // (A << 1) | B
+  for (int8_t i = 0; i < abs(detents); i++) {
+    for (uint8_t k = 0; k < 4; k++) {
+      uint8_t state = FORWARD[(detents > 0) ? k : (2 - k) & 0x03];
+      hal::setInput(ENC_A, state & 0x02);
+      hal::setInput(ENC_B, state & 0x01);
+      runFor(2);
+    }
+    runFor(250);  // Повільно - без прискорення
+  }
+}
+
+TEST(set_angle_start_reach_target_and_save) {
+  hal::setAnalogSource(tableAdc);
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+  setup();
+  runFor(500);
+  CHECK_STRING("Target:   0^        ", hal::lcdRow(2));
+
+  // Меню -> Set Angle, розряд десятків, 9 клацань = 90°
+  click(ENC_BTN);
+  CHECK_STRING(">Set Angle          ", hal::lcdRow(1));
+  click(ENC_BTN);
+  click(DIGIT_MODE_BUTTON_PIN);
+  turnEncoder(9);
+  runFor(200);
+  CHECK_STRING("Target: 90^         ", hal::lcdRow(0));
+  click(ENC_BTN);
+  CHECK_STRING("Target:  90^        ", hal::lcdRow(2));
+  CHECK_EQUAL(0, hal::stepperPulses());
+
+  // Старт: стіл доїжджає до 90° (800 кроків) і двигун зупиняється сам
+  click(START_STOP_BUTTON_PIN);
+  CHECK(hal::getOutput(START_STOP_LED_PIN));
+  runFor(3000);
+  CHECK_EQUAL(STEPS_360 / 4, hal::stepperSteps());
+  CHECK(!hal::getOutput(START_STOP_LED_PIN));
+  CHECK(strncmp("Encoder: 90.0", hal::lcdRow(1), 13) == 0);  // 800 кроків -> АЦП 256 (90.08°), показ згладжується
+  CHECK_STRING("Menu:Ok Btn:Start   ", hal::lcdRow(3));
+
+  // Меню -> Save Position -> підтвердження
+  click(ENC_BTN);
+  turnEncoder(-1);
+  CHECK_STRING(">Save Position      ", hal::lcdRow(3));
+  click(ENC_BTN);
+  click(ENC_BTN);
+  CHECK_STRING("Position saved      ", hal::lcdRow(0));
+  runFor(1000);
+
+  // Записане читається новим екземпляром Memory - як після перезавантаження
+  Memory restored(MIN_POS, MAX_POS);
+  Settings settings;
+  restored.loadSettings(settings);
+  CHECK_EQUAL(STEPS_360 / 4, settings.position);
+  CHECK_EQUAL(0, settings.stepperZero);
+}
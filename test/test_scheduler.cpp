@@ -0,0 +1,150 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "scheduler.h"
+
+// Задачі тесту записують, хто і коли запускався, і "працюють" заданий час віртуального годинника
+
+static char order[32];
+static uint8_t orderLength;
+static unsigned long startTimes[32];
+static unsigned long workUs;
+
+static void record(char name) {
+  if (orderLength < sizeof(order) - 1) {
+    startTimes[orderLength] = micros();
+    order[orderLength++] = name;
+    order[orderLength] = '\0';
+  }
+  hal::advanceUs(workUs);
+}
+
+static void taskA() { record('A'); }
+static void taskB() { record('B'); }
+static void taskC() { record('C'); }
+
+static void resetRecord() {
+  orderLength = 0;
+  order[0] = '\0';
+  workUs = 0;
+}
+
+// Викликає run(), поки є що запускати, потім просуває час на 100 мкс
+static void runFor(Scheduler& scheduler, unsigned long us) {
+  unsigned long end = micros() + us;
+  while ((long)(end - micros()) > 0) {
+    while (scheduler.run()) {
+    }
+    hal::advanceUs(100);
+  }
+}
+
+TEST(add_task_until_full) {
+  Scheduler scheduler;
+  for (uint8_t i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+    CHECK_EQUAL(i, scheduler.addTask(taskA, 1, 0, 100));
+  }
+  CHECK_EQUAL(-1, scheduler.addTask(taskA, 1, 0, 100));
+  CHECK_EQUAL(SCHEDULER_MAX_TASKS, scheduler.getTaskCount());
+}
+
+TEST(one_task_per_run_by_priority) {
+  resetRecord();
+  Scheduler scheduler;
+  scheduler.addTask(taskC, 10, 2, 100);
+  scheduler.addTask(taskA, 10, 0, 100);
+  scheduler.addTask(taskB, 10, 1, 100);
+  scheduler.start();
+  CHECK(scheduler.run());
+  CHECK_STRING("A", order);
+  CHECK(scheduler.run());
+  CHECK(scheduler.run());
+  CHECK_STRING("ABC", order);
+  CHECK(!scheduler.run());  // Наступні такти - через 10 мс
+}
+
+TEST(equal_priority_runs_longest_waiting_first) {
+  resetRecord();
+  Scheduler scheduler;
+  scheduler.addTask(taskA, 10, 1, 100);
+  hal::advanceUs(3000);
+  scheduler.addTask(taskB, 10, 1, 100);  // Такт B на 3 мс пізніше
+  hal::advanceUs(20000);
+  CHECK(scheduler.run());
+  CHECK_STRING("A", order);
+}
+
+TEST(period_keeps_fixed_grid) {
+  // Такти відлічуються від попереднього такту: запізнення запуску не накопичується
+  resetRecord();
+  Scheduler scheduler;
+  scheduler.addTask(taskA, 10, 0, 1000);
+  scheduler.start();
+  workUs = 700;
+  runFor(scheduler, 50000);
+  CHECK_STRING("AAAAA", order);
+  for (uint8_t i = 0; i < orderLength; i++) {
+    CHECK(startTimes[i] >= i * 10000UL);
+    CHECK(startTimes[i] < i * 10000UL + 100);
+  }
+  CHECK_EQUAL(0, scheduler.getStats(0).missed);
+}
+
+TEST(high_priority_waits_at_most_one_run) {
+  resetRecord();
+  Scheduler scheduler;
+  scheduler.addTask(taskA, 1, 0, 300);
+  scheduler.addTask(taskB, 5, 1, 3000);
+  scheduler.start();
+  scheduler.run();  // A
+  workUs = 2500;
+  scheduler.run();  // B - довгий запуск
+  workUs = 0;
+  CHECK(scheduler.run());
+  CHECK_STRING("ABA", order);
+  // A чекав, поки завершиться B: запізнення - 2.5 мс - 1 мс такту
+  CHECK_EQUAL(1500, scheduler.getStats(0).maxLatenessUs);
+  // Такт на 2 мс ще не пропущено (до наступного менше періоду) - він запускається одразу
+  CHECK(scheduler.run());
+  CHECK_STRING("ABAA", order);
+  CHECK(!scheduler.run());
+  CHECK_EQUAL(0, scheduler.getStats(0).missed);
+}
+
+TEST(missed_ticks_are_counted_not_replayed) {
+  resetRecord();
+  Scheduler scheduler;
+  scheduler.addTask(taskA, 1, 0, 300);
+  scheduler.start();
+  scheduler.run();
+  hal::advanceUs(5500);  // loop() заблокований на 5.5 мс
+  // Такт на 1 мс запускається із запізненням, такти на 2-4 мс пропускаються,
+  // такт на 5 мс - поточний; серії наздоганяння немає
+  CHECK(scheduler.run());
+  CHECK(scheduler.run());
+  CHECK(!scheduler.run());
+  CHECK_EQUAL(3, scheduler.getStats(0).runs);
+  CHECK_EQUAL(3, scheduler.getStats(0).missed);
+  hal::advanceUs(500);
+  CHECK(scheduler.run());  // Далі - за сіткою тактів (6 мс)
+  CHECK(!scheduler.run());
+}
+
+TEST(overrun_over_budget) {
+  resetRecord();
+  Scheduler scheduler;
+  scheduler.addTask(taskA, 10, 0, 300);
+  scheduler.start();
+  workUs = 300;
+  scheduler.run();
+  CHECK_EQUAL(0, scheduler.getStats(0).overruns);
+  hal::advanceUs(10000);
+  workUs = 301;
+  scheduler.run();
+  CHECK_EQUAL(1, scheduler.getStats(0).overruns);
+  CHECK_EQUAL(301, scheduler.getStats(0).maxDurationUs);
+
+  scheduler.resetStats();
+  CHECK_EQUAL(0, scheduler.getStats(0).runs);
+  CHECK_EQUAL(0, scheduler.getStats(0).overruns);
+}
@@ -0,0 +1,219 @@
+#include "test.h"
+#include "hal.h"
+#include "config.h"
+#include "stepper.h"
+
+// Обробник Timer1 (Stepper::timerIsr): на ПК переривання не спрацьовує, тест викликає його сам -
+// один виклик = один збіг OCR1A. Регістри таймера поза AVR не записуються, перевіряється логіка кроків
+
+static uint32_t runTimer(uint32_t limit) {
+  uint32_t calls = 0;
+  uint32_t pulses = hal::stepperPulses();
+  while (calls < limit) {
+    Stepper::timerIsr();
+    calls++;
+    if (hal::stepperPulses() == pulses) {
+      break;  // Таймер зупинився - крок не зроблено
+    }
+    pulses = hal::stepperPulses();
+  }
+  return calls;
+}
+
+TEST(timer_steps_exact_count_and_stops) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  stepper.begin();
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+
+  stepper.move(100);
+  runTimer(1000);
+  CHECK_EQUAL(100, hal::stepperPulses());
+  CHECK_EQUAL(100, hal::stepperSteps());
+  CHECK_EQUAL(100, stepper.getPosition());
+  CHECK_EQUAL(0, stepper.getRemaining());
+  CHECK(!hal::getOutput(STEP_PIN));  // Імпульс завершено
+
+  // Після зупинки переривання кроків не робить
+  Stepper::timerIsr();
+  CHECK_EQUAL(100, hal::stepperPulses());
+}
+
+TEST(timer_reverses_direction) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  stepper.begin();
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+
+  stepper.move(30);
+  runTimer(1000);
+  stepper.move(-50);
+  runTimer(1000);
+  CHECK_EQUAL(80, hal::stepperPulses());
+  CHECK_EQUAL(-20, hal::stepperSteps());
+  CHECK_EQUAL(STEPS_360 - 20, stepper.getPosition());  // Позиція по колу 0..STEPS_360-1
+}
+
+TEST(move_during_motion_extends_remaining) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  stepper.begin();
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+
+  stepper.move(40);
+  for (uint8_t i = 0; i < 10; i++) {
+    Stepper::timerIsr();
+  }
+  CHECK_EQUAL(30, stepper.getRemaining());
+  stepper.move(-10);
+  runTimer(1000);
+  CHECK_EQUAL(30, hal::stepperSteps());
+  CHECK_EQUAL(30, stepper.getPosition());
+}
+
+TEST(direction_invert_flips_dir_pin_only) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  stepper.begin();
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+
+  stepper.setDirectionInvert(true);
+  stepper.move(25);
+  runTimer(1000);
+  CHECK_EQUAL(-25, hal::stepperSteps());  // Фізично - назад
+  CHECK_EQUAL(25, stepper.getPosition());  // Логічно - вперед
+}
+
+TEST(enable_pin_is_active_low) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  stepper.begin();
+  CHECK(!hal::getOutput(ENABLE_PIN));
+  stepper.setEnabled(false);
+  CHECK(hal::getOutput(ENABLE_PIN));
+  CHECK(!stepper.isEnabled());
+}
+
+// Інтервали між кроками одного руху (без інтервалу після останнього кроку).
+// Поза AVR планувальник рахує в мікросекундах: крейсерський інтервал = 1000000 / STEPPER_MAX_SPEED_SPS
+static const uint16_t CRUISE_INTERVAL = 1000000UL / STEPPER_MAX_SPEED_SPS;
+
+static uint16_t recordRamp(Stepper& stepper, int32_t steps, uint16_t* intervals, uint16_t capacity) {
+  uint16_t count = 0;
+  stepper.move(steps);
+  while (stepper.getRemaining() != 0 && count < capacity) {
+    Stepper::timerIsr();
+    if (stepper.getRemaining() != 0) {
+      intervals[count++] = stepper.getStepInterval();
+    }
+  }
+  Stepper::timerIsr();  // Зупинка таймера
+  return count;
+}
+
+// Розгін монотонно скорочує інтервал, гальмування монотонно подовжує, інтервал не коротший за крейсерський,
+// а гальмування дзеркальне до розгону (з точністю до округлень рекурентної формули)
+static void checkRamp(const uint16_t* intervals, uint16_t count, bool expectCruise) {
+  uint16_t peak = 0;
+  while (peak + 1 < count && intervals[peak + 1] <= intervals[peak]) {
+    peak++;
+  }
+  uint16_t tail = peak;
+  while (tail + 1 < count && intervals[tail + 1] >= intervals[tail]) {
+    tail++;
+  }
+  CHECK_EQUAL(count - 1, tail);  // Після мінімуму інтервал лише зростає
+  for (uint16_t i = 0; i < count; i++) {
+    CHECK(intervals[i] >= CRUISE_INTERVAL);
+  }
+  if (expectCruise) {
+    CHECK_EQUAL(CRUISE_INTERVAL, intervals[peak]);
+    CHECK_EQUAL(CRUISE_INTERVAL, intervals[count / 2]);
+  } else {
+    CHECK(intervals[peak] > CRUISE_INTERVAL);
+  }
+  for (uint16_t i = 0; i < count / 2; i++) {
+    int32_t up = intervals[i];
+    int32_t down = intervals[count - 1 - i];
+    int32_t diff = up > down ? up - down : down - up;
+    if (diff * 100 > up) {  // Понад 1%
+      printf("  ramp asymmetric at %u/%u: %ld vs %ld\n", i, count, (long)up, (long)down);
+      CHECK(false);
+      break;
+    }
+  }
+}
+
+TEST(ramp_single_step_has_no_interval) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  stepper.begin();
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+
+  uint16_t intervals[4];
+  CHECK_EQUAL(0, recordRamp(stepper, 1, intervals, 4));
+  CHECK_EQUAL(1, hal::stepperPulses());
+}
+
+TEST(ramp_short_move_is_triangular) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  stepper.begin();
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+
+  // 160 кроків коротші за розгін до 2500 кроків/с (v²/2a = 312 кроків) - крейсерської ділянки немає
+  static uint16_t intervals[200];
+  uint16_t count = recordRamp(stepper, 160, intervals, 200);
+  CHECK_EQUAL(159, count);
+  checkRamp(intervals, count, false);
+  CHECK_EQUAL(160, hal::stepperPulses());
+}
+
+TEST(ramp_long_move_reaches_cruise) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  stepper.begin();
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+
+  static uint16_t intervals[1700];
+  uint16_t count = recordRamp(stepper, 1600, intervals, 1700);
+  CHECK_EQUAL(1599, count);
+  checkRamp(intervals, count, true);
+  // Крейсерська ділянка: 1600 кроків мінус розгін і гальмування по ~312 кроків
+  uint16_t cruise = 0;
+  for (uint16_t i = 0; i < count; i++) {
+    if (intervals[i] == CRUISE_INTERVAL) cruise++;
+  }
+  CHECK(cruise > 900 && cruise < 1000);
+  CHECK_EQUAL(1600, hal::stepperPulses());
+}
+
+TEST(reversal_at_speed_brakes_before_dir_flips) {
+  Stepper stepper(STEP_PIN, DIR_PIN, ENABLE_PIN);
+  stepper.begin();
+  hal::traceStepper(STEP_PIN, DIR_PIN);
+
+  // Розгін до крейсерської швидкості
+  stepper.move(1000);
+  for (uint16_t i = 0; i < 500; i++) {
+    Stepper::timerIsr();
+  }
+  CHECK_EQUAL(CRUISE_INTERVAL, stepper.getStepInterval());
+
+  // Нова ціль на 1000 кроків позаду поточної позиції
+  stepper.move(-1500);
+  CHECK_EQUAL(-1000, stepper.getRemaining());
+
+  // Поки DIR не змінився, інтервал лише зростає; розворот - не швидше за другий інтервал розгону з місця
+  bool dir = hal::getOutput(DIR_PIN);
+  uint16_t previous = stepper.getStepInterval();
+  uint32_t braking = 0;
+  while (hal::getOutput(DIR_PIN) == dir && stepper.getRemaining() != 0) {
+    Stepper::timerIsr();
+    if (hal::getOutput(DIR_PIN) != dir) break;
+    CHECK(stepper.getStepInterval() >= previous);
+    previous = stepper.getStepInterval();
+    braking++;
+  }
+  CHECK(hal::getOutput(DIR_PIN) != dir);
+  CHECK(previous > 5000);
+  CHECK(braking > 250 && braking < 320);  // v²/2a = 312 кроків
+
+  runTimer(5000);
+  CHECK_EQUAL(-500, hal::stepperSteps());
+  CHECK_EQUAL(STEPS_360 - 500, stepper.getPosition());
+  CHECK_EQUAL(0, stepper.getRemaining());
+  CHECK_EQUAL(500 + braking + (braking + 1000), hal::stepperPulses());  // Гальмівний шлях пройдено двічі
+}